@@ -6,93 +6,151 @@ namespace algorithms {
 
 using namespace handlegraph;
 
-std::vector<handle_t> cycle_breaking_sort(const graph_t& graph) {
-    std::vector<std::vector<uint64_t> > rank(graph.get_node_count());
-    uint64_t i = 0;
-    uint64_t j = 0;
-    dfs(graph,
-        [&](const handle_t& handle) { },
-        [&](const handle_t& handle) {
-            rank[number_bool_packing::unpack_number(handle)] = { j, i++, number_bool_packing::unpack_number(handle) };
-        },
-        [&](const handle_t& handle) { return false; },
-        [&](void) { return false; },
-        [&](const edge_t& e) { },
-        [&](const edge_t& e) { ++j; },
-        [&](const edge_t& e) { },
-        [&](const edge_t& e) { },
-        { },
-        { });
-    //std::cerr << "order size " << order.size() << " vs " <<  graph.node_size() << std::endl;
-    std::sort(rank.begin(), rank.end());
-    std::vector<handle_t> order; order.reserve(rank.size());
-    for (auto& g : rank) {
-        order.push_back(number_bool_packing::pack(g[2], false));
-    }
-    return order;
-    //return order;
-    /*
-    graph_t tmp = graph;
-    tmp.apply_ordering(order);
-    return topological_order(&tmp);
-    */
-    /*
-    // remove any edge whose from has a higher index than its to
-    graph_t broken = graph;
-    graph.for_each_edge([&](const edge_t& e) {
-            if (graph.get_id(e.first) > graph.get_id(e.second)) {
-                broken.destroy_edge(e);
-                broken.create_edge(graph.get_is_reverse(e.second)?graph.flip(e.second):e.second,
-                                   graph.get_is_reverse(e.first)?graph.flip(e.first):e.first);
-            } else
-            if (graph.get_is_reverse(e.first)
-                       || graph.get_is_reverse(e.second)) {
-                // force it into the graph as if it's not inverting
-                broken.destroy_edge(e);
-                broken.create_edge(graph.get_is_reverse(e.first)?graph.flip(e.first):e.first,
-                                   graph.get_is_reverse(e.second)?graph.flip(e.second):e.second);
+// the search state of each oriented handle, by as_integer(handle)
+enum cycle_breaking_state_t : uint8_t { PRE = 0, CURR, POST, TAKEN };
+
+// depth first search over both strands of the given nodes, in their order, following only edges to
+// nodes in scope, then append the nodes to the order by when the last of their strands finished
+// this mirrors the order of the generic dfs: a node's key was {tree edges so far, strands finished so far}
+// when its last strand finished, and both parts only grow as the search goes, so the finishing order is the key order
+template<typename InScope>
+static void cycle_breaking_order(const HandleGraph& graph,
+                                 const std::vector<uint64_t>& nodes,
+                                 const InScope& in_scope,
+                                 std::vector<uint8_t>& state,
+                                 std::vector<handle_t>& order) {
+    // the strands in the order they finish, as node ranks
+    std::vector<uint64_t> finished;
+    finished.reserve(nodes.size() * 2);
+    struct frame_t {
+        handle_t handle;
+        // the range of the targets stack holding the handle's edges
+        uint64_t begin;
+        uint64_t next;
+        uint64_t end;
+    };
+    std::vector<frame_t> frames;
+    std::vector<handle_t> targets;
+    auto discover = [&](const handle_t& handle) {
+        state[as_integer(handle)] = CURR;
+        uint64_t begin = targets.size();
+        graph.follow_edges(handle, false, [&](const handle_t& next) {
+                if (in_scope(number_bool_packing::unpack_number(next))) {
+                    targets.push_back(next);
+                }
+            });
+        frames.push_back({handle, begin, begin, targets.size()});
+    };
+    for (auto& rank : nodes) {
+        for (bool is_rev : { false, true }) {
+            handle_t root = number_bool_packing::pack(rank, is_rev);
+            if (state[as_integer(root)] != PRE) continue;
+            discover(root);
+            while (!frames.empty()) {
+                frame_t& frame = frames.back();
+                if (frame.next == frame.end) {
+                    state[as_integer(frame.handle)] = POST;
+                    finished.push_back(number_bool_packing::unpack_number(frame.handle));
+                    targets.resize(frame.begin);
+                    frames.pop_back();
+                    continue;
+                }
+                handle_t next = targets[frame.next++];
+                if (state[as_integer(next)] == PRE) {
+                    discover(next);
+                }
             }
-            return true;
+        }
+    }
+    // keep the last time each node finished, marking the nodes we've taken on their forward strand
+    uint64_t begin = order.size();
+    for (auto f = finished.rbegin(); f != finished.rend(); ++f) {
+        uint8_t& s = state[*f << 1];
+        if (s != TAKEN) {
+            s = TAKEN;
+            order.push_back(number_bool_packing::pack(*f, false));
+        }
+    }
+    std::reverse(order.begin() + begin, order.end());
+}
+
+std::vector<handle_t> cycle_breaking_sort(const HandleGraph& graph, uint64_t num_threads) {
+    std::vector<uint64_t> nodes;
+    nodes.reserve(graph.get_node_count());
+    uint64_t max_rank = 0;
+    graph.for_each_handle([&](const handle_t& handle) {
+            nodes.push_back(number_bool_packing::unpack_number(handle));
+            max_rank = std::max(max_rank, nodes.back());
         });
-    return topological_order(&broken);
-    */
-    /*
-    // TODO... dagify, then obtain order, project back to previous graph
-    graph_t tmp;
-    ska::flat_hash_map<handlegraph::nid_t, handlegraph::nid_t> dag_to_base = dagify(&broken, &tmp, 0);
-    std::vector<handlegraph::nid_t> pre_order;
-    tmp.for_each_handle([&](const handle_t& handle) {
-            pre_order.push_back(tmp.get_id(handle));
+    std::vector<handle_t> order;
+    order.reserve(nodes.size());
+    if (nodes.empty()) {
+        return order;
+    }
+    std::vector<uint8_t> state(2 * (max_rank + 1), PRE);
+    if (num_threads <= 1) {
+        cycle_breaking_order(graph, nodes, [](const uint64_t& rank) { return true; }, state, order);
+        return order;
+    }
+
+    // split the nodes by strongly connected component, keeping them in rank order within each
+    std::vector<uint64_t> component = strongly_connected_component_labels(graph);
+    uint64_t component_count = 0;
+    for (auto& rank : nodes) {
+        component_count = std::max(component_count, component[rank] + 1);
+    }
+    std::vector<std::vector<uint64_t>> members(component_count);
+    for (uint64_t rank = 0; rank < component.size(); ++rank) {
+        if (component[rank] < component_count) {
+            members[component[rank]].push_back(rank);
+        }
+    }
+    // order the components along the condensation of the graph, keeping the orientations of
+    // the edges between them, which the topological sort knows how to follow
+    // we store each edge as (component << 1 | is_rev) in one canonical orientation, so that both strands merge
+    std::vector<std::pair<uint64_t, uint64_t>> condensed_edges;
+    graph.for_each_edge([&](const edge_t& edge) {
+            uint64_t from = component[number_bool_packing::unpack_number(edge.first)] << 1 | graph.get_is_reverse(edge.first);
+            uint64_t to = component[number_bool_packing::unpack_number(edge.second)] << 1 | graph.get_is_reverse(edge.second);
+            if (from >> 1 != to >> 1) {
+                condensed_edges.push_back(std::min(std::make_pair(from, to), std::make_pair(to ^ 1, from ^ 1)));
+            }
         });
-    std::vector<handle_t> dag_order = lazy_topological_order(&tmp);
-    ska::flat_hash_map<handlegraph::nid_t, std::vector<handlegraph::nid_t> > base_to_dag;
-    //std::vector<handle_t> final_order;
-    // take the order given by the first instance of the mapping to a particular handle in the base graph
-    for (auto& handle : dag_order) {
-        //tmp.for_each_handle([&](const handle_t& handle) {
-        handlegraph::nid_t dag_id = tmp.get_id(handle);
-        auto& base_id = dag_to_base[dag_id];
-        //if (base_to_dag.find(base_id) == base_to_dag.end()) {
-        base_to_dag[base_id].push_back(dag_id);
-        //final_order.push_back(graph.get_handle(base_id));
+    std::sort(condensed_edges.begin(), condensed_edges.end());
+    condensed_edges.erase(std::unique(condensed_edges.begin(), condensed_edges.end()), condensed_edges.end());
+    topology_graph_t condensation;
+    for (uint64_t c = 0; c < members.size(); ++c) {
+        condensation.add_node(c + 1, nullptr, members[c].size());
     }
-        //});
-    std::vector<std::pair<handlegraph::nid_t, handlegraph::nid_t> > x;
-    graph.for_each_handle([&](const handle_t& handle) {
-            handlegraph::nid_t base_id = graph.get_id(handle);
-            //auto& dag_id = base_to_dag[base_id].front();
-            auto& dag_v = base_to_dag[base_id];
-            //std::sort(dag_v.begin(), dag_v.end());
-            x.push_back(make_pair(dag_v.back(), base_id));
-            //final_order.push_back(graph.get_handle(base_id));
+    for (auto& edge : condensed_edges) {
+        condensation.add_edge((edge.first >> 1) + 1, edge.first & 1, (edge.second >> 1) + 1, edge.second & 1);
+    }
+    condensation.index();
+    std::vector<handle_t> component_order = topological_order(&condensation);
+    // each component is searched on its own, in parallel, biggest first
+    std::vector<uint64_t> by_size(members.size());
+    for (uint64_t c = 0; c < members.size(); ++c) by_size[c] = c;
+    std::sort(by_size.begin(), by_size.end(), [&](const uint64_t& a, const uint64_t& b) {
+            return members[a].size() > members[b].size() || (members[a].size() == members[b].size() && a < b);
         });
-    std::sort(x.begin(), x.end());
-    std::vector<handle_t> final_order;
-    for (auto p : x) {
-        final_order.push_back(graph.get_handle(p.second));
+    std::vector<std::vector<handle_t>> component_orders(members.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t k = 0; k < by_size.size(); ++k) {
+        uint64_t c = by_size[k];
+        if (members[c].size() == 1) {
+            component_orders[c].push_back(number_bool_packing::pack(members[c].front(), false));
+            continue;
+        }
+        // components don't share nodes, so the searches touch disjoint parts of the state
+        cycle_breaking_order(graph, members[c],
+                             [&](const uint64_t& rank) { return component[rank] == c; },
+                             state, component_orders[c]);
     }
-    return final_order;
-    */
+    for (auto& handle : component_order) {
+        auto& members_order = component_orders[condensation.get_id(handle) - 1];
+        order.insert(order.end(), members_order.begin(), members_order.end());
+    }
+    return order;
 }
 
 }
@@ -3,8 +3,13 @@
 #include <handlegraph/handle_graph.hpp>
 #include <handlegraph/util.hpp>
 #include <vector>
+#include <algorithm>
+#include <limits>
+#include <omp.h>
 #include "odgi.hpp"
+#include "topology_graph.hpp"
 #include "topological_sort.hpp"
+#include "strongly_connected_components.hpp"
 #include "eades_algorithm.hpp"
 #include "dagify.hpp"
 
@@ -14,7 +19,10 @@ namespace algorithms {
 
 using namespace handlegraph;
 
-std::vector<handle_t> cycle_breaking_sort(const graph_t& graph);
+// handles must pack dense node ranks, as in graph_t
+// with more than one thread, the graph is split into its strongly connected components,
+// which are ordered along their condensation and broken apart in parallel
+std::vector<handle_t> cycle_breaking_sort(const HandleGraph& graph, uint64_t num_threads = 1);
 
 }
 
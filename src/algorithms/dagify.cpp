@@ -159,6 +159,10 @@ ska::flat_hash_map<handlegraph::nid_t, handlegraph::nid_t> dagify(const HandleGr
             
         // init the tracker that we use for the bail-out condition
         int64_t min_relaxed_dist = -1;
+        // and the copy at which it last grew: it grows at least once every layout.size() copies
+        // unless a cycle of zero-length nodes crosses copies for free, which no copies can preserve
+        int64_t grown_dist = -1;
+        size_t grown_copy = 0;
             
         // add copies until the minimum distance to the new copy is longer than the distance we're
         // trying to preserven
@@ -265,6 +269,13 @@ ska::flat_hash_map<handlegraph::nid_t, handlegraph::nid_t> dagify(const HandleGr
             // initialize the DP structures for the next iteration
             distances = move(next_distances);
             next_distances.assign(distances.size(), numeric_limits<int64_t>::max());
+            
+            if (min_relaxed_dist > grown_dist) {
+                grown_dist = min_relaxed_dist;
+                grown_copy = copy_num;
+            } else if (copy_num - grown_copy >= layout.size()) {
+                break;
+            }
         }
     }
         
@@ -3,38 +3,36 @@
 namespace odgi {
 namespace algorithms {
 
-std::vector<handle_t> dagify_sort(const HandleGraph& base, MutableHandleGraph& split, MutableHandleGraph& into) {
-    auto split_to_orig = algorithms::split_strands(&base, &split);
-    auto dagified_to_split = algorithms::dagify(&split, &into, 1);
-    auto dagified_to_orig = [&](handlegraph::nid_t id) {
-        return split_to_orig[dagified_to_split[id]];
-    };
+std::vector<handle_t> dagify_sort(const HandleGraph& base) {
+    split_strand_graph_t split(&base);
+    dagified_graph_t into(&split, 1);
     auto order = algorithms::topological_order(&into, true, false);
-    // find the mean position in the order for each original handle
-    ska::flat_hash_map<handlegraph::nid_t, std::pair<uint64_t, uint64_t>> pos_accum;
+    // find the mean position in the order for each original handle, counting only its forward strand
+    uint64_t rank_count = split.get_node_count() / 2;
+    std::vector<uint64_t> pos_sum(rank_count, 0);
+    std::vector<uint64_t> pos_count(rank_count, 0);
     for (uint64_t i = 0; i < order.size(); ++i) {
-        auto& handle = order[i];
-        auto e = dagified_to_orig(into.get_id(handle));
-        if (e.second) continue;
-        handlegraph::nid_t id = e.first;
-        pos_accum[id].first += i;
-        ++pos_accum[id].second;
+        uint64_t split_rank = number_bool_packing::unpack_number(into.get_underlying_handle(order[i]));
+        if (split_rank & 1) continue;
+        pos_sum[split_rank >> 1] += i;
+        ++pos_count[split_rank >> 1];
     }
-    // sort the original ids by their average position in the dagified sort
-    std::vector<std::pair<handlegraph::nid_t, double>> avg_pos; avg_pos.reserve(pos_accum.size());
-    for (auto& e : pos_accum) {
-        avg_pos.push_back(std::make_pair(e.first, (double)e.second.first/(double)e.second.second));
+    order.clear();
+    order.shrink_to_fit();
+    // sort the original nodes by their average position in the dagified sort
+    std::vector<std::pair<double, uint64_t>> avg_pos;
+    avg_pos.reserve(base.get_node_count());
+    for (uint64_t rank = 0; rank < rank_count; ++rank) {
+        if (pos_count[rank]) {
+            avg_pos.push_back(std::make_pair((double)pos_sum[rank] / (double)pos_count[rank], rank));
+        }
     }
-    std::sort(avg_pos.begin(), avg_pos.end(),
-              [](const std::pair<handlegraph::nid_t, double>& a,
-                 const std::pair<handlegraph::nid_t, double>& b) {
-                  return a.second < b.second;
-              });
+    std::sort(avg_pos.begin(), avg_pos.end());
     std::vector<handle_t> translated_order;
+    translated_order.reserve(avg_pos.size());
     for (auto& e : avg_pos) {
-        translated_order.push_back(base.get_handle(e.first));
+        translated_order.push_back(number_bool_packing::pack(e.second, false));
     }
-    //std::reverse(translated_order.begin(), translated_order.end());
     assert(translated_order.size() == base.get_node_count());
     return translated_order;
 }
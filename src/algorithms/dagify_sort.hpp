@@ -1,11 +1,13 @@
 #pragma once
 
 #include <handlegraph/handle_graph.hpp>
-#include <handlegraph/mutable_handle_graph.hpp>
-#include "hash_map.hpp"
+#include <handlegraph/util.hpp>
+#include <vector>
+#include <algorithm>
+#include <cassert>
 #include "topological_sort.hpp"
-#include "split_strands.hpp"
-#include "dagify.hpp"
+#include "split_strand_graph.hpp"
+#include "dagified_graph.hpp"
 
 namespace odgi {
 
@@ -13,7 +15,9 @@ namespace algorithms {
 
 using namespace handlegraph;
 
-std::vector<handle_t> dagify_sort(const HandleGraph& base, MutableHandleGraph& split, MutableHandleGraph& into);
+// order the nodes by their mean position in a topological sort of the dagified, strand split graph
+// both are views over the base graph, whose handles must pack dense node ranks, as in graph_t
+std::vector<handle_t> dagify_sort(const HandleGraph& base);
 
 }
 }
@@ -0,0 +1,408 @@
+#include "draw_layout.hpp"
+#include <cerrno>
+#include <unordered_set>
+#include <sys/stat.h>
+#include <omp.h>
+#include "lodepng.h"
+
+namespace odgi {
+namespace algorithms {
+
+// we buffer the SVG and write it out in blocks of about this many bytes
+static const uint64_t svg_buffer_size = 1 << 20;
+// points of a chain within this many pixels of the line we're drawing through them are merged into it
+static const double svg_line_tolerance = 0.5;
+
+// the undirected adjacency of the nodes by id - 1, with repeated edges merged and self loops dropped
+// each list is sorted, so that we can find the slot of an edge from either end
+static void layout_adjacency(const HandleGraph& graph, uint64_t n,
+                             std::vector<uint64_t>& offsets, std::vector<uint64_t>& neighbors) {
+    std::vector<std::pair<uint64_t, uint64_t>> pairs;
+    graph.for_each_edge([&](const edge_t& e) {
+            uint64_t a = graph.get_id(e.first) - 1;
+            uint64_t b = graph.get_id(e.second) - 1;
+            if (a == b) return;
+            pairs.push_back(std::make_pair(a, b));
+            pairs.push_back(std::make_pair(b, a));
+        });
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    offsets.assign(n + 1, 0);
+    neighbors.resize(pairs.size());
+    for (uint64_t k = 0; k < pairs.size(); ++k) {
+        ++offsets[pairs[k].first + 1];
+        neighbors[k] = pairs[k].second;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+}
+
+void draw_svg(std::ostream& out, const std::vector<double>& X, const HandleGraph& graph, double scale) {
+    double border = 10.0;
+    double min_x = 0;
+    double min_y = 0;
+    double max_x = 0;
+    double max_y = 0;
+    // determine boundaries
+    uint64_t n = graph.get_node_count();
+    for (uint64_t i = 0; i < n; ++i) {
+        double x = X[i*2]*scale;
+        double y = X[i*2+1]*scale;
+        if (x < min_x) min_x = x;
+        if (x > max_x) max_x = x;
+        if (y < min_y) min_y = y;
+        if (y > max_y) max_y = y;
+    }
+    double width = max_x - min_x;
+    double height = max_y - min_y;
+
+    out << "<svg width=\"" << width + border << "\" height=\"" << height + border << "\" "
+        << "viewBox=\"" << min_x - border/2<< " " << min_y - border/2 << " " << width + border << " " << height + border << "\" xmlns=\"http://www.w3.org/2000/svg\">"
+        << "<style type=\"text/css\">"
+        << "line{stroke:black;stroke-width:1.0;stroke-opacity:1.0;stroke-linecap:round;}"
+        << "polyline{fill:none;stroke:black;stroke-width:1.0;stroke-opacity:1.0;stroke-linecap:round;stroke-linejoin:round;}"
+        << "circle{fill:black;stroke:none;}"
+        << "</style>"
+        << "\n";
+
+    std::string buffer;
+    buffer.reserve(svg_buffer_size + 1024);
+    char number[64];
+    auto append_number = [&](const double& v) {
+        int length = std::snprintf(number, sizeof(number), "%.2f", v);
+        buffer.append(number, length);
+    };
+    auto append_attribute = [&](const char* name, const double& v) {
+        buffer += ' ';
+        buffer += name;
+        buffer += "=\"";
+        append_number(v);
+        buffer += '"';
+    };
+
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> neighbors;
+    layout_adjacency(graph, n, offsets, neighbors);
+    auto degree = [&](uint64_t i) { return offsets[i + 1] - offsets[i]; };
+    auto slot_of = [&](uint64_t u, uint64_t v) {
+        return std::lower_bound(neighbors.begin() + offsets[u], neighbors.begin() + offsets[u + 1], v) - neighbors.begin();
+    };
+    std::vector<bool> used(neighbors.size(), false);
+    std::vector<uint64_t> chain;
+    std::vector<std::pair<double, double>> kept;
+
+    // the pixels we've put a dot on, as (x << 32 | y) of their grid coordinates
+    std::unordered_set<uint64_t> dotted;
+
+    // keep the points of the chain needed to draw it within the tolerance of every point
+    // the directions from the last kept point that pass within the tolerance of every point we've dropped since
+    // form a cone, which narrows with each point, and a point outside it means we have to keep the one before it
+    // points within the tolerance of the last kept point fit any direction, and we also keep the one before a point
+    // that comes back nearer than one we've dropped, so that the dropped ones lie along the segment we draw
+    auto simplify_chain = [&](void) {
+        auto point = [&](uint64_t k) {
+            return std::make_pair(X[2 * chain[k]] * scale, X[2 * chain[k] + 1] * scale);
+        };
+        kept.clear();
+        kept.push_back(point(0));
+        std::pair<double, double> prev = kept.back();
+        bool bounded = false;
+        double base = 0, lo = 0, hi = 0;
+        double reach = 0;
+        uint64_t k = 1;
+        while (k < chain.size()) {
+            std::pair<double, double> p = point(k);
+            double dx = p.first - kept.back().first;
+            double dy = p.second - kept.back().second;
+            double d = std::sqrt(dx * dx + dy * dy);
+            if (d < reach) {
+                // start again from the previous point, and look at this one from there
+                kept.push_back(prev);
+                bounded = false;
+                reach = 0;
+                continue;
+            }
+            if (d > svg_line_tolerance) {
+                double theta = std::atan2(dy, dx);
+                if (!bounded) {
+                    base = theta;
+                    lo = -M_PI;
+                    hi = M_PI;
+                    bounded = true;
+                }
+                double delta = std::remainder(theta - base, 2 * M_PI);
+                if (delta < lo || delta > hi) {
+                    kept.push_back(prev);
+                    bounded = false;
+                    reach = 0;
+                    continue;
+                }
+                double half_width = std::asin(svg_line_tolerance / d);
+                lo = std::max(lo, delta - half_width);
+                hi = std::min(hi, delta + half_width);
+            }
+            reach = d;
+            prev = p;
+            ++k;
+        }
+        if (kept.back() != prev) {
+            kept.push_back(prev);
+        }
+    };
+
+    // a chain that fits within a pixel becomes a dot on each pixel it touches, and we draw each pixel only once,
+    // so that regions dense with small chains cost at most one dot per pixel rather than vanishing
+    auto write_dots = [&](void) {
+        for (auto& i : chain) {
+            double px = std::floor(X[2 * i] * scale);
+            double py = std::floor(X[2 * i + 1] * scale);
+            uint64_t key = (uint64_t)(uint32_t)(int32_t)px << 32 | (uint32_t)(int32_t)py;
+            if (!dotted.insert(key).second) continue;
+            buffer += "<circle";
+            append_attribute("cx", px + 0.5);
+            append_attribute("cy", py + 0.5);
+            append_attribute("r", 0.5);
+            buffer += "/>\n";
+        }
+    };
+
+    auto write_chain = [&](void) {
+        double min_cx = X[2 * chain[0]] * scale, max_cx = min_cx;
+        double min_cy = X[2 * chain[0] + 1] * scale, max_cy = min_cy;
+        for (auto& i : chain) {
+            min_cx = std::min(min_cx, X[2 * i] * scale);
+            max_cx = std::max(max_cx, X[2 * i] * scale);
+            min_cy = std::min(min_cy, X[2 * i + 1] * scale);
+            max_cy = std::max(max_cy, X[2 * i + 1] * scale);
+        }
+        if (max_cx - min_cx < 1 && max_cy - min_cy < 1) {
+            write_dots();
+        } else {
+            simplify_chain();
+            if (kept.size() == 2) {
+                buffer += "<line";
+                append_attribute("x1", kept[0].first);
+                append_attribute("x2", kept[1].first);
+                append_attribute("y1", kept[0].second);
+                append_attribute("y2", kept[1].second);
+                buffer += "/>\n";
+            } else {
+                buffer += "<polyline points=\"";
+                for (uint64_t k = 0; k < kept.size(); ++k) {
+                    if (k) buffer += ' ';
+                    append_number(kept[k].first);
+                    buffer += ',';
+                    append_number(kept[k].second);
+                }
+                buffer += "\"/>\n";
+            }
+        }
+        if (buffer.size() >= svg_buffer_size) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    };
+
+    // walk from u along slot k through the nodes with two neighbors, until we reach a node with another
+    // number of neighbors or come back around a cycle
+    auto walk_chain = [&](uint64_t u, uint64_t k) {
+        chain.clear();
+        chain.push_back(u);
+        while (true) {
+            uint64_t v = neighbors[k];
+            used[k] = true;
+            used[slot_of(v, u)] = true;
+            chain.push_back(v);
+            if (degree(v) != 2) break;
+            uint64_t next = used[offsets[v]] ? offsets[v] + 1 : offsets[v];
+            if (used[next]) break;
+            u = v;
+            k = next;
+        }
+        write_chain();
+    };
+    for (uint64_t u = 0; u < n; ++u) {
+        if (degree(u) == 2) continue;
+        for (uint64_t k = offsets[u]; k < offsets[u + 1]; ++k) {
+            if (!used[k]) walk_chain(u, k);
+        }
+    }
+    // what's left are cycles of nodes with two neighbors
+    for (uint64_t u = 0; u < n; ++u) {
+        for (uint64_t k = offsets[u]; k < offsets[u + 1]; ++k) {
+            if (!used[k]) walk_chain(u, k);
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    out << "</svg>" << std::endl;
+}
+
+static void make_directory(const std::string& path) {
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[odgi::algorithms::draw_png_tiles] error: could not create directory " << path << std::endl;
+        exit(1);
+    }
+}
+
+// clip the segment to the square [lo, hi] in both axes, returning false if it misses it
+static bool clip_segment(double& x0, double& y0, double& x1, double& y1, const double& lo, const double& hi) {
+    double dx = x1 - x0;
+    double dy = y1 - y0;
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {x0 - lo, hi - x0, y0 - lo, hi - y0};
+    double t0 = 0;
+    double t1 = 1;
+    for (int k = 0; k < 4; ++k) {
+        if (p[k] == 0) {
+            if (q[k] < 0) return false;
+        } else {
+            double t = q[k] / p[k];
+            if (p[k] < 0) {
+                if (t > t1) return false;
+                t0 = std::max(t0, t);
+            } else {
+                if (t < t0) return false;
+                t1 = std::min(t1, t);
+            }
+        }
+    }
+    x1 = x0 + t1 * dx;
+    y1 = y0 + t1 * dy;
+    x0 = x0 + t0 * dx;
+    y0 = y0 + t0 * dy;
+    return true;
+}
+
+void draw_png_tiles(const std::string& dir, const std::vector<double>& X, const HandleGraph& graph,
+                    uint64_t levels, uint64_t tile_size, uint64_t num_threads) {
+    std::vector<uint64_t> nodes;
+    double min_x = std::numeric_limits<double>::max();
+    double min_y = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double max_y = std::numeric_limits<double>::lowest();
+    graph.for_each_handle([&](const handle_t& h) {
+            uint64_t i = graph.get_id(h) - 1;
+            nodes.push_back(i);
+            min_x = std::min(min_x, X[2 * i]);
+            min_y = std::min(min_y, X[2 * i + 1]);
+            max_x = std::max(max_x, X[2 * i]);
+            max_y = std::max(max_y, X[2 * i + 1]);
+        });
+    if (nodes.empty()) return;
+    std::vector<std::pair<uint64_t, uint64_t>> edges;
+    graph.for_each_edge([&](const edge_t& e) {
+            edges.push_back(std::make_pair(graph.get_id(e.first) - 1, graph.get_id(e.second) - 1));
+        });
+    // a little wider than the layout, so that its far edges fall within the last tiles and pixels
+    double side = std::max(std::max(max_x - min_x, max_y - min_y), 1e-9) * (1 + 1e-9);
+    make_directory(dir);
+    for (uint64_t z = 0; z < levels; ++z) {
+        uint64_t tiles = (uint64_t)1 << z;
+        double tile_span = side / tiles;
+        auto tile_of = [&](const double& v) {
+            return (int64_t)std::min((double)(tiles - 1), std::max(0.0, std::floor(v)));
+        };
+        // find the edges crossing each tile by walking the tiles along each edge, one tile border at a time
+        std::vector<std::vector<uint64_t>> tile_edges(tiles * tiles);
+        std::vector<std::vector<uint64_t>> tile_nodes(tiles * tiles);
+        for (uint64_t e = 0; e < edges.size(); ++e) {
+            double x0 = (X[2 * edges[e].first] - min_x) / tile_span;
+            double y0 = (X[2 * edges[e].first + 1] - min_y) / tile_span;
+            double x1 = (X[2 * edges[e].second] - min_x) / tile_span;
+            double y1 = (X[2 * edges[e].second + 1] - min_y) / tile_span;
+            int64_t tx = tile_of(x0);
+            int64_t ty = tile_of(y0);
+            int64_t moves_x = std::abs(tile_of(x1) - tx);
+            int64_t moves_y = std::abs(tile_of(y1) - ty);
+            double dx = x1 - x0;
+            double dy = y1 - y0;
+            int64_t step_x = dx > 0 ? 1 : -1;
+            int64_t step_y = dy > 0 ? 1 : -1;
+            double inf = std::numeric_limits<double>::infinity();
+            double next_x = dx != 0 ? (step_x > 0 ? tx + 1 - x0 : x0 - tx) / std::abs(dx) : inf;
+            double next_y = dy != 0 ? (step_y > 0 ? ty + 1 - y0 : y0 - ty) / std::abs(dy) : inf;
+            tile_edges[ty * tiles + tx].push_back(e);
+            while (moves_x || moves_y) {
+                if (moves_x && (!moves_y || next_x < next_y)) {
+                    tx += step_x;
+                    next_x += 1 / std::abs(dx);
+                    --moves_x;
+                } else {
+                    ty += step_y;
+                    next_y += 1 / std::abs(dy);
+                    --moves_y;
+                }
+                tile_edges[ty * tiles + tx].push_back(e);
+            }
+        }
+        for (auto& i : nodes) {
+            tile_nodes[tile_of((X[2 * i + 1] - min_y) / tile_span) * tiles
+                       + tile_of((X[2 * i] - min_x) / tile_span)].push_back(i);
+        }
+        std::vector<uint64_t> drawn;
+        std::string level_dir = dir + "/" + std::to_string(z);
+        make_directory(level_dir);
+        std::vector<bool> column_made(tiles, false);
+        for (uint64_t t = 0; t < tiles * tiles; ++t) {
+            if (tile_edges[t].empty() && tile_nodes[t].empty()) continue;
+            drawn.push_back(t);
+            if (!column_made[t % tiles]) {
+                make_directory(level_dir + "/" + std::to_string(t % tiles));
+                column_made[t % tiles] = true;
+            }
+        }
+        double pixels_per_unit = tile_size / tile_span;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+        for (uint64_t k = 0; k < drawn.size(); ++k) {
+            uint64_t t = drawn[k];
+            uint64_t tx = t % tiles;
+            uint64_t ty = t / tiles;
+            double origin_x = min_x + tx * tile_span;
+            double origin_y = min_y + ty * tile_span;
+            std::vector<unsigned char> image(tile_size * tile_size * 4, 255);
+            // edges that only touch a corner of the tile may leave it blank
+            bool blank = true;
+            auto add_point = [&](const double& x, const double& y) {
+                int64_t px = std::floor(x);
+                int64_t py = std::floor(y);
+                if (px < 0 || py < 0 || px >= (int64_t)tile_size || py >= (int64_t)tile_size) return;
+                blank = false;
+                uint64_t p = 4 * (tile_size * py + px);
+                image[p + 0] = 0;
+                image[p + 1] = 0;
+                image[p + 2] = 0;
+                image[p + 3] = 255;
+            };
+            for (auto& e : tile_edges[t]) {
+                double x0 = (X[2 * edges[e].first] - origin_x) * pixels_per_unit;
+                double y0 = (X[2 * edges[e].first + 1] - origin_y) * pixels_per_unit;
+                double x1 = (X[2 * edges[e].second] - origin_x) * pixels_per_unit;
+                double y1 = (X[2 * edges[e].second + 1] - origin_y) * pixels_per_unit;
+                if (!clip_segment(x0, y0, x1, y1, 0, tile_size)) continue;
+                // one point per pixel along the longer axis
+                uint64_t steps = std::ceil(std::max(std::abs(x1 - x0), std::abs(y1 - y0)));
+                for (uint64_t s = 0; s <= steps; ++s) {
+                    double f = steps ? (double)s / steps : 0;
+                    add_point(x0 + f * (x1 - x0), y0 + f * (y1 - y0));
+                }
+            }
+            for (auto& i : tile_nodes[t]) {
+                add_point((X[2 * i] - origin_x) * pixels_per_unit, (X[2 * i + 1] - origin_y) * pixels_per_unit);
+            }
+            if (blank) continue;
+            std::string path = level_dir + "/" + std::to_string(tx) + "/" + std::to_string(ty) + ".png";
+            std::vector<unsigned char> png;
+            unsigned error = lodepng::encode(png, image, tile_size, tile_size);
+            if (!error) error = lodepng::save_file(png, path);
+            if (error) {
+#pragma omp critical (cerr)
+                std::cerr << "[odgi::algorithms::draw_png_tiles] error: " << lodepng_error_text(error)
+                          << " writing " << path << std::endl;
+            }
+        }
+    }
+}
+
+}
+}
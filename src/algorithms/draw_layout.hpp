@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * \file draw_layout.hpp
+ *
+ * Render 2D layouts of the graph as SVG or as a pyramid of PNG tiles
+ */
+
+#include <handlegraph/handle_graph.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+
+namespace odgi {
+namespace algorithms {
+
+using namespace handlegraph;
+
+/// Write the layout X (x and y interleaved, indexed by id - 1) as SVG, scaling it by scale to give pixels.
+/// Edges along chains of nodes with two neighbors are merged into polylines that pass within half a pixel of
+/// every node of the chain, and chains that fit within a pixel become a dot on each pixel they touch, drawn once
+/// however many chains touch it, so the size of the SVG follows the detail visible at this scale rather than
+/// the size of the graph.
+void draw_svg(std::ostream& out, const std::vector<double>& X, const HandleGraph& graph, double scale);
+
+/// Write the layout X as a pyramid of PNG tiles of tile_size pixels to dir/z/x/y.png, for zoom levels z
+/// from 0 to levels - 1, where level z covers the square around the layout with 2^z tiles per side.
+/// Tiles with nothing in them aren't written. The tiles of each level are drawn in parallel.
+void draw_png_tiles(const std::string& dir, const std::vector<double>& X, const HandleGraph& graph,
+                    uint64_t levels, uint64_t tile_size, uint64_t num_threads);
+
+}
+}
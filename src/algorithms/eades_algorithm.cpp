@@ -23,9 +23,14 @@ using namespace handlegraph;
         }
         */
         vector<handle_t> canonical_orientation;
-        graph->for_each_handle([&canonical_orientation](const handle_t& h) {
+        uint64_t max_rank = 0;
+        graph->for_each_handle([&](const handle_t& h) {
                 canonical_orientation.push_back(h);
+                max_rank = max(max_rank, (uint64_t)number_bool_packing::unpack_number(h));
             });
+        if (canonical_orientation.empty()) {
+            return canonical_orientation;
+        }
 
 #ifdef debug_eades
         cerr << "got canonical orientation:" << endl;
@@ -34,16 +39,22 @@ using namespace handlegraph;
         }
 #endif
 
-        // maps handles to records of ((in-degree, out-degree), bucket position)
-        unordered_map<handle_t, pair<pair<int64_t, int64_t>, list<handle_t>::iterator>> degree_info;
+        auto rank_of = [](const handle_t& h) { return (uint64_t)number_bool_packing::unpack_number(h); };
+        
+        // the (in-degree, out-degree) of each node by rank, and which of its orientations is in a
+        // delta bucket, if any: 0 for none, 1 + is_reverse otherwise
+        vector<int64_t> in_degrees(max_rank + 1, 0);
+        vector<int64_t> out_degrees(max_rank + 1, 0);
+        vector<uint8_t> bucketed(max_rank + 1, 0);
+        auto in_bucket = [&](const handle_t& h) {
+            return bucketed[rank_of(h)] == 1 + graph->get_is_reverse(h);
+        };
         
         // buckets based on delta(u) among non-source, non-sink nodes (see paper)
         // buckets are numbered -n + 2, -n + 3, ... , n - 3, n - 2
         auto assign_bucket = [&](const int64_t& in_degree, const int64_t& out_degree) {
             return out_degree - in_degree + int64_t(canonical_orientation.size()) - 2;
         };
-        map<int64_t, list<handle_t>> delta_buckets; //(canonical_orientation.size() > 1 ? 2 * canonical_orientation.size() - 3 : 0);
-        
         
         vector<handle_t> sources;
         vector<handle_t> sinks;
@@ -52,40 +63,102 @@ using namespace handlegraph;
             // compute in- and out-degree
             int64_t in_degree = graph->get_degree(handle, true);
             int64_t out_degree = graph->get_degree(handle, false);
+            uint64_t rank = rank_of(handle);
+            in_degrees[rank] = in_degree;
+            out_degrees[rank] = out_degree;
             
             if (in_degree == 0) {
                 // source
                 sources.emplace_back(handle);
-#ifdef debug_eades
-                cerr << "assign " << graph->get_id(handle) << (graph->get_is_reverse(handle) ? "-" : "+") << " to sources" << endl;
-#endif
             }
             else if (out_degree == 0) {
                 // sink
                 sinks.emplace_back(handle);
-#ifdef debug_eades
-                cerr << "assign " << graph->get_id(handle) << (graph->get_is_reverse(handle) ? "-" : "+") << " to sinks" << endl;
-#endif
             }
             else {
                 // non-source, non-sink
-                auto& bucket = delta_buckets[assign_bucket(in_degree, out_degree)];
-                bucket.emplace_front(handle);
-                degree_info[handle] = make_pair(make_pair(in_degree, out_degree), bucket.begin());
+                bucketed[rank] = 1 + graph->get_is_reverse(handle);
+            }
+        }
+        
+        // a node only moves up by losing in-edges and down by losing out-edges, and leaves the buckets
+        // when either degree reaches 0, so its buckets lie between these bounds
+        int64_t min_bucket = numeric_limits<int64_t>::max();
+        int64_t max_bucket = numeric_limits<int64_t>::min();
+        for (const handle_t& handle : canonical_orientation) {
+            if (in_bucket(handle)) {
+                uint64_t rank = rank_of(handle);
+                min_bucket = min(min_bucket, assign_bucket(in_degrees[rank], 1));
+                max_bucket = max(max_bucket, assign_bucket(1, out_degrees[rank]));
+            }
+        }
+        
+        // the buckets are doubly linked lists threaded through arrays indexed by rank, which
+        // we add to at the front and take from at the back
+        const uint64_t nil = numeric_limits<uint64_t>::max();
+        uint64_t bucket_count = min_bucket <= max_bucket ? max_bucket - min_bucket + 1 : 0;
+        vector<uint64_t> bucket_front(bucket_count, nil);
+        vector<uint64_t> bucket_back(bucket_count, nil);
+        vector<uint64_t> prev_in_bucket(max_rank + 1, nil);
+        vector<uint64_t> next_in_bucket(max_rank + 1, nil);
+        auto bucket_empty = [&](const int64_t& bucket_num) {
+            return bucket_num < min_bucket || bucket_num > max_bucket
+                || bucket_front[bucket_num - min_bucket] == nil;
+        };
+        auto push_front = [&](const int64_t& bucket_num, const uint64_t& rank) {
+            uint64_t& front = bucket_front[bucket_num - min_bucket];
+            prev_in_bucket[rank] = nil;
+            next_in_bucket[rank] = front;
+            if (front != nil) {
+                prev_in_bucket[front] = rank;
+            } else {
+                bucket_back[bucket_num - min_bucket] = rank;
+            }
+            front = rank;
+        };
+        auto unlink = [&](const int64_t& bucket_num, const uint64_t& rank) {
+            uint64_t prev = prev_in_bucket[rank];
+            uint64_t next = next_in_bucket[rank];
+            if (prev != nil) {
+                next_in_bucket[prev] = next;
+            } else {
+                bucket_front[bucket_num - min_bucket] = next;
+            }
+            if (next != nil) {
+                prev_in_bucket[next] = prev;
+            } else {
+                bucket_back[bucket_num - min_bucket] = prev;
+            }
+        };
+        
+        // fill the buckets in the order of the handles, counting the distinct buckets used
+        int64_t distinct_buckets = 0;
+        for (const handle_t& handle : canonical_orientation) {
+            if (in_bucket(handle)) {
+                uint64_t rank = rank_of(handle);
+                int64_t bucket_num = assign_bucket(in_degrees[rank], out_degrees[rank]);
+                if (bucket_empty(bucket_num)) {
+                    ++distinct_buckets;
+                }
+                push_front(bucket_num, rank);
 #ifdef debug_eades
-                cerr << "assign " << graph->get_id(handle) << (graph->get_is_reverse(handle) ? "-" : "+") << " to delta bucket " << assign_bucket(in_degree, out_degree) << endl;
+                cerr << "assign " << graph->get_id(handle) << (graph->get_is_reverse(handle) ? "-" : "+") << " to delta bucket " << bucket_num << endl;
 #endif
             }
         }
         
         // identify the highest non-empty bucket
-        int64_t max_delta_bucket = delta_buckets.size() - 1;
+        // nb: this starts from the number of buckets in use rather than the highest of them, and is
+        // only raised when a node moves up, so it can miss higher buckets; we keep it that way, as it
+        // decides the layout, but track a true upper bound on the buckets in use to fall back on
+        int64_t max_delta_bucket = distinct_buckets - 1;
         while (max_delta_bucket >= 0) {
-            if (!delta_buckets[max_delta_bucket].empty()) {
+            if (!bucket_empty(max_delta_bucket)) {
                 break;
             }
             max_delta_bucket--;
         }
+        int64_t highest_bucket = max_bucket;
         
         // init the layout to fill
         vector<handle_t> layout(canonical_orientation.size());
@@ -95,96 +168,61 @@ using namespace handlegraph;
         int64_t next_right_idx = layout.size() - 1;
         
         // update data structures to remove an edge into a node
-        function<void(const handle_t&)> remove_inward_edge = [&](const handle_t& next) {
-            auto iter = degree_info.find(next);
-            if (iter != degree_info.end()) {
+        auto remove_inward_edge = [&](const handle_t& next) {
+            if (in_bucket(next)) {
                 // this node is in a delta bucket
                 
                 // remove it from the current bucket
-                auto& degrees = iter->second.first;
-                int64_t current_bucket_num = assign_bucket(degrees.first, degrees.second);
-                auto& bucket = delta_buckets[current_bucket_num];
-                bucket.erase(iter->second.second);
+                uint64_t rank = rank_of(next);
+                int64_t current_bucket_num = assign_bucket(in_degrees[rank], out_degrees[rank]);
+                unlink(current_bucket_num, rank);
                 
                 // update the degrees to remove the inward edge
-                degrees.first--;
-                if (degrees.first == 0) {
+                in_degrees[rank]--;
+                if (in_degrees[rank] == 0) {
                     // this is now a source
-                    degree_info.erase(next);
+                    bucketed[rank] = 0;
                     sources.push_back(next);
                 }
                 else {
                     // this moves up one bucket
                     current_bucket_num++;
-                    auto& new_bucket = delta_buckets[current_bucket_num];
-                    new_bucket.emplace_front(next);
-                    iter->second.second = new_bucket.begin();
+                    push_front(current_bucket_num, rank);
                     
                     // if necessary, identify this as the new highest delta bucket
                     max_delta_bucket = max(max_delta_bucket, current_bucket_num);
+                    highest_bucket = max(highest_bucket, current_bucket_num);
                 }
             }
         };
         
         // update data structures to remove an edge out of a node
-        function<void(const handle_t&)> remove_outward_edge = [&](const handle_t& prev) {
-            auto iter = degree_info.find(prev);
-            if (iter != degree_info.end()) {
+        auto remove_outward_edge = [&](const handle_t& prev) {
+            if (in_bucket(prev)) {
                 // this node is in a delta bucket
                 
                 // remove it from the current bucket
-                auto& degrees = iter->second.first;
-                int64_t current_bucket_num = assign_bucket(degrees.first, degrees.second);
-                auto& bucket = delta_buckets[current_bucket_num];
-                bucket.erase(iter->second.second);
+                uint64_t rank = rank_of(prev);
+                int64_t current_bucket_num = assign_bucket(in_degrees[rank], out_degrees[rank]);
+                unlink(current_bucket_num, rank);
                 
                 // update the degrees to remove the outward edge
-                degrees.second--;
-                if (degrees.second == 0) {
+                out_degrees[rank]--;
+                if (out_degrees[rank] == 0) {
                     // this is now a sink
-                    degree_info.erase(prev);
+                    bucketed[rank] = 0;
                     sinks.push_back(prev);
                 }
                 else {
                     // this moves down one bucket
                     current_bucket_num--;
-                    auto& new_bucket = delta_buckets[current_bucket_num];
-                    new_bucket.emplace_front(prev);
-                    iter->second.second = new_bucket.begin();
+                    push_front(current_bucket_num, rank);
                 }
             }
         };
         
         while (next_left_idx <= next_right_idx) {
             
-#ifdef debug_eades
-            cerr << "status of layout:" << endl;
-            for (size_t i = 0; i < layout.size(); i++) {
-                if (i >= next_left_idx || i <= next_right_idx) {
-                    cerr << "\t." << endl;
-                }
-                else {
-                    cerr << "\t" << graph->get_id(layout[i]) << (graph->get_is_reverse(layout[i]) ? "-" : "+") << endl;
-                }
-            }
-            cerr << "status of sources:" << endl;
-            for (handle_t h : sources) {
-                cerr << "\t" << graph->get_id(h) << (graph->get_is_reverse(h) ? "-" : "+") << endl;
-            }
-            cerr << "status of sinks:" << endl;
-            for (handle_t h : sinks) {
-                cerr << "\t" << graph->get_id(h) << (graph->get_is_reverse(h) ? "-" : "+") << endl;
-            }
-            cerr << "status of delta buckets:" << endl;
-            for (int64_t i = -layout.size() + 3; i < int(layout.size()) - 3; i++) {
-                cerr << "\t" << i << " ";
-                for (handle_t h : delta_buckets[i + layout.size() - 3]) {
-                    cerr << "\t" << graph->get_id(h) << (graph->get_is_reverse(h) ? "-" : "+") << endl;
-                }
-                cerr << endl;
-            }
-#endif
-            
             if (!sources.empty()) {
                 // add a source to the layout
                 handle_t source = sources.back();
@@ -216,16 +254,24 @@ using namespace handlegraph;
                 graph->follow_edges(sink, true, remove_outward_edge);
             }
             else {
+                if (bucket_empty(max_delta_bucket)) {
+                    // we lost track of the buckets in use, so we look for the highest from the top
+                    while (bucket_empty(highest_bucket)) {
+                        highest_bucket--;
+                    }
+                    max_delta_bucket = highest_bucket;
+                }
+                
                 // remove a node in the highest delta bucket from the graph
-                auto& bucket = delta_buckets[max_delta_bucket];
-                handle_t next = bucket.back();
+                uint64_t rank = bucket_back[max_delta_bucket - min_bucket];
+                handle_t next = number_bool_packing::pack(rank, bucketed[rank] == 2);
                 
 #ifdef debug_eades
                 cerr << "adding node " << graph->get_id(next) << (graph->get_is_reverse(next) ? "-" : "+") << " from delta bucket " << max_delta_bucket << endl;
 #endif
                 
-                if (bucket.size()) bucket.pop_back();
-                degree_info.erase(next);
+                unlink(max_delta_bucket, rank);
+                bucketed[rank] = 0;
                 
                 // add it to the layout
                 layout[next_left_idx] = next;
@@ -237,7 +283,7 @@ using namespace handlegraph;
             
             // move the max bucket lower if it has been emptied
             while (max_delta_bucket >= 0) {
-                if (!delta_buckets[max_delta_bucket].empty()) {
+                if (!bucket_empty(max_delta_bucket)) {
                     break;
                 }
                 max_delta_bucket--;
@@ -8,12 +8,12 @@
  */
 
 #include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
 #include "is_single_stranded.hpp"
 
 #include <vector>
-#include <list>
-#include <map>
-#include <unordered_map>
+#include <limits>
+#include <algorithm>
 
 namespace odgi {
 namespace algorithms {
@@ -24,7 +24,8 @@ using namespace handlegraph;
     /// Returns a layout of handles that has a small number of edges that point backward
     /// along the layout (i.e. feedback arcs). Only valid for graphs that have a single
     /// stranded orientation. Consider checking this property with
-    /// algorithms::single_stranded_orientation.
+    /// algorithms::single_stranded_orientation. Handles must pack dense node ranks,
+    /// as in graph_t, which index the degree records and the delta buckets.
     vector<handle_t> eades_algorithm(const HandleGraph* graph);
 
 }
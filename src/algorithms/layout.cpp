@@ -0,0 +1,96 @@
+#include "layout.hpp"
+
+namespace odgi {
+namespace algorithms {
+
+static const char layout_magic[8] = {'o', 'd', 'g', 'i', 'l', 'a', 'y', 't'};
+static const uint64_t layout_version = 1;
+
+layout_t::layout_t(const HandleGraph& graph, const std::vector<double>& X) {
+    if (graph.get_node_count() == 0) {
+        return;
+    }
+    min_id = graph.min_node_id();
+    coords.assign(2 * (graph.max_node_id() - min_id + 1), std::numeric_limits<double>::quiet_NaN());
+    graph.for_each_handle([&](const handle_t& handle) {
+            nid_t id = graph.get_id(handle);
+            coords[2 * (id - min_id)] = X[2 * (id - 1)];
+            coords[2 * (id - min_id) + 1] = X[2 * (id - 1) + 1];
+        });
+}
+
+layout_t layout_t::compacted(const std::vector<nid_t>& ids) const {
+    layout_t result;
+    result.coords.assign(2 * ids.size(), std::numeric_limits<double>::quiet_NaN());
+    for (uint64_t k = 0; k < ids.size(); ++k) {
+        if (has(ids[k])) {
+            result.coords[2 * k] = x(ids[k]);
+            result.coords[2 * k + 1] = y(ids[k]);
+        }
+    }
+    return result;
+}
+
+layout_t layout_t::expanded(const std::vector<nid_t>& ids) const {
+    layout_t result;
+    if (ids.empty()) {
+        return result;
+    }
+    result.min_id = ids.front();
+    result.coords.assign(2 * (ids.back() - ids.front() + 1), std::numeric_limits<double>::quiet_NaN());
+    for (uint64_t k = 0; k < ids.size(); ++k) {
+        if (has(k + 1)) {
+            result.coords[2 * (ids[k] - result.min_id)] = x(k + 1);
+            result.coords[2 * (ids[k] - result.min_id) + 1] = y(k + 1);
+        }
+    }
+    return result;
+}
+
+void layout_t::serialize(std::ostream& out) const {
+    uint64_t id_count = coords.size() / 2;
+    out.write(layout_magic, sizeof(layout_magic));
+    out.write((const char*)&layout_version, sizeof(layout_version));
+    out.write((const char*)&min_id, sizeof(min_id));
+    out.write((const char*)&id_count, sizeof(id_count));
+    out.write((const char*)coords.data(), coords.size() * sizeof(double));
+}
+
+void layout_t::load(std::istream& in) {
+    char magic[sizeof(layout_magic)];
+    uint64_t version = 0;
+    uint64_t id_count = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    if (!in || !std::equal(magic, magic + sizeof(magic), layout_magic)) {
+        std::cerr << "[odgi::algorithms::layout] error: input is not an odgi layout" << std::endl;
+        exit(1);
+    }
+    if (version != layout_version) {
+        std::cerr << "[odgi::algorithms::layout] error: layout has format version " << version
+                  << ", but we can only read version " << layout_version << std::endl;
+        exit(1);
+    }
+    in.read((char*)&min_id, sizeof(min_id));
+    in.read((char*)&id_count, sizeof(id_count));
+    // the count comes from the file, so we only allocate for coordinates we've read, a block at a time,
+    // and a truncated or corrupt file fails with an error rather than a huge allocation
+    if (id_count > std::numeric_limits<uint64_t>::max() / 2) {
+        std::cerr << "[odgi::algorithms::layout] error: layout claims " << id_count << " ids" << std::endl;
+        exit(1);
+    }
+    coords.clear();
+    const uint64_t block = 1 << 20;
+    while (in && coords.size() < 2 * id_count) {
+        uint64_t begin = coords.size();
+        coords.resize(begin + std::min(block, 2 * id_count - begin));
+        in.read((char*)(coords.data() + begin), (coords.size() - begin) * sizeof(double));
+    }
+    if (!in) {
+        std::cerr << "[odgi::algorithms::layout] error: layout is truncated" << std::endl;
+        exit(1);
+    }
+}
+
+}
+}
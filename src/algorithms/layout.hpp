@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * \file layout.hpp
+ *
+ * 2D layouts of the nodes of a graph, which we can save to and load from a binary file
+ */
+
+#include <handlegraph/handle_graph.hpp>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <iostream>
+
+namespace odgi {
+namespace algorithms {
+
+using namespace handlegraph;
+
+/// The x and y coordinates of the nodes of a graph, keyed by node id.
+/// Ids without a position, such as those of nodes added to the graph after we made the layout, have NaN coordinates.
+/// The file holds a magic string and a format version, the first id and the number of ids it covers,
+/// then x and y of each id from the first one as doubles in the byte order of the machine that wrote it.
+struct layout_t {
+    nid_t min_id = 1;
+    // x and y of each id from min_id, interleaved
+    std::vector<double> coords;
+
+    layout_t(void) = default;
+    /// take the layout from X, with x and y interleaved and indexed by id - 1, as sgd_layout gives it
+    layout_t(const HandleGraph& graph, const std::vector<double>& X);
+
+    bool has(const nid_t& id) const {
+        return id >= min_id && (uint64_t)(id - min_id) < coords.size() / 2 && !std::isnan(coords[2 * (id - min_id)]);
+    }
+    double x(const nid_t& id) const { return coords[2 * (id - min_id)]; }
+    double y(const nid_t& id) const { return coords[2 * (id - min_id) + 1]; }
+
+    /// the layout of the given ids, which must be increasing, renumbered 1..n in their order,
+    /// as apply_ordering(order, true) renumbers a graph when the order follows its ids
+    layout_t compacted(const std::vector<nid_t>& ids) const;
+    /// the inverse of compacted, taking ids 1..n back to the given ids
+    layout_t expanded(const std::vector<nid_t>& ids) const;
+
+    void serialize(std::ostream& out) const;
+    /// load a layout written by serialize, exiting with an error if the input isn't one
+    void load(std::istream& in);
+};
+
+}
+}
@@ -1,20 +1,14 @@
 #include "linear_sgd.hpp"
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace odgi {
 namespace algorithms {
 
-std::vector<double> linear_sgd(const PathHandleGraph& graph,
-                               const uint64_t& bandwidth,
-                               const double& sampling_rate,
-                               const bool& use_paths,
-                               const uint64_t& t_max,
-                               const double& eps,
-                               const double& delta,
-                               const uint64_t& nthreads) {
-    using namespace std::chrono_literals; // for timing stuff
-     // our positions in 1D
+// seed the positions with the graph order
+static std::vector<std::atomic<double>> initial_positions(const HandleGraph& graph) {
     std::vector<std::atomic<double>> X(graph.get_node_count());
-    // seed them with the graph order
     uint64_t len = 0;
     graph.for_each_handle(
         [&X,&graph,&len](const handle_t& handle) {
@@ -22,29 +16,97 @@ std::vector<double> linear_sgd(const PathHandleGraph& graph,
             X[number_bool_packing::unpack_number(handle)].store(len);
             len += graph.get_length(handle);
         });
-    // run banded BFSs in the graph to build our terms
-    std::vector<sgd_term_t> terms;
-    if (use_paths) {
-        terms = linear_sgd_path_search(graph, bandwidth, sampling_rate);
-    } else {
-        terms = linear_sgd_search(graph, bandwidth, sampling_rate);
+    return X;
+}
+
+double sgd_batch_moves_scalar(sgd_batch_t& batch, const double& eta, uint64_t begin) {
+    double Delta_max = 0;
+    for (uint64_t k = begin; k < batch.size; ++k) {
+        double mu = std::min(eta * batch.w[k], 1.0);
+        double dx = batch.x_i[k] - batch.x_j[k];
+        if (dx == 0) {
+            dx = 1e-9; // avoid nan
+        }
+        double mag = std::abs(dx);
+        double Delta = mu * (mag-batch.d[k]) / 2;
+        Delta_max = std::max(Delta_max, std::abs(Delta));
+        batch.r_x[k] = Delta / mag * dx;
     }
-    // locks for each term
-    std::vector<std::mutex> term_mutexes(terms.size());
-    // get our schedule
-    std::vector<double> etas = linear_sgd_schedule(terms, t_max, eps);
-    // iterate through step sizes
-    /*
-    for (auto &t : terms) {
-        std::cerr << "considering " << graph.get_id(t.i) << " and " << graph.get_id(t.j) << " w = " << t.w << " d = " << t.d << std::endl;
+    return Delta_max;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ODGI_SGD_AVX2
+// the same computation, four terms at a time
+// in 1D, Delta / |dx| * dx is Delta with the sign of dx, so we need neither a division nor a square root
+__attribute__((target("avx2")))
+double sgd_batch_moves_avx2(sgd_batch_t& batch, const double& eta) {
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d tiny = _mm256_set1_pd(1e-9);
+    const __m256d eta_v = _mm256_set1_pd(eta);
+    __m256d Delta_max_v = zero;
+    uint64_t k = 0;
+    for ( ; k + 4 <= batch.size; k += 4) {
+        __m256d mu = _mm256_min_pd(_mm256_mul_pd(eta_v, _mm256_loadu_pd(batch.w + k)), one);
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(batch.x_i + k), _mm256_loadu_pd(batch.x_j + k));
+        dx = _mm256_blendv_pd(dx, tiny, _mm256_cmp_pd(dx, zero, _CMP_EQ_OQ)); // avoid nan
+        __m256d sign = _mm256_and_pd(dx, sign_mask);
+        __m256d mag = _mm256_andnot_pd(sign_mask, dx);
+        __m256d Delta = _mm256_mul_pd(_mm256_mul_pd(mu, _mm256_sub_pd(mag, _mm256_loadu_pd(batch.d + k))), half);
+        Delta_max_v = _mm256_max_pd(Delta_max_v, _mm256_andnot_pd(sign_mask, Delta));
+        _mm256_storeu_pd(batch.r_x + k, _mm256_xor_pd(Delta, sign));
     }
-    */
-    // how many term updates we make
-    std::atomic<uint64_t> term_updates; term_updates.store(0);
+    double Delta_maxes[4];
+    _mm256_storeu_pd(Delta_maxes, Delta_max_v);
+    double Delta_max = std::max(std::max(Delta_maxes[0], Delta_maxes[1]), std::max(Delta_maxes[2], Delta_maxes[3]));
+    return std::max(Delta_max, sgd_batch_moves_scalar(batch, eta, k));
+}
+#else
+double sgd_batch_moves_avx2(sgd_batch_t& batch, const double& eta) {
+    return sgd_batch_moves_scalar(batch, eta);
+}
+#endif
+
+bool sgd_has_avx2(void) {
+#ifdef ODGI_SGD_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+}
+
+// compute the moves of the batch with the best kernel this CPU supports
+static double sgd_batch_moves(sgd_batch_t& batch, const double& eta) {
+    if (sgd_has_avx2()) {
+        return sgd_batch_moves_avx2(batch, eta);
+    }
+    return sgd_batch_moves_scalar(batch, eta);
+}
+
+// run the SGD workers and the checker that drives their learning rate, over terms given by the sampler,
+// which sets the node ranks i and j, their distance d and weight w and returns false if there's no term
+// an iteration ends after updates_per_iteration term updates
+// if batched is set, workers gather batches of terms and compute their moves together
+template<typename Sampler>
+static std::vector<double> run_linear_sgd(std::vector<std::atomic<double>>& X,
+                                          const Sampler& sample_term,
+                                          const uint64_t& updates_per_iteration,
+                                          const std::vector<double>& etas,
+                                          const uint64_t& t_max,
+                                          const double& delta,
+                                          const uint64_t& nthreads,
+                                          const uint64_t& seed,
+                                          const bool& batched) {
+    using namespace std::chrono_literals; // for timing stuff
+    // how many term updates each thread has made, and the largest move it has seen this iteration,
+    // kept on separate cache lines so that workers never write to shared memory except X
+    std::vector<sgd_thread_state_t, aligned_allocator_t<sgd_thread_state_t>> thread_states(nthreads);
     // learning rate
     std::atomic<double> eta; eta.store(etas.front());
-    // our max delta
-    std::atomic<double> Delta_max; Delta_max.store(0);
     // should we keep working?
     std::atomic<bool> work_todo; work_todo.store(true);
     // approximately what iteration we're on
@@ -52,25 +114,36 @@ std::vector<double> linear_sgd(const PathHandleGraph& graph,
     // launch a thread to update the learning rate, count iterations, and decide when to stop
     auto checker_lambda =
         [&](void) {
+            // the workers' counters only grow, so we count updates since the last iteration
+            uint64_t last_updates = 0;
             while (work_todo.load()) {
-                if (term_updates.load() > terms.size()) {
-                    if (++iteration > t_max) {
+                uint64_t term_updates = 0;
+                for (auto& state : thread_states) {
+                    term_updates += state.term_updates.load(std::memory_order_relaxed);
+                }
+                if (term_updates - last_updates > updates_per_iteration) {
+                    double Delta_max = 0;
+                    for (auto& state : thread_states) {
+                        Delta_max = std::max(Delta_max, state.Delta_max.load(std::memory_order_relaxed));
+                    }
+                    if (++iteration >= t_max) { // etas has t_max steps
                         work_todo.store(false);
-                    } else if (Delta_max.load() <= delta) { // nb: this will also break at 0
+                    } else if (Delta_max <= delta) { // nb: this will also break at 0
                         work_todo.store(false);
                     } else {
 //#pragma omp critical (cerr)
                         /*
                         std::cerr << iteration
                                   << ", eta: " << eta.load()
-                                  << ", Delta: " << Delta_max.load()
-                                  << " terms " << terms.size()
-                                  << " updates " << term_updates.load() << std::endl;
+                                  << ", Delta: " << Delta_max
+                                  << " updates " << term_updates - last_updates << std::endl;
                         */
-                        eta.store(etas[iteration]); // update our learning rate
-                        Delta_max.store(delta); // set our delta max to the threshold
+                        eta.store(etas[iteration], std::memory_order_relaxed); // update our learning rate
+                        for (auto& state : thread_states) {
+                            state.Delta_max.store(delta, std::memory_order_relaxed); // set our delta max to the threshold
+                        }
                     }
-                    term_updates.store(0);
+                    last_updates = term_updates;
                 }
                 std::this_thread::sleep_for(1ms);
             }
@@ -78,57 +151,82 @@ std::vector<double> linear_sgd(const PathHandleGraph& graph,
 
     auto worker_lambda =
         [&](uint64_t tid) {
-            // everyone tries to seed with their own random data
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::uniform_int_distribution<uint64_t> dis(0, terms.size()-1);
-            while (work_todo.load()) {
-                // pick a random term
-                uint64_t idx = dis(gen);
-                // try to acquire a mutex lock on it, and try again if we fail
-                if (term_mutexes[idx].try_lock()) {
-                    auto& t = terms[idx];
-                    double w_ij = t.w;
-                    double mu = eta.load() * w_ij;
-                    if (mu > 1) {
-                        mu = 1;
+            // everyone gets their own random stream, derived from our seed
+            // seed_seq keeps only the low 32 bits of each value, so we pass the seed as two words
+            std::seed_seq thread_seed{(uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)tid};
+            std::mt19937 gen(thread_seed);
+            auto& state = thread_states[tid];
+            if (batched) {
+                sgd_batch_t batch;
+                while (work_todo.load(std::memory_order_relaxed)) {
+                    batch.size = 0;
+                    for (uint64_t k = 0; k < sgd_batch_t::capacity; ++k) {
+                        // failed samples count toward the iteration, as below
+                        if (sample_term(gen, batch.i[batch.size], batch.j[batch.size],
+                                        batch.d[batch.size], batch.w[batch.size])) {
+                            ++batch.size;
+                        }
                     }
-                    // actual distance in graph
-                    double d_ij = t.d;
-                    // identities
-                    uint64_t i = number_bool_packing::unpack_number(t.i);
-                    uint64_t j = number_bool_packing::unpack_number(t.j);
-//#pragma omp critical (cerr)
-//                  std::cerr << "nodes are " << graph.get_id(t.i) << " and " << graph.get_id(t.j) << std::endl;
-                    // distance == magnitude in our 1D situation
-                    double dx = X[i].load()-X[j].load();
-                    if (dx == 0) {
-                        dx = 1e-9; // avoid nan
+                    for (uint64_t k = 0; k < batch.size; ++k) {
+                        batch.x_i[k] = X[batch.i[k]].load(std::memory_order_relaxed);
+                        batch.x_j[k] = X[batch.j[k]].load(std::memory_order_relaxed);
                     }
-//#pragma omp critical (cerr)
-//                    std::cerr << "distance is " << dx << " but should be " << d_ij << std::endl;
-                    //double mag = dx; //sqrt(dx*dx + dy*dy);
-                    double mag = sqrt(dx*dx);
-                    // check distances for early stopping
-                    double Delta = mu * (mag-d_ij) / 2;
-                    // try until we succeed. risky.
-                    double Delta_abs = std::abs(Delta);
-//#pragma omp critical (cerr)
-//                    std::cerr << "Delta_abs " << Delta_abs << std::endl;
-                    while (Delta_abs > Delta_max.load()) {
-                        Delta_max.store(Delta_abs);
+                    double Delta_max = sgd_batch_moves(batch, eta.load(std::memory_order_relaxed));
+                    if (Delta_max > state.Delta_max.load(std::memory_order_relaxed)) {
+                        state.Delta_max.store(Delta_max, std::memory_order_relaxed);
                     }
-                    // calculate update
-                    double r = Delta / mag;
-                    double r_x = r * dx;
-//#pragma omp critical (cerr)
-//                    std::cerr << "r_x is " << r_x << std::endl;
-                    // update our positions (atomically)
-                    X[i].store(X[i].load()-r_x);
-                    X[j].store(X[j].load()+r_x); 
-                    term_updates.store(term_updates.load()+1);
-                    term_mutexes[idx].unlock();
+                    // apply the moves as offsets to the current positions, so that a node
+                    // appearing more than once in the batch keeps all of its moves
+                    for (uint64_t k = 0; k < batch.size; ++k) {
+                        auto& x_i = X[batch.i[k]];
+                        x_i.store(x_i.load(std::memory_order_relaxed) - batch.r_x[k], std::memory_order_relaxed);
+                        auto& x_j = X[batch.j[k]];
+                        x_j.store(x_j.load(std::memory_order_relaxed) + batch.r_x[k], std::memory_order_relaxed);
+                    }
+                    state.term_updates.store(state.term_updates.load(std::memory_order_relaxed) + sgd_batch_t::capacity,
+                                             std::memory_order_relaxed);
                 }
+                return;
+            }
+            uint64_t i, j;
+            double d_ij, w_ij;
+            while (work_todo.load(std::memory_order_relaxed)) {
+                // pick a random term, and update it without locking (Hogwild!)
+                // collisions are rare when there are many more terms than threads
+                // and they only lose part of an update
+                if (!sample_term(gen, i, j, d_ij, w_ij)) {
+                    // failed samples count toward the iteration, so we finish even without terms
+                    state.term_updates.store(state.term_updates.load(std::memory_order_relaxed) + 1,
+                                             std::memory_order_relaxed);
+                    continue;
+                }
+                double mu = eta.load(std::memory_order_relaxed) * w_ij;
+                if (mu > 1) {
+                    mu = 1;
+                }
+                // distance == magnitude in our 1D situation
+                double x_i = X[i].load(std::memory_order_relaxed);
+                double x_j = X[j].load(std::memory_order_relaxed);
+                double dx = x_i - x_j;
+                if (dx == 0) {
+                    dx = 1e-9; // avoid nan
+                }
+                double mag = std::abs(dx);
+                // check distances for early stopping
+                double Delta = mu * (mag-d_ij) / 2;
+                double Delta_abs = std::abs(Delta);
+                // only this thread writes its max, but the checker may reset it
+                if (Delta_abs > state.Delta_max.load(std::memory_order_relaxed)) {
+                    state.Delta_max.store(Delta_abs, std::memory_order_relaxed);
+                }
+                // calculate update
+                double r = Delta / mag;
+                double r_x = r * dx;
+                // update our positions
+                X[i].store(x_i - r_x, std::memory_order_relaxed);
+                X[j].store(x_j + r_x, std::memory_order_relaxed);
+                state.term_updates.store(state.term_updates.load(std::memory_order_relaxed) + 1,
+                                         std::memory_order_relaxed);
             }
         };
 
@@ -153,18 +251,242 @@ std::vector<double> linear_sgd(const PathHandleGraph& graph,
     return X_final;
 }
 
+// run SGD with a schedule that only depends on the seed and the number of threads
+// in each iteration, thread t samples a fixed share of the updates from a stream seeded by (seed, iteration, t)
+// the threads work in rounds, computing their moves from the positions left by the previous round
+// and then applying them in thread order, so no update depends on thread timing
+template<typename Sampler>
+static std::vector<double> run_deterministic_linear_sgd(std::vector<std::atomic<double>>& X,
+                                                        const Sampler& sample_term,
+                                                        const uint64_t& updates_per_iteration,
+                                                        const std::vector<double>& etas,
+                                                        const uint64_t& t_max,
+                                                        const double& delta,
+                                                        const uint64_t& nthreads,
+                                                        const uint64_t& seed,
+                                                        const bool& batched) {
+    // how many updates each thread makes in a round before we synchronize
+    const uint64_t round_size = 16 * sgd_batch_t::capacity;
+    std::vector<std::mt19937> gens(nthreads);
+    std::vector<double> Delta_maxes(nthreads);
+    // the moves of each thread in this round, as (node rank, offset)
+    std::vector<std::vector<std::pair<uint64_t, double>>> moves(nthreads);
+    std::vector<sgd_batch_t> batches(nthreads);
+    for (uint64_t iteration = 0; iteration < t_max; ++iteration) {
+        double eta = etas[iteration];
+        for (uint64_t t = 0; t < nthreads; ++t) {
+            std::seed_seq thread_seed{(uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)iteration, (uint32_t)t};
+            gens[t].seed(thread_seed);
+            Delta_maxes[t] = 0;
+        }
+        uint64_t per_thread = updates_per_iteration / nthreads + (updates_per_iteration % nthreads ? 1 : 0);
+        for (uint64_t round_start = 0; round_start < per_thread; round_start += round_size) {
+            uint64_t round_end = std::min(round_start + round_size, per_thread);
+#pragma omp parallel for schedule(static, 1) num_threads(nthreads)
+            for (uint64_t t = 0; t < nthreads; ++t) {
+                auto& gen = gens[t];
+                auto& batch = batches[t];
+                auto& thread_moves = moves[t];
+                thread_moves.clear();
+                for (uint64_t k = round_start; k < round_end; k += sgd_batch_t::capacity) {
+                    batch.size = 0;
+                    for (uint64_t l = k; l < std::min(k + sgd_batch_t::capacity, round_end); ++l) {
+                        if (sample_term(gen, batch.i[batch.size], batch.j[batch.size],
+                                        batch.d[batch.size], batch.w[batch.size])) {
+                            ++batch.size;
+                        }
+                    }
+                    for (uint64_t l = 0; l < batch.size; ++l) {
+                        batch.x_i[l] = X[batch.i[l]].load(std::memory_order_relaxed);
+                        batch.x_j[l] = X[batch.j[l]].load(std::memory_order_relaxed);
+                    }
+                    double Delta_max = batched ? sgd_batch_moves(batch, eta) : sgd_batch_moves_scalar(batch, eta);
+                    Delta_maxes[t] = std::max(Delta_maxes[t], Delta_max);
+                    for (uint64_t l = 0; l < batch.size; ++l) {
+                        thread_moves.emplace_back(batch.i[l], -batch.r_x[l]);
+                        thread_moves.emplace_back(batch.j[l], batch.r_x[l]);
+                    }
+                }
+            }
+            for (auto& thread_moves : moves) {
+                for (auto& move : thread_moves) {
+                    X[move.first].store(X[move.first].load(std::memory_order_relaxed) + move.second,
+                                        std::memory_order_relaxed);
+                }
+            }
+        }
+        if (*std::max_element(Delta_maxes.begin(), Delta_maxes.end()) <= delta) { // nb: this will also break at 0
+            break;
+        }
+    }
+    std::vector<double> X_final(X.size());
+    uint64_t i = 0;
+    for (auto& x : X) {
+        X_final[i++] = x.load();
+    }
+    return X_final;
+}
+
+// build the terms of the graph and run SGD on them from the positions in X,
+// following the last iters steps of the schedule for t_max iterations
+static std::vector<double> run_term_linear_sgd(const PathHandleGraph& graph,
+                                               std::vector<std::atomic<double>>& X,
+                                               const uint64_t& bandwidth,
+                                               const double& sampling_rate,
+                                               const bool& use_paths,
+                                               const uint64_t& t_max,
+                                               const uint64_t& iters,
+                                               const double& eps,
+                                               const double& delta,
+                                               const uint64_t& nthreads,
+                                               const uint64_t& seed,
+                                               const bool& deterministic,
+                                               const bool& batched) {
+    // run banded BFSs in the graph to build our terms
+    std::vector<sgd_term_t> terms;
+    if (use_paths) {
+        terms = linear_sgd_path_search(graph, bandwidth, sampling_rate, seed);
+    } else {
+        terms = linear_sgd_search(graph, bandwidth, sampling_rate, seed);
+    }
+    if (terms.empty()) {
+        std::vector<double> X_final(X.size());
+        for (uint64_t i = 0; i < X.size(); ++i) X_final[i] = X[i].load();
+        return X_final;
+    }
+    // get our schedule
+    std::vector<double> etas = linear_sgd_schedule(terms, t_max, eps);
+    etas.erase(etas.begin(), etas.end() - std::min(iters, t_max));
+    // iterate through step sizes
+    /*
+    for (auto &t : terms) {
+        std::cerr << "considering " << graph.get_id(t.i) << " and " << graph.get_id(t.j) << " w = " << t.w << " d = " << t.d << std::endl;
+    }
+    */
+    auto sample_term =
+        [&](std::mt19937& gen, uint64_t& i, uint64_t& j, double& d, double& w) {
+            auto& t = terms[std::uniform_int_distribution<uint64_t>(0, terms.size()-1)(gen)];
+            i = number_bool_packing::unpack_number(t.i);
+            j = number_bool_packing::unpack_number(t.j);
+            d = t.d;
+            w = t.w;
+            return true;
+        };
+    if (deterministic) {
+        return run_deterministic_linear_sgd(X, sample_term, terms.size(), etas, etas.size(), delta, nthreads, seed, batched);
+    }
+    return run_linear_sgd(X, sample_term, terms.size(), etas, etas.size(), delta, nthreads, seed, batched);
+}
+
+std::vector<double> linear_sgd(const PathHandleGraph& graph,
+                               const uint64_t& bandwidth,
+                               const double& sampling_rate,
+                               const bool& use_paths,
+                               const uint64_t& t_max,
+                               const double& eps,
+                               const double& delta,
+                               const uint64_t& nthreads,
+                               const uint64_t& seed,
+                               const bool& deterministic,
+                               const bool& batched) {
+    // our positions in 1D
+    std::vector<std::atomic<double>> X = initial_positions(graph);
+    return run_term_linear_sgd(graph, X, bandwidth, sampling_rate, use_paths, t_max, t_max, eps, delta, nthreads,
+                               seed, deterministic, batched);
+}
+
+std::vector<double> linear_sgd_refine(const PathHandleGraph& graph,
+                                      const std::vector<double>& layout,
+                                      const uint64_t& bandwidth,
+                                      const double& sampling_rate,
+                                      const bool& use_paths,
+                                      const uint64_t& t_max,
+                                      const uint64_t& iters,
+                                      const double& eps,
+                                      const double& delta,
+                                      const uint64_t& nthreads,
+                                      const uint64_t& seed,
+                                      const bool& deterministic,
+                                      const bool& batched) {
+    std::vector<std::atomic<double>> X(layout.size());
+    for (uint64_t i = 0; i < layout.size(); ++i) {
+        X[i].store(layout[i]);
+    }
+    return run_term_linear_sgd(graph, X, bandwidth, sampling_rate, use_paths, t_max, iters, eps, delta, nthreads,
+                               seed, deterministic, batched);
+}
+
+std::vector<double> path_linear_sgd(const PathHandleGraph& graph,
+                                    const xp::XP& path_index,
+                                    const uint64_t& bandwidth,
+                                    const double& sampling_rate,
+                                    const uint64_t& t_max,
+                                    const double& eps,
+                                    const double& delta,
+                                    const uint64_t& nthreads,
+                                    const uint64_t& seed,
+                                    const bool& deterministic,
+                                    const bool& batched) {
+    // our positions in 1D
+    std::vector<std::atomic<double>> X = initial_positions(graph);
+    // cumulative step counts, so that we can pick a step uniformly across the paths
+    std::vector<xp::XPPath*> paths = path_index.get_paths();
+    std::vector<uint64_t> path_step_ends;
+    uint64_t total_steps = 0;
+    for (auto& path : paths) {
+        total_steps += path->handles.size();
+        path_step_ends.push_back(total_steps);
+    }
+    if (total_steps == 0) {
+        std::vector<double> X_final(X.size());
+        for (uint64_t i = 0; i < X.size(); ++i) X_final[i] = X[i].load();
+        return X_final;
+    }
+    // partners are at most bandwidth bp away and at least 1, which bounds the weights
+    std::vector<double> etas = linear_sgd_schedule(1.0 / ((double)bandwidth * bandwidth), 1.0, t_max, eps);
+    auto sample_term =
+        [&](std::mt19937& gen, uint64_t& i, uint64_t& j, double& d, double& w) {
+            uint64_t step = std::uniform_int_distribution<uint64_t>(0, total_steps-1)(gen);
+            uint64_t p = std::upper_bound(path_step_ends.begin(), path_step_ends.end(), step) - path_step_ends.begin();
+            const xp::XPPath& path = *paths[p];
+            uint64_t rank = step - (p ? path_step_ends[p-1] : 0);
+            // our partner is the step covering a position within the bandwidth along the path
+            int64_t pos_i = path.offsets_select(rank+1);
+            int64_t pos_j = pos_i + std::uniform_int_distribution<int64_t>(-(int64_t)bandwidth, bandwidth)(gen);
+            if (pos_j < 0 || pos_j >= (int64_t)path.offsets.size()) {
+                return false;
+            }
+            uint64_t rank_j = path.step_rank_at_position(pos_j);
+            i = number_bool_packing::unpack_number(path.handle(rank));
+            j = number_bool_packing::unpack_number(path.handle(rank_j));
+            if (i == j) {
+                return false;
+            }
+            // the path distance between the starts of the steps
+            d = std::abs((int64_t)path.offsets_select(rank_j+1) - pos_i);
+            w = 1.0 / (d * d);
+            return true;
+        };
+    // sampling_rate is the number of terms we sample per path step in each iteration
+    uint64_t updates_per_iteration = std::max((uint64_t)1, (uint64_t)(total_steps * sampling_rate));
+    if (deterministic) {
+        return run_deterministic_linear_sgd(X, sample_term, updates_per_iteration, etas, t_max, delta, nthreads, seed, batched);
+    }
+    return run_linear_sgd(X, sample_term, updates_per_iteration, etas, t_max, delta, nthreads, seed, batched);
+}
+
 // find pairs of handles to operate on, searching up to bandwidth steps, recording their graph distance
 std::vector<sgd_term_t> linear_sgd_search(const HandleGraph& graph,
                                           const uint64_t& bandwidth,
-                                          const double& sampling_rate) {
+                                          const double& sampling_rate,
+                                          const uint64_t& seed) {
     std::vector<sgd_term_t> terms;
     uint64_t graph_length = 0;
     graph.for_each_handle([&](const handle_t& h) { graph_length += graph.get_length(h); });
     double bp_per_node = (double)graph_length/graph.get_node_count();
     bf::basic_bloom_filter seen_pairs(0.01, graph.get_node_count() * bandwidth / bp_per_node);
     std::hash<std::pair<handle_t,handle_t>> hasher;
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
     std::uniform_real_distribution<double> dis(0.0, 1.0);
     graph.for_each_handle(
         [&](const handle_t& h) {
@@ -203,15 +525,15 @@ std::vector<sgd_term_t> linear_sgd_search(const HandleGraph& graph,
 // find pairs of handles to operate on, searching up to bandwidth steps, recording their graph distance
 std::vector<sgd_term_t> linear_sgd_path_search(const PathHandleGraph& graph,
                                                const uint64_t& bandwidth,
-                                               const double& sampling_rate) {
+                                               const double& sampling_rate,
+                                               const uint64_t& seed) {
     std::vector<sgd_term_t> terms;
     uint64_t graph_length = 0;
     graph.for_each_handle([&](const handle_t& h) { graph_length += graph.get_length(h); });
     double bp_per_node = (double)graph_length/graph.get_node_count();
     bf::basic_bloom_filter seen_pairs(0.01, graph.get_node_count() * bandwidth / bp_per_node);
     std::hash<std::pair<handle_t,handle_t>> hasher;
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
     std::uniform_real_distribution<double> dis(0.0, 1.0);
     // iterate over nodes, following the paths they are on out
     graph.for_each_handle(
@@ -254,6 +576,13 @@ std::vector<double> linear_sgd_schedule(const std::vector<sgd_term_t> &terms,
         if (w < w_min) w_min = w;
         if (w > w_max) w_max = w;
     }
+    return linear_sgd_schedule(w_min, w_max, t_max, eps);
+}
+
+std::vector<double> linear_sgd_schedule(const double& w_min,
+                                        const double& w_max,
+                                        const uint64_t& t_max,
+                                        const double& eps) {
     double eta_max = 1.0 / w_min;
     double eta_min = eps / w_max;
     double lambda = log(eta_max/eta_min) / ((double)t_max-1);
@@ -273,8 +602,34 @@ std::vector<handle_t> linear_sgd_order(const PathHandleGraph& graph,
                                        const uint64_t& t_max,
                                        const double& eps,
                                        const double& delta,
-                                       const uint64_t& nthreads) {
-    std::vector<double> layout = linear_sgd(graph, bandwidth, sampling_rate, use_paths, t_max, eps, delta, nthreads);
+                                       const uint64_t& nthreads,
+                                       const uint64_t& seed,
+                                       const bool& deterministic,
+                                       const bool& batched) {
+    std::vector<double> layout = linear_sgd(graph, bandwidth, sampling_rate, use_paths, t_max, eps, delta, nthreads,
+                                            seed, deterministic, batched);
+    return linear_layout_order(graph, layout);
+}
+
+std::vector<handle_t> path_linear_sgd_order(const PathHandleGraph& graph,
+                                            const uint64_t& bandwidth,
+                                            const double& sampling_rate,
+                                            const uint64_t& t_max,
+                                            const double& eps,
+                                            const double& delta,
+                                            const uint64_t& nthreads,
+                                            const uint64_t& seed,
+                                            const bool& deterministic,
+                                            const bool& batched) {
+    xp::XP path_index;
+    path_index.from_handle_graph(graph);
+    std::vector<double> layout = path_linear_sgd(graph, path_index, bandwidth, sampling_rate, t_max, eps, delta, nthreads,
+                                                 seed, deterministic, batched);
+    return linear_layout_order(graph, layout);
+}
+
+std::vector<handle_t> linear_layout_order(const HandleGraph& graph,
+                                          const std::vector<double>& layout) {
     std::vector<std::pair<double, handle_t>> layout_handles;
     uint64_t i = 0;
     graph.for_each_handle([&i,&layout,&layout_handles](const handle_t& handle) {
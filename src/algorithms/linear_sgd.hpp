@@ -10,12 +10,15 @@
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <new>
+#include <cstdlib>
 #include <handlegraph/handle_graph.hpp>
 #include <handlegraph/path_handle_graph.hpp>
 #include <handlegraph/util.hpp>
 #include <bf/all.hpp>
 #include "hash_map.hpp"
 #include "bfs.hpp"
+#include "xp.hpp"
 
 namespace odgi {
 namespace algorithms {
@@ -28,7 +31,58 @@ struct sgd_term_t {
     sgd_term_t(const handle_t& i, const handle_t& j, const double& d, const double& w) : i(i), j(j), d(d), w(w) {}
 };
 
+// a batch of terms gathered by one SGD worker, laid out as arrays so that their moves can be computed in vector registers
+struct sgd_batch_t {
+    static const uint64_t capacity = 64;
+    uint64_t size = 0;
+    uint64_t i[capacity], j[capacity];
+    double x_i[capacity], x_j[capacity], d[capacity], w[capacity];
+    // the move of each term, which we subtract from x_i and add to x_j
+    double r_x[capacity];
+};
+
+// compute the moves of the terms in the batch from begin onward, one at a time, returning the largest |Delta|
+double sgd_batch_moves_scalar(sgd_batch_t& batch, const double& eta, uint64_t begin = 0);
+
+// the same computation, four terms at a time with AVX2; call it only if sgd_has_avx2()
+double sgd_batch_moves_avx2(sgd_batch_t& batch, const double& eta);
+
+// true if this build and CPU can run sgd_batch_moves_avx2
+bool sgd_has_avx2(void);
+
+// the progress of one SGD worker, on a cache line of its own so that workers don't contend
+struct alignas(64) sgd_thread_state_t {
+    std::atomic<uint64_t> term_updates;
+    std::atomic<double> Delta_max;
+    sgd_thread_state_t(void) : term_updates(0), Delta_max(0) {}
+};
+
+// an allocator that honours the alignment of T, which std::allocator only does from C++17 on
+template<typename T>
+struct aligned_allocator_t {
+    typedef T value_type;
+    aligned_allocator_t(void) {}
+    template<typename U> aligned_allocator_t(const aligned_allocator_t<U>&) {}
+    T* allocate(std::size_t n) {
+        void* p = nullptr;
+        if (posix_memalign(&p, std::max(alignof(T), sizeof(void*)), n * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, std::size_t) { free(p); }
+};
+
+template<typename T, typename U>
+bool operator==(const aligned_allocator_t<T>&, const aligned_allocator_t<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const aligned_allocator_t<T>&, const aligned_allocator_t<U>&) { return false; }
+
 // use SGD driven by banded pairwise distances to obtain a linear layout of the graph that respects its topology
+// all randomness derives from the seed; if deterministic is set, the threads follow a fixed schedule
+// and the layout depends only on the seed and the number of threads
+// if batched is set, each thread gathers batches of terms and computes their updates in vector registers
+// (with AVX2 when the CPU has it) before scattering them back to the positions
 std::vector<double> linear_sgd(const PathHandleGraph& graph,
                                const uint64_t& bandwidth,
                                const double& sampling_rate,
@@ -36,24 +90,64 @@ std::vector<double> linear_sgd(const PathHandleGraph& graph,
                                const uint64_t& t_max,
                                const double& eps,
                                const double& delta,
-                               const uint64_t& nthreads);
+                               const uint64_t& nthreads,
+                               const uint64_t& seed,
+                               const bool& deterministic,
+                               const bool& batched);
 
+// continue SGD from the given layout, indexed by node rank, for the last iters iterations of the schedule for t_max
+std::vector<double> linear_sgd_refine(const PathHandleGraph& graph,
+                                      const std::vector<double>& layout,
+                                      const uint64_t& bandwidth,
+                                      const double& sampling_rate,
+                                      const bool& use_paths,
+                                      const uint64_t& t_max,
+                                      const uint64_t& iters,
+                                      const double& eps,
+                                      const double& delta,
+                                      const uint64_t& nthreads,
+                                      const uint64_t& seed,
+                                      const bool& deterministic,
+                                      const bool& batched);
+
+// use SGD over terms sampled on the fly from the paths, with their distances taken from the path index
+// this never materializes the terms, so it needs memory only for the positions and the index
+// sampling_rate gives the number of terms to sample per path step in each iteration
+std::vector<double> path_linear_sgd(const PathHandleGraph& graph,
+                                    const xp::XP& path_index,
+                                    const uint64_t& bandwidth,
+                                    const double& sampling_rate,
+                                    const uint64_t& t_max,
+                                    const double& eps,
+                                    const double& delta,
+                                    const uint64_t& nthreads,
+                                    const uint64_t& seed,
+                                    const bool& deterministic,
+                                    const bool& batched);
 
 // find pairs of handles to operate on, searching up to bandwidth steps, recording their graph distance
 std::vector<sgd_term_t> linear_sgd_search(const HandleGraph& graph,
                                           const uint64_t& bandwidth,
-                                          const double& sampling_rate);
+                                          const double& sampling_rate,
+                                          const uint64_t& seed);
 
 // find pairs of handles to operate on using path iteration to establish distances
 std::vector<sgd_term_t> linear_sgd_path_search(const PathHandleGraph& graph,
                                                const uint64_t& bandwidth,
-                                               const double& sampling_rate);
+                                               const double& sampling_rate,
+                                               const uint64_t& seed);
 
 // our learning schedule
 std::vector<double> linear_sgd_schedule(const std::vector<sgd_term_t>& terms,
                                         const uint64_t& t_max,
                                         const double& eps);
 
+// our learning schedule, given the range of the term weights
+std::vector<double> linear_sgd_schedule(const double& w_min,
+                                        const double& w_max,
+                                        const uint64_t& t_max,
+                                        const double& eps);
+
 std::vector<handle_t> linear_sgd_order(const PathHandleGraph& graph,
                                        const uint64_t& bandwidth,
                                        const double& sampling_rate,
@@ -61,7 +155,26 @@ std::vector<handle_t> linear_sgd_order(const PathHandleGraph& graph,
                                        const uint64_t& t_max,
                                        const double& eps,
                                        const double& delta,
-                                       const uint64_t& nthreads);
+                                       const uint64_t& nthreads,
+                                       const uint64_t& seed,
+                                       const bool& deterministic,
+                                       const bool& batched);
+
+// build the path index and sort the graph by path-guided SGD
+std::vector<handle_t> path_linear_sgd_order(const PathHandleGraph& graph,
+                                            const uint64_t& bandwidth,
+                                            const double& sampling_rate,
+                                            const uint64_t& t_max,
+                                            const double& eps,
+                                            const double& delta,
+                                            const uint64_t& nthreads,
+                                            const uint64_t& seed,
+                                            const bool& deterministic,
+                                            const bool& batched);
+
+// order the handles by their position in a 1D layout
+std::vector<handle_t> linear_layout_order(const HandleGraph& graph,
+                                          const std::vector<double>& layout);
 
 }
 }
@@ -7,12 +7,15 @@
  */
 
 #include <iostream>
-#include <fstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 #include "../hash_map.hpp"
 #include <handlegraph/handle_graph.hpp>
+#include <handlegraph/path_handle_graph.hpp>
 #include <handlegraph/util.hpp>
-#include "matrix_writer.hpp"
-#include "temp_file.hpp"
 
 #define GAINBUCKET_ARRAY
 #define MONDRIAANVERSION "\"4.2.1\""
@@ -33,7 +36,14 @@ namespace algorithms {
 
 using namespace handlegraph;
 
-void mondriaan_main(int argc, char** argv);
+// fill the sparse matrix A with the adjacency matrix of the graph, indexed by node id
+// with its edges weighted by the number of paths crossing them or the inverse of their id delta
+void graph_sparse_matrix(const PathHandleGraph& graph,
+                         bool weight_by_edge_depth, bool weight_by_edge_delta,
+                         struct sparsematrix* A);
+
+// order the graph by the symmetric separated block diagonal permutation that Mondriaan
+// finds for its adjacency matrix when partitioning it into n_parts
 
 std::vector<handle_t> mondriaan_sort(const PathHandleGraph& graph,
                                      uint64_t n_parts, double eps,
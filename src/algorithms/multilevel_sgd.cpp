@@ -0,0 +1,263 @@
+#include "multilevel_sgd.hpp"
+
+namespace odgi {
+namespace algorithms {
+
+// we stop coarsening once a level has at most this many nodes
+static const uint64_t coarsest_node_count = 1000;
+// or when coarsening no longer shrinks the graph by much
+static const double min_coarsening = 0.8;
+// refinement only has to fix the order locally, so its terms reach across about this many nodes
+static const uint64_t refine_span = 32;
+
+// the finest level, taken from the graph
+static sgd_level_t input_sgd_level(const PathHandleGraph& graph) {
+    sgd_level_t level;
+    level.lengths.resize(graph.get_node_count());
+    graph.for_each_handle([&](const handle_t& handle) {
+            // nb: we assume that the graph provides a compact handle set, as linear_sgd does
+            level.lengths[number_bool_packing::unpack_number(handle)] = graph.get_length(handle);
+        });
+    graph.for_each_edge([&](const edge_t& edge) {
+            level.edges.push_back(std::make_pair(as_integer(edge.first), as_integer(edge.second)));
+            level.edge_weights.push_back(1);
+        });
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+            level.paths.emplace_back();
+            auto& steps = level.paths.back();
+            graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+                    steps.push_back(as_integer(graph.get_handle_of_step(step)));
+                });
+            level.path_circular.push_back(graph.get_is_circular(path));
+        });
+    return level;
+}
+
+// a graph of the level that linear SGD can run on, with node ids following the ranks
+// its nodes have no sequence, only lengths
+static std::unique_ptr<topology_graph_t> sgd_level_graph(const sgd_level_t& level) {
+    std::unique_ptr<topology_graph_t> graph(new topology_graph_t());
+    for (uint64_t i = 0; i < level.lengths.size(); ++i) {
+        graph->add_node(i + 1, nullptr, level.lengths[i]);
+    }
+    for (auto& edge : level.edges) {
+        graph->add_edge((edge.first >> 1) + 1, edge.first & 1, (edge.second >> 1) + 1, edge.second & 1);
+    }
+    for (uint64_t i = 0; i < level.paths.size(); ++i) {
+        path_handle_t path = graph->add_path(std::to_string(i), level.path_circular[i]);
+        for (auto& step : level.paths[i]) {
+            graph->append_step(path, (step >> 1) + 1, step & 1);
+        }
+    }
+    graph->index();
+    return graph;
+}
+
+sgd_level_t coarsen_sgd_level(const HandleGraph& graph,
+                              const sgd_level_t& level,
+                              const uint64_t& seed,
+                              std::vector<uint64_t>& group,
+                              std::vector<uint64_t>& offset) {
+    const uint64_t unassigned = std::numeric_limits<uint64_t>::max();
+    uint64_t n = level.lengths.size();
+    group.assign(n, unassigned);
+    offset.assign(n, 0);
+    sgd_level_t coarse;
+    // each chain becomes a single node, with its members laid out in chain order
+    for (auto& chain : simple_components(graph, 2)) {
+        uint64_t g = coarse.lengths.size();
+        uint64_t length = 0;
+        bool merged = false;
+        for (auto& handle : chain) {
+            uint64_t rank = number_bool_packing::unpack_number(handle);
+            if (group[rank] != unassigned) continue;
+            group[rank] = g;
+            offset[rank] = length;
+            length += level.lengths[rank];
+            merged = true;
+        }
+        // a chain of zero-length nodes still needs a coarse node of its own
+        if (merged) {
+            coarse.lengths.push_back(length);
+        }
+    }
+    // the other nodes are matched with the free neighbor they share the heaviest edge with
+    // for that we need the adjacency of each node, ignoring orientation
+    std::vector<uint64_t> adj_offsets(n + 1, 0);
+    for (auto& edge : level.edges) {
+        ++adj_offsets[(edge.first >> 1) + 1];
+        ++adj_offsets[(edge.second >> 1) + 1];
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        adj_offsets[i + 1] += adj_offsets[i];
+    }
+    // as (neighbor, weight)
+    std::vector<std::pair<uint64_t, uint64_t>> adj(adj_offsets.back());
+    std::vector<uint64_t> adj_fill(adj_offsets.begin(), adj_offsets.end() - 1);
+    for (uint64_t i = 0; i < level.edges.size(); ++i) {
+        uint64_t a = level.edges[i].first >> 1;
+        uint64_t b = level.edges[i].second >> 1;
+        adj[adj_fill[a]++] = std::make_pair(b, level.edge_weights[i]);
+        adj[adj_fill[b]++] = std::make_pair(a, level.edge_weights[i]);
+    }
+    // visiting the nodes in a random order spreads the matching evenly over the graph
+    std::vector<uint64_t> visit_order(n);
+    for (uint64_t i = 0; i < n; ++i) visit_order[i] = i;
+    std::mt19937 gen(seed);
+    std::shuffle(visit_order.begin(), visit_order.end(), gen);
+    for (auto& u : visit_order) {
+        if (group[u] != unassigned) continue;
+        // ties go to the shorter neighbor, which keeps the coarse nodes balanced
+        uint64_t best = unassigned;
+        uint64_t best_weight = 0;
+        for (uint64_t k = adj_offsets[u]; k < adj_offsets[u + 1]; ++k) {
+            uint64_t v = adj[k].first;
+            uint64_t weight = adj[k].second;
+            if (v == u || group[v] != unassigned) continue;
+            if (weight > best_weight
+                || (weight == best_weight && level.lengths[v] < level.lengths[best])) {
+                best = v;
+                best_weight = weight;
+            }
+        }
+        uint64_t g = coarse.lengths.size();
+        if (best == unassigned) {
+            group[u] = g;
+            coarse.lengths.push_back(level.lengths[u]);
+        } else {
+            // the pair keeps its relative order from the finer level
+            uint64_t first = std::min(u, best);
+            uint64_t second = std::max(u, best);
+            group[first] = g;
+            group[second] = g;
+            offset[second] = level.lengths[first];
+            coarse.lengths.push_back(level.lengths[first] + level.lengths[second]);
+        }
+    }
+    // edges between the coarse nodes keep the orientation of the edges they come from
+    // we store each in one canonical orientation, so that both strands of an edge merge
+    std::vector<std::pair<std::pair<uint64_t, uint64_t>, uint64_t>> coarse_edges;
+    for (uint64_t i = 0; i < level.edges.size(); ++i) {
+        auto& edge = level.edges[i];
+        uint64_t from = group[edge.first >> 1] << 1 | (edge.first & 1);
+        uint64_t to = group[edge.second >> 1] << 1 | (edge.second & 1);
+        if (from >> 1 == to >> 1) continue;
+        coarse_edges.push_back(std::make_pair(std::min(std::make_pair(from, to), std::make_pair(to ^ 1, from ^ 1)),
+                                              level.edge_weights[i]));
+    }
+    std::sort(coarse_edges.begin(), coarse_edges.end());
+    for (auto& edge : coarse_edges) {
+        if (!coarse.edges.empty() && coarse.edges.back() == edge.first) {
+            coarse.edge_weights.back() += edge.second;
+        } else {
+            coarse.edges.push_back(edge.first);
+            coarse.edge_weights.push_back(edge.second);
+        }
+    }
+    // paths walk the coarse nodes, dropping repeated steps through the same one
+    for (auto& steps : level.paths) {
+        coarse.paths.emplace_back();
+        auto& coarse_steps = coarse.paths.back();
+        for (auto& step : steps) {
+            uint64_t coarse_step = group[step >> 1] << 1 | (step & 1);
+            if (coarse_steps.empty() || coarse_steps.back() >> 1 != coarse_step >> 1) {
+                coarse_steps.push_back(coarse_step);
+            }
+        }
+    }
+    coarse.path_circular = level.path_circular;
+    return coarse;
+}
+
+std::vector<double> multilevel_linear_sgd(const PathHandleGraph& graph,
+                                          const uint64_t& bandwidth,
+                                          const double& sampling_rate,
+                                          const bool& use_paths,
+                                          const uint64_t& t_max,
+                                          const double& eps,
+                                          const double& delta,
+                                          const uint64_t& nthreads,
+                                          const uint64_t& seed,
+                                          const bool& deterministic,
+                                          const bool& batched) {
+    std::vector<sgd_level_t> levels;
+    levels.push_back(input_sgd_level(graph));
+    // the graphs of the levels above the input, and the mapping of each level's nodes into the next
+    std::vector<std::unique_ptr<topology_graph_t>> level_graphs;
+    std::vector<std::vector<uint64_t>> groups;
+    std::vector<std::vector<uint64_t>> offsets;
+    const HandleGraph* current = &graph;
+    while (levels.back().lengths.size() > coarsest_node_count) {
+        std::vector<uint64_t> group, offset;
+        sgd_level_t coarse = coarsen_sgd_level(*current, levels.back(), seed + levels.size(), group, offset);
+        if (coarse.lengths.size() > min_coarsening * levels.back().lengths.size()) {
+            break;
+        }
+        levels.push_back(std::move(coarse));
+        groups.push_back(std::move(group));
+        offsets.push_back(std::move(offset));
+        level_graphs.push_back(sgd_level_graph(levels.back()));
+        current = level_graphs.back().get();
+    }
+    auto level_graph = [&](uint64_t k) -> const PathHandleGraph& {
+        return k == 0 ? graph : *level_graphs[k - 1];
+    };
+    // the bandwidth and sampling rate are given in bp, so we scale them with the mean node length
+    // of each level, which keeps the number of terms per node about the same as at the input level
+    auto scale = [&](uint64_t k) {
+        return (double)levels.front().lengths.size() / std::max((uint64_t)1, (uint64_t)levels[k].lengths.size());
+    };
+    uint64_t total_length = 0;
+    for (auto& length : levels.front().lengths) {
+        total_length += length;
+    }
+    auto refine_bandwidth = [&](uint64_t k) {
+        return std::min((uint64_t)(bandwidth * scale(k)),
+                        std::max((uint64_t)1, refine_span * total_length / std::max((uint64_t)1, (uint64_t)levels[k].lengths.size())));
+    };
+    uint64_t top = levels.size() - 1;
+    std::vector<double> layout = linear_sgd(level_graph(top),
+                                            bandwidth * scale(top),
+                                            sampling_rate * scale(top),
+                                            use_paths,
+                                            t_max, eps, delta, nthreads,
+                                            seed, deterministic, batched);
+    // refinement follows the end of the schedule, where the learning rate is small enough
+    // to keep the structure we've projected from the coarser level
+    uint64_t refine_iters = std::max((uint64_t)1, t_max / 6);
+    for (uint64_t k = top; k > 0; --k) {
+        auto& group = groups[k - 1];
+        auto& offset = offsets[k - 1];
+        std::vector<double> fine_layout(group.size());
+        for (uint64_t i = 0; i < group.size(); ++i) {
+            fine_layout[i] = layout[group[i]] + offset[i];
+        }
+        layout = linear_sgd_refine(level_graph(k - 1),
+                                   fine_layout,
+                                   refine_bandwidth(k - 1),
+                                   sampling_rate * scale(k - 1),
+                                   use_paths,
+                                   t_max, refine_iters, eps, delta, nthreads,
+                                   seed + k, deterministic, batched);
+    }
+    return layout;
+}
+
+std::vector<handle_t> multilevel_linear_sgd_order(const PathHandleGraph& graph,
+                                                  const uint64_t& bandwidth,
+                                                  const double& sampling_rate,
+                                                  const bool& use_paths,
+                                                  const uint64_t& t_max,
+                                                  const double& eps,
+                                                  const double& delta,
+                                                  const uint64_t& nthreads,
+                                                  const uint64_t& seed,
+                                                  const bool& deterministic,
+                                                  const bool& batched) {
+    std::vector<double> layout = multilevel_linear_sgd(graph, bandwidth, sampling_rate, use_paths, t_max, eps, delta,
+                                                       nthreads, seed, deterministic, batched);
+    return linear_layout_order(graph, layout);
+}
+
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include "topology_graph.hpp"
+#include "simple_components.hpp"
+#include "linear_sgd.hpp"
+
+namespace odgi {
+namespace algorithms {
+
+using namespace handlegraph;
+
+// one level of the multilevel hierarchy, holding the topology of a coarsened graph by node rank
+struct sgd_level_t {
+    // the length of each node
+    std::vector<uint64_t> lengths;
+    // edges as pairs of (rank << 1 | is_rev), with the number of input edges they stand for
+    std::vector<std::pair<uint64_t, uint64_t>> edges;
+    std::vector<uint64_t> edge_weights;
+    // paths, with their steps as (rank << 1 | is_rev)
+    std::vector<std::vector<uint64_t>> paths;
+    std::vector<bool> path_circular;
+};
+
+// merge the chains of the graph found by simple_components and match the remaining nodes
+// along their heaviest edges, giving the next coarser level
+// group maps each node rank of the fine level to its coarse node, and offset gives its start within it
+sgd_level_t coarsen_sgd_level(const HandleGraph& graph,
+                              const sgd_level_t& level,
+                              const uint64_t& seed,
+                              std::vector<uint64_t>& group,
+                              std::vector<uint64_t>& offset);
+
+// use linear SGD in a coarsen-solve-refine scheme: the graph is coarsened until it is small,
+// the coarsest graph is laid out with linear SGD, and its layout is projected back to each finer level
+// and refined there with the last few iterations of the SGD schedule
+std::vector<double> multilevel_linear_sgd(const PathHandleGraph& graph,
+                                          const uint64_t& bandwidth,
+                                          const double& sampling_rate,
+                                          const bool& use_paths,
+                                          const uint64_t& t_max,
+                                          const double& eps,
+                                          const double& delta,
+                                          const uint64_t& nthreads,
+                                          const uint64_t& seed,
+                                          const bool& deterministic,
+                                          const bool& batched);
+
+std::vector<handle_t> multilevel_linear_sgd_order(const PathHandleGraph& graph,
+                                                  const uint64_t& bandwidth,
+                                                  const double& sampling_rate,
+                                                  const bool& use_paths,
+                                                  const uint64_t& t_max,
+                                                  const double& eps,
+                                                  const double& delta,
+                                                  const uint64_t& nthreads,
+                                                  const uint64_t& seed,
+                                                  const bool& deterministic,
+                                                  const bool& batched);
+
+}
+}
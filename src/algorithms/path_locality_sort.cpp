@@ -0,0 +1,236 @@
+#include "path_locality_sort.hpp"
+
+namespace odgi {
+
+namespace algorithms {
+
+// the pairs of nodes the paths step between, as a symmetric weighted adjacency over the node indexes
+struct step_adjacency_t {
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> neighbors;
+    std::vector<uint64_t> weights;
+};
+
+// map each node of the graph to its index in the order
+static std::vector<uint64_t> order_index(const PathHandleGraph& graph, const std::vector<handle_t>& order) {
+    std::vector<uint64_t> index(graph.max_node_id() - graph.min_node_id() + 1, 0);
+    for (uint64_t i = 0; i < order.size(); ++i) {
+        index[graph.get_id(order[i]) - graph.min_node_id()] = i;
+    }
+    return index;
+}
+
+static step_adjacency_t step_adjacency(const PathHandleGraph& graph,
+                                       const std::vector<handle_t>& order,
+                                       uint64_t num_threads) {
+    std::vector<uint64_t> index = order_index(graph, order);
+    nid_t min_id = graph.min_node_id();
+    std::vector<path_handle_t> paths;
+    graph.for_each_path_handle([&](const path_handle_t& path) { paths.push_back(path); });
+    // collect the pairs of each path in parallel, as (lower index, higher index)
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> path_pairs(paths.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        auto& pairs = path_pairs[i];
+        bool first = true;
+        uint64_t last = 0;
+        graph.for_each_step_in_path(paths[i], [&](const step_handle_t& step) {
+                uint64_t curr = index[graph.get_id(graph.get_handle_of_step(step)) - min_id];
+                if (!first && curr != last) {
+                    pairs.push_back(std::make_pair(std::min(last, curr), std::max(last, curr)));
+                }
+                first = false;
+                last = curr;
+            });
+        std::sort(pairs.begin(), pairs.end());
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> pairs;
+    for (auto& p : path_pairs) {
+        pairs.insert(pairs.end(), p.begin(), p.end());
+        std::vector<std::pair<uint64_t, uint64_t>>().swap(p);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    // merge repeated pairs into weights
+    std::vector<std::pair<std::pair<uint64_t, uint64_t>, uint64_t>> weighted;
+    for (auto& p : pairs) {
+        if (!weighted.empty() && weighted.back().first == p) {
+            ++weighted.back().second;
+        } else {
+            weighted.push_back(std::make_pair(p, 1));
+        }
+    }
+    std::vector<std::pair<uint64_t, uint64_t>>().swap(pairs);
+    step_adjacency_t adj;
+    uint64_t n = order.size();
+    adj.offsets.assign(n + 1, 0);
+    for (auto& w : weighted) {
+        ++adj.offsets[w.first.first + 1];
+        ++adj.offsets[w.first.second + 1];
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        adj.offsets[i + 1] += adj.offsets[i];
+    }
+    adj.neighbors.resize(adj.offsets.back());
+    adj.weights.resize(adj.offsets.back());
+    std::vector<uint64_t> fill(adj.offsets.begin(), adj.offsets.end() - 1);
+    for (auto& w : weighted) {
+        uint64_t a = w.first.first, b = w.first.second;
+        adj.neighbors[fill[a]] = b;
+        adj.weights[fill[a]++] = w.second;
+        adj.neighbors[fill[b]] = a;
+        adj.weights[fill[b]++] = w.second;
+    }
+    return adj;
+}
+
+// the weighted distance of the placement, counting each pair from its lower node index
+static uint64_t placement_distance(const step_adjacency_t& adj, const std::vector<uint64_t>& rank, uint64_t num_threads) {
+    uint64_t distance = 0;
+    uint64_t n = rank.size();
+#pragma omp parallel for schedule(dynamic, 4096) num_threads(num_threads) reduction(+:distance)
+    for (uint64_t u = 0; u < n; ++u) {
+        for (uint64_t k = adj.offsets[u]; k < adj.offsets[u + 1]; ++k) {
+            uint64_t v = adj.neighbors[k];
+            if (u < v) {
+                distance += adj.weights[k] * (rank[u] > rank[v] ? rank[u] - rank[v] : rank[v] - rank[u]);
+            }
+        }
+    }
+    return distance;
+}
+
+// the change in distance from moving node u from rank p to rank q, with all other nodes in place
+// the other node of a swap is skipped, as the distance between the two doesn't change
+static int64_t move_delta(const step_adjacency_t& adj, const std::vector<uint64_t>& rank,
+                          uint64_t u, uint64_t skip, int64_t p, int64_t q) {
+    int64_t delta = 0;
+    for (uint64_t k = adj.offsets[u]; k < adj.offsets[u + 1]; ++k) {
+        uint64_t v = adj.neighbors[k];
+        if (v == skip) continue;
+        int64_t r = rank[v];
+        delta += (int64_t)adj.weights[k] * (std::abs(q - r) - std::abs(p - r));
+    }
+    return delta;
+}
+
+std::vector<handle_t> path_locality_order(const PathHandleGraph& graph,
+                                          uint64_t iterations,
+                                          uint64_t num_threads,
+                                          bool progress) {
+    std::vector<handle_t> order;
+    order.reserve(graph.get_node_count());
+    graph.for_each_handle([&](const handle_t& handle) { order.push_back(handle); });
+    uint64_t n = order.size();
+    if (n < 2) {
+        return order;
+    }
+    step_adjacency_t adj = step_adjacency(graph, order, num_threads);
+    // rank[u] is the position of node u, and at[p] the node at position p
+    std::vector<uint64_t> rank(n), at(n);
+    for (uint64_t i = 0; i < n; ++i) {
+        rank[i] = at[i] = i;
+    }
+    uint64_t distance = placement_distance(adj, rank, num_threads);
+    if (progress) {
+        std::cerr << "[odgi::path_locality_order] initial distance " << distance << std::endl;
+    }
+    std::vector<double> key(n);
+    std::vector<uint64_t> next_at(n), next_rank(n);
+    for (uint64_t iteration = 0; iteration < iterations; ++iteration) {
+        uint64_t start_distance = distance;
+        // move each node halfway to the weighted median of its neighbors
+        // the half step keeps chains of nodes from collapsing onto one rank
+#pragma omp parallel num_threads(num_threads)
+        {
+            std::vector<std::pair<uint64_t, uint64_t>> around;
+#pragma omp for schedule(dynamic, 4096)
+            for (uint64_t u = 0; u < n; ++u) {
+                around.clear();
+                uint64_t total = 0;
+                for (uint64_t k = adj.offsets[u]; k < adj.offsets[u + 1]; ++k) {
+                    around.push_back(std::make_pair(rank[adj.neighbors[k]], adj.weights[k]));
+                    total += adj.weights[k];
+                }
+                if (around.empty()) {
+                    key[u] = rank[u];
+                    continue;
+                }
+                std::sort(around.begin(), around.end());
+                uint64_t seen = 0;
+                double median = around.back().first;
+                for (uint64_t k = 0; k < around.size(); ++k) {
+                    seen += around[k].second;
+                    if (2 * seen > total) {
+                        median = around[k].first;
+                        break;
+                    } else if (2 * seen == total) {
+                        median = (around[k].first + around[k + 1].first) / 2.0;
+                        break;
+                    }
+                }
+                key[u] = (rank[u] + median) / 2;
+            }
+        }
+        for (uint64_t p = 0; p < n; ++p) {
+            next_at[p] = p;
+        }
+        // ties keep the current order, so the result doesn't depend on the sort
+        std::sort(next_at.begin(), next_at.end(), [&](const uint64_t& a, const uint64_t& b) {
+                return key[a] < key[b] || (key[a] == key[b] && rank[a] < rank[b]);
+            });
+        for (uint64_t p = 0; p < n; ++p) {
+            next_rank[next_at[p]] = p;
+        }
+        uint64_t next_distance = placement_distance(adj, next_rank, num_threads);
+        if (next_distance < distance) {
+            rank.swap(next_rank);
+            at.swap(next_at);
+            distance = next_distance;
+        }
+        // then sweep over the order, swapping neighbors when that shortens the paths
+        for (uint64_t p = 0; p + 1 < n; ++p) {
+            uint64_t u = at[p], v = at[p + 1];
+            int64_t delta = move_delta(adj, rank, u, v, p, p + 1) + move_delta(adj, rank, v, u, p + 1, p);
+            if (delta < 0) {
+                std::swap(at[p], at[p + 1]);
+                rank[u] = p + 1;
+                rank[v] = p;
+                distance += delta;
+            }
+        }
+        if (progress) {
+            std::cerr << "[odgi::path_locality_order] iteration " << iteration + 1 << " distance " << distance << std::endl;
+        }
+        if (distance >= start_distance) {
+            break;
+        }
+    }
+    std::vector<handle_t> refined(n);
+    for (uint64_t p = 0; p < n; ++p) {
+        refined[p] = order[at[p]];
+    }
+    return refined;
+}
+
+uint64_t path_step_distance(const PathHandleGraph& graph, const std::vector<handle_t>& order) {
+    std::vector<uint64_t> index = order_index(graph, order);
+    nid_t min_id = graph.min_node_id();
+    uint64_t distance = 0;
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+            bool first = true;
+            uint64_t last = 0;
+            graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+                    uint64_t curr = index[graph.get_id(graph.get_handle_of_step(step)) - min_id];
+                    if (!first) {
+                        distance += curr > last ? curr - last : last - curr;
+                    }
+                    first = false;
+                    last = curr;
+                });
+        });
+    return distance;
+}
+
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <omp.h>
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+// refine the current order of the graph so that consecutive steps of its paths fall on nearby ranks,
+// minimizing the summed rank distance between them, with each pair of nodes weighted by how often
+// the paths step between them
+// each iteration moves every node toward the weighted median rank of its path neighbors, keeping the
+// move only if it lowers the total distance, and then swaps adjacent nodes while that lowers it
+std::vector<handle_t> path_locality_order(const PathHandleGraph& graph,
+                                          uint64_t iterations,
+                                          uint64_t num_threads,
+                                          bool progress);
+
+// the summed rank distance between consecutive path steps, weighted by the number of times the
+// paths step between each pair of nodes, for the given order of the graph
+uint64_t path_step_distance(const PathHandleGraph& graph, const std::vector<handle_t>& order);
+
+}
+
+}
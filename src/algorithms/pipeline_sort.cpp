@@ -0,0 +1,200 @@
+#include "pipeline_sort.hpp"
+#include "odgi.hpp"
+#include "topological_sort.hpp"
+#include "eades_algorithm.hpp"
+#include "cycle_breaking_sort.hpp"
+#include "dagify_sort.hpp"
+#include "random_order.hpp"
+#include "mondriaan_sort.hpp"
+#include "linear_sgd.hpp"
+#include "multilevel_sgd.hpp"
+#include "path_locality_sort.hpp"
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+namespace odgi {
+
+namespace algorithms {
+
+bool is_pipeline_sort(char sort) {
+    return sort != '\0' && std::strchr("snedcbzwrSUfml", sort) != nullptr;
+}
+
+std::vector<handle_t> pipeline_sort_order(const PathHandleGraph& graph, char sort,
+                                          const pipeline_sort_params_t& params) {
+    std::vector<handle_t> order;
+    switch (sort) {
+    case 's':
+        if (params.frontier_topological) {
+            order = parallel_topological_order(&graph, true, false, params.progress, params.num_threads);
+            break;
+        }
+        order = topological_order(&graph, true, false, params.progress);
+        break;
+    case 'n':
+        if (params.frontier_topological) {
+            order = parallel_topological_order(&graph, false, false, params.progress, params.num_threads);
+            break;
+        }
+        order = topological_order(&graph, false, false, params.progress);
+        break;
+    case 'e':
+        order = eades_algorithm(&graph);
+        break;
+    case 'd':
+        order = dagify_sort(graph);
+        break;
+    case 'c':
+        order = cycle_breaking_sort(graph, params.num_threads);
+        break;
+    case 'b':
+        order = breadth_first_topological_order(graph, params.bf_chunk_size, true, false, params.num_threads);
+        break;
+    case 'z':
+        order = depth_first_topological_order(graph, params.df_chunk_size);
+        break;
+    case 'w':
+        order = two_way_topological_order(&graph);
+        break;
+    case 'r':
+        order = random_order(graph);
+        break;
+    case 'S':
+        if (params.sgd_path_sampling) {
+            order = path_linear_sgd_order(graph,
+                                          params.sgd_bandwidth,
+                                          params.sgd_sampling_rate,
+                                          params.sgd_iter_max,
+                                          params.sgd_eps,
+                                          params.sgd_delta,
+                                          params.num_threads,
+                                          params.sgd_seed,
+                                          params.sgd_deterministic,
+                                          params.sgd_batched);
+            break;
+        }
+        order = linear_sgd_order(graph,
+                                 params.sgd_bandwidth,
+                                 params.sgd_sampling_rate,
+                                 params.sgd_use_paths,
+                                 params.sgd_iter_max,
+                                 params.sgd_eps,
+                                 params.sgd_delta,
+                                 params.num_threads,
+                                 params.sgd_seed,
+                                 params.sgd_deterministic,
+                                 params.sgd_batched);
+        break;
+    case 'U':
+        order = multilevel_linear_sgd_order(graph,
+                                            params.sgd_bandwidth,
+                                            params.sgd_sampling_rate,
+                                            params.sgd_use_paths,
+                                            params.sgd_iter_max,
+                                            params.sgd_eps,
+                                            params.sgd_delta,
+                                            params.num_threads,
+                                            params.sgd_seed,
+                                            params.sgd_deterministic,
+                                            params.sgd_batched);
+        break;
+    case 'f':
+        graph.for_each_handle([&order](const handle_t& handle) {
+                order.push_back(handle);
+            });
+        std::reverse(order.begin(), order.end());
+        break;
+    case 'm':
+        order = mondriaan_sort(graph,
+                               params.mondriaan_n_parts,
+                               params.mondriaan_epsilon,
+                               params.mondriaan_path_weight, false);
+        break;
+    case 'l':
+        order = path_locality_order(graph, params.path_locality_iter_max, params.num_threads, params.progress);
+        break;
+    default:
+        break;
+    }
+    return order;
+}
+
+std::unique_ptr<topology_graph_t> ordered_topology(const PathHandleGraph& graph, const std::vector<handle_t>& order) {
+    std::unique_ptr<topology_graph_t> topology(new topology_graph_t());
+    nid_t min_id = graph.min_node_id();
+    std::vector<nid_t> new_id(graph.max_node_id() - min_id + 1, 0);
+    for (uint64_t i = 0; i < order.size(); ++i) {
+        new_id[graph.get_id(order[i]) - min_id] = i + 1;
+        topology->add_node(i + 1, nullptr, graph.get_length(order[i]));
+    }
+    auto id_of = [&](const handle_t& handle) {
+        return new_id[graph.get_id(handle) - min_id];
+    };
+    // add the edges as graph_t::apply_ordering does, so that the topology lists them in the same order
+    for (auto& handle : order) {
+        graph.follow_edges(handle, false, [&](const handle_t& next) {
+                topology->add_edge(id_of(handle), graph.get_is_reverse(handle),
+                                   id_of(next), graph.get_is_reverse(next));
+            });
+        graph.follow_edges(handle, true, [&](const handle_t& prev) {
+                topology->add_edge(id_of(prev), graph.get_is_reverse(prev),
+                                   id_of(handle), graph.get_is_reverse(handle));
+            });
+    }
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+            path_handle_t p = topology->add_path(graph.get_path_name(path), graph.get_is_circular(path));
+            graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+                    handle_t handle = graph.get_handle_of_step(step);
+                    topology->append_step(p, id_of(handle), graph.get_is_reverse(handle));
+                });
+        });
+    topology->index();
+    return topology;
+}
+
+std::vector<handle_t> pipeline_sort_order(const PathHandleGraph& graph, const std::string& pipeline,
+                                          const pipeline_sort_params_t& params,
+                                          const std::function<void(const PathHandleGraph&, uint64_t)>& after_stage) {
+    std::vector<handle_t> order;
+    if (pipeline.empty()) {
+        return order;
+    }
+    auto check_order = [&](const std::vector<handle_t>& stage_order, char sort) {
+        if (stage_order.size() != graph.get_node_count()) {
+            std::cerr << "[odgi::pipeline_sort_order] error: expected " << graph.get_node_count()
+                      << " handles in the order given by '" << sort << "' but got " << stage_order.size() << std::endl;
+            exit(1);
+        }
+    };
+    order = pipeline_sort_order(graph, pipeline[0], params);
+    check_order(order, pipeline[0]);
+    if (pipeline.size() == 1 && !after_stage) {
+        return order;
+    }
+    // the node at each rank of the topology is the one at the same position in the order
+    std::unique_ptr<topology_graph_t> topology = ordered_topology(graph, order);
+    if (after_stage) {
+        after_stage(*topology, 0);
+    }
+    for (uint64_t k = 1; k < pipeline.size(); ++k) {
+        std::vector<handle_t> stage_order = pipeline_sort_order(*topology, pipeline[k], params);
+        check_order(stage_order, pipeline[k]);
+        std::vector<handle_t> composed(order.size());
+        for (uint64_t i = 0; i < stage_order.size(); ++i) {
+            composed[i] = order[topology->get_rank(stage_order[i])];
+        }
+        order.swap(composed);
+        if (k + 1 < pipeline.size() || after_stage) {
+            topology->apply_ordering(stage_order);
+        }
+        if (after_stage) {
+            after_stage(*topology, k);
+        }
+    }
+    return order;
+}
+
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <handlegraph/path_handle_graph.hpp>
+#include <vector>
+#include <string>
+#include <limits>
+#include <random>
+#include <functional>
+#include <memory>
+#include "topology_graph.hpp"
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+// the settings of the sorts that make up an odgi sort pipeline
+struct pipeline_sort_params_t {
+    bool progress = false;
+    uint64_t bf_chunk_size = std::numeric_limits<uint64_t>::max();
+    uint64_t df_chunk_size = 1000;
+    uint64_t sgd_bandwidth = 1000;
+    double sgd_sampling_rate = 20;
+    bool sgd_use_paths = false;
+    bool sgd_path_sampling = false;
+    uint64_t sgd_iter_max = 30;
+    double sgd_eps = 0.01;
+    double sgd_delta = 0;
+    // the SGD sorts are seeded from here, so a pipeline is reproducible when this is set
+    uint64_t sgd_seed = std::random_device()();
+    bool sgd_deterministic = false;
+    bool sgd_batched = false;
+    uint64_t num_threads = 1;
+    // run 's' and 'n' with parallel_topological_order, whose order differs from topological_order's
+    // but is the same for any number of threads, rather than with topological_order
+    bool frontier_topological = false;
+    uint64_t mondriaan_n_parts = 0;
+    double mondriaan_epsilon = 0;
+    bool mondriaan_path_weight = false;
+    uint64_t path_locality_iter_max = 10;
+};
+
+// true if the character names a sort we can apply in a pipeline
+bool is_pipeline_sort(char sort);
+
+// compute the order given by the pipeline sort named by the character,
+// 's' being the default topological sort and 'f' the reverse of the current order
+std::vector<handle_t> pipeline_sort_order(const PathHandleGraph& graph, char sort,
+                                          const pipeline_sort_params_t& params);
+
+// the topology of the graph with node ids 1..n following the order, which must hold every node once,
+// as graph.apply_ordering(order, true) would leave it down to the order of each node's edges
+// nodes keep their lengths but not their sequences
+std::unique_ptr<topology_graph_t> ordered_topology(const PathHandleGraph& graph, const std::vector<handle_t>& order);
+
+// compute the order given by applying the sorts of the pipeline one after another
+// the first sort runs on the graph, and the later ones on its topology relabeled by the order so far,
+// so the permutations compose without rebuilding the graph, which can then be reordered once
+// if given, after_stage is called after each sort with the graph as it would be sorted so far
+std::vector<handle_t> pipeline_sort_order(const PathHandleGraph& graph, const std::string& pipeline,
+                                          const pipeline_sort_params_t& params,
+                                          const std::function<void(const PathHandleGraph&, uint64_t)>& after_stage = nullptr);
+
+}
+
+}
@@ -0,0 +1,312 @@
+#include "sgd_2d.hpp"
+
+namespace odgi {
+namespace algorithms {
+
+// the terms are visited in blocks of this many, with the blocks in a random order in each iteration
+static const uint64_t sgd_2d_block_size = 4096;
+static const uint32_t sgd_2d_unreached = std::numeric_limits<uint32_t>::max();
+
+// the undirected adjacency of the graph, as offsets into a flat list of neighbors
+struct sgd_2d_adjacency_t {
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> neighbors;
+};
+
+static sgd_2d_adjacency_t sgd_2d_adjacency(uint64_t n, const std::vector<uint64_t>& I, const std::vector<uint64_t>& J) {
+    sgd_2d_adjacency_t adj;
+    adj.offsets.assign(n + 1, 0);
+    for (uint64_t k = 0; k < I.size(); ++k) {
+        if (I[k] == J[k]) continue;
+        ++adj.offsets[I[k] + 1];
+        ++adj.offsets[J[k] + 1];
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        adj.offsets[i + 1] += adj.offsets[i];
+    }
+    adj.neighbors.resize(adj.offsets[n]);
+    std::vector<uint64_t> fill(adj.offsets.begin(), adj.offsets.end() - 1);
+    for (uint64_t k = 0; k < I.size(); ++k) {
+        if (I[k] == J[k]) continue;
+        adj.neighbors[fill[I[k]]++] = J[k];
+        adj.neighbors[fill[J[k]]++] = I[k];
+    }
+    return adj;
+}
+
+// write the hop distance of each node from the source into dist, using queue as scratch space
+static void sgd_2d_bfs(const sgd_2d_adjacency_t& adj, uint64_t source, uint32_t* dist, std::vector<uint64_t>& queue) {
+    uint64_t n = adj.offsets.size() - 1;
+    std::fill(dist, dist + n, sgd_2d_unreached);
+    queue.clear();
+    queue.push_back(source);
+    dist[source] = 0;
+    for (uint64_t q = 0; q < queue.size(); ++q) {
+        uint64_t u = queue[q];
+        uint32_t d = dist[u] + 1;
+        for (uint64_t k = adj.offsets[u]; k < adj.offsets[u + 1]; ++k) {
+            uint64_t v = adj.neighbors[k];
+            if (dist[v] == sgd_2d_unreached) {
+                dist[v] = d;
+                queue.push_back(v);
+            }
+        }
+    }
+}
+
+// move node i toward distance d from node j
+// only i moves, as each pair of nodes that should both move appears as two terms
+static inline void sgd_2d_update(std::atomic<double>* X, uint64_t i, uint64_t j, double d, double w, double eta) {
+    double x_i = X[2 * i].load(std::memory_order_relaxed);
+    double y_i = X[2 * i + 1].load(std::memory_order_relaxed);
+    double dx = x_i - X[2 * j].load(std::memory_order_relaxed);
+    double dy = y_i - X[2 * j + 1].load(std::memory_order_relaxed);
+    double mag = std::sqrt(dx * dx + dy * dy);
+    if (mag == 0) return;
+    double mu = std::min(w * eta, 1.0);
+    double r = mu * (mag - d) / mag;
+    X[2 * i].store(x_i - r * dx, std::memory_order_relaxed);
+    X[2 * i + 1].store(y_i - r * dy, std::memory_order_relaxed);
+}
+
+// move nodes i and j toward distance d from each other, each by half of the correction
+static inline void sgd_2d_update_pair(std::atomic<double>* X, uint64_t i, uint64_t j, double d, double w, double eta) {
+    double x_i = X[2 * i].load(std::memory_order_relaxed);
+    double y_i = X[2 * i + 1].load(std::memory_order_relaxed);
+    double x_j = X[2 * j].load(std::memory_order_relaxed);
+    double y_j = X[2 * j + 1].load(std::memory_order_relaxed);
+    double dx = x_i - x_j;
+    double dy = y_i - y_j;
+    double mag = std::sqrt(dx * dx + dy * dy);
+    if (mag == 0) return;
+    double mu = std::min(w * eta, 1.0);
+    double r = mu * (mag - d) / (2 * mag);
+    X[2 * i].store(x_i - r * dx, std::memory_order_relaxed);
+    X[2 * i + 1].store(y_i - r * dy, std::memory_order_relaxed);
+    X[2 * j].store(x_j + r * dx, std::memory_order_relaxed);
+    X[2 * j + 1].store(y_j + r * dy, std::memory_order_relaxed);
+}
+
+void sgd_2d_layout(uint64_t n, double* X, const std::vector<uint64_t>& I, const std::vector<uint64_t>& J,
+                   uint64_t pivots, uint64_t t_max, uint64_t iters, double eps, uint64_t nthreads, uint64_t seed,
+                   const std::vector<bool>& fixed) {
+    iters = std::min(iters, t_max);
+    if (n < 2 || iters == 0) return;
+    auto is_fixed = [&](uint64_t i) { return !fixed.empty() && fixed[i]; };
+    std::vector<uint64_t> moving;
+    for (uint64_t i = 0; i < n; ++i) {
+        if (!is_fixed(i)) moving.push_back(i);
+    }
+    if (moving.empty()) return;
+    sgd_2d_adjacency_t adj = sgd_2d_adjacency(n, I, J);
+    std::mt19937_64 rng(seed);
+    bool sparse = pivots > 0 && pivots < n;
+    // the sources of the distances are every node, or a random sample of pivots
+    std::vector<uint64_t> sources(n);
+    std::iota(sources.begin(), sources.end(), 0);
+    if (sparse) {
+        for (uint64_t p = 0; p < pivots; ++p) {
+            std::swap(sources[p], sources[p + rng() % (n - p)]);
+        }
+        sources.resize(pivots);
+    }
+    uint64_t source_count = sources.size();
+    // the distances from each source, one row per source
+    std::vector<uint32_t> dist(source_count * n);
+#pragma omp parallel num_threads(nthreads)
+    {
+        std::vector<uint64_t> queue;
+        queue.reserve(n);
+#pragma omp for schedule(dynamic, 1)
+        for (uint64_t p = 0; p < source_count; ++p) {
+            sgd_2d_bfs(adj, sources[p], &dist[p * n], queue);
+        }
+    }
+    // in the sparse model a pivot stands in for the nodes of its region, those closer to it than to
+    // any other pivot, and the term between node i and pivot p at distance d is weighted by the number
+    // of nodes in the region of p within d/2 of it, which we count from the histogram of its distances
+    std::vector<uint64_t> region_offset;
+    std::vector<uint64_t> region_counts;
+    if (sparse) {
+        std::vector<uint64_t> region(n);
+        std::vector<uint32_t> region_max(source_count, 0);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+        for (uint64_t i = 0; i < n; ++i) {
+            uint64_t best = 0;
+            for (uint64_t p = 1; p < source_count; ++p) {
+                if (dist[p * n + i] < dist[best * n + i]) best = p;
+            }
+            region[i] = best;
+        }
+        for (uint64_t i = 0; i < n; ++i) {
+            region_max[region[i]] = std::max(region_max[region[i]], dist[region[i] * n + i]);
+        }
+        region_offset.resize(source_count + 1, 0);
+        for (uint64_t p = 0; p < source_count; ++p) {
+            region_offset[p + 1] = region_offset[p] + region_max[p] + 1;
+        }
+        region_counts.assign(region_offset.back(), 0);
+        for (uint64_t i = 0; i < n; ++i) {
+            ++region_counts[region_offset[region[i]] + dist[region[i] * n + i]];
+        }
+        for (uint64_t p = 0; p < source_count; ++p) {
+            for (uint64_t k = region_offset[p] + 1; k < region_offset[p + 1]; ++k) {
+                region_counts[k] += region_counts[k - 1];
+            }
+        }
+    }
+    auto source_weight = [&](uint64_t p, uint32_t d) {
+        double s = 1;
+        if (sparse) {
+            s = region_counts[region_offset[p] + std::min((uint64_t)d / 2, region_offset[p + 1] - region_offset[p] - 1)];
+        }
+        return s / ((double)d * d);
+    };
+    // each term moves one node, so we only keep those that move a node that isn't fixed
+    // the edge terms come first, from either end, then the terms of each source over the moving nodes
+    // the terms of one source all move different nodes, so their order within a block doesn't matter
+    std::vector<std::pair<uint64_t, uint64_t>> edge_terms;
+    if (sparse) {
+        for (uint64_t k = 0; k < I.size(); ++k) {
+            if (I[k] == J[k]) continue;
+            if (!is_fixed(I[k])) edge_terms.push_back(std::make_pair(I[k], J[k]));
+            if (!is_fixed(J[k])) edge_terms.push_back(std::make_pair(J[k], I[k]));
+        }
+    }
+    uint64_t edge_term_count = edge_terms.size();
+    uint64_t moving_count = moving.size();
+    uint64_t term_count = edge_term_count + source_count * moving_count;
+    double w_min = sparse ? 1.0 : std::numeric_limits<double>::max();
+    double w_max = sparse ? 1.0 : 0.0;
+#pragma omp parallel for schedule(static) num_threads(nthreads) reduction(min:w_min) reduction(max:w_max)
+    for (uint64_t u = 0; u < source_count * moving_count; ++u) {
+        uint64_t p = u / moving_count;
+        uint32_t d = dist[p * n + moving[u % moving_count]];
+        if (d == 0 || d == sgd_2d_unreached) continue;
+        double w = source_weight(p, d);
+        w_min = std::min(w_min, w);
+        w_max = std::max(w_max, w);
+    }
+    if (w_max == 0) return;
+    // nb: the schedule needs at least two iterations to interpolate between its bounds
+    std::vector<double> etas = linear_sgd_schedule(w_min, w_max, std::max(t_max, (uint64_t)2), eps);
+    std::vector<std::atomic<double>> Y(2 * n);
+    for (uint64_t i = 0; i < 2 * n; ++i) {
+        Y[i].store(X[i], std::memory_order_relaxed);
+    }
+    uint64_t block_count = (term_count + sgd_2d_block_size - 1) / sgd_2d_block_size;
+    std::vector<uint64_t> block_order(block_count);
+    std::iota(block_order.begin(), block_order.end(), 0);
+    // we run the last iters iterations of the schedule, as a layout we continue only needs to settle
+    for (uint64_t t = t_max - iters; t < t_max; ++t) {
+        std::shuffle(block_order.begin(), block_order.end(), rng);
+        double eta = etas[t];
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+        for (uint64_t b = 0; b < block_count; ++b) {
+            uint64_t begin = block_order[b] * sgd_2d_block_size;
+            uint64_t end = std::min(begin + sgd_2d_block_size, term_count);
+            for (uint64_t k = begin; k < end; ++k) {
+                if (k < edge_term_count) {
+                    sgd_2d_update(Y.data(), edge_terms[k].first, edge_terms[k].second, 1.0, 1.0, eta);
+                } else {
+                    uint64_t u = k - edge_term_count;
+                    uint64_t p = u / moving_count;
+                    uint64_t i = moving[u % moving_count];
+                    uint32_t d = dist[p * n + i];
+                    if (d == 0 || d == sgd_2d_unreached) continue;
+                    sgd_2d_update(Y.data(), i, sources[p], d, source_weight(p, d), eta);
+                }
+            }
+        }
+    }
+    for (uint64_t i = 0; i < 2 * n; ++i) {
+        X[i] = Y[i].load(std::memory_order_relaxed);
+    }
+}
+
+std::vector<double> path_sgd_2d_layout(const handlegraph::PathHandleGraph& graph,
+                                       const xp::XP& path_index,
+                                       const uint64_t& bandwidth,
+                                       const double& sampling_rate,
+                                       const uint64_t& t_max,
+                                       const double& eps,
+                                       const uint64_t& nthreads,
+                                       const uint64_t& seed) {
+    uint64_t n = graph.get_node_count();
+    std::vector<std::atomic<double>> X(2 * n);
+    // we start from the graph order in x, with y spread over about a node length so that the layout can unfold
+    uint64_t len = 0;
+    graph.for_each_handle([&](const handlegraph::handle_t& handle) {
+            // nb: we assume that the graph provides a compact handle set, as path_linear_sgd does
+            X[2 * handlegraph::number_bool_packing::unpack_number(handle)].store(len, std::memory_order_relaxed);
+            len += graph.get_length(handle);
+        });
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> spread(0, n ? (double)len / n : 1.0);
+    for (uint64_t i = 0; i < n; ++i) {
+        X[2 * i + 1].store(spread(gen), std::memory_order_relaxed);
+    }
+    auto final_layout = [&](void) {
+        std::vector<double> layout(2 * n);
+        for (uint64_t i = 0; i < 2 * n; ++i) {
+            layout[i] = X[i].load(std::memory_order_relaxed);
+        }
+        return layout;
+    };
+    // cumulative step counts, so that we can pick a step uniformly across the paths
+    std::vector<xp::XPPath*> paths = path_index.get_paths();
+    std::vector<uint64_t> path_step_ends;
+    uint64_t total_steps = 0;
+    uint64_t max_path_length = 0;
+    for (auto& path : paths) {
+        total_steps += path->handles.size();
+        path_step_ends.push_back(total_steps);
+        max_path_length = std::max(max_path_length, (uint64_t)path->offsets.size());
+    }
+    if (total_steps == 0 || t_max == 0) {
+        return final_layout();
+    }
+    // partners are at least 1 bp apart, and at most the bandwidth or the longest path, which bounds the weights
+    double max_d = std::max((uint64_t)1, bandwidth ? std::min(bandwidth, max_path_length) : max_path_length);
+    std::vector<double> etas = linear_sgd_schedule(1.0 / (max_d * max_d), 1.0, std::max(t_max, (uint64_t)2), eps);
+    uint64_t updates_per_iteration = std::max((uint64_t)1, (uint64_t)(total_steps * sampling_rate));
+#pragma omp parallel num_threads(nthreads)
+    {
+        // seed_seq keeps only the low 32 bits of each value, so we pass the seed as two words
+        std::seed_seq thread_seed{(uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)omp_get_thread_num()};
+        std::mt19937 gen(thread_seed);
+        for (uint64_t t = 0; t < t_max; ++t) {
+            double eta = etas[t];
+#pragma omp for schedule(static)
+            for (uint64_t k = 0; k < updates_per_iteration; ++k) {
+                uint64_t step = std::uniform_int_distribution<uint64_t>(0, total_steps-1)(gen);
+                uint64_t p = std::upper_bound(path_step_ends.begin(), path_step_ends.end(), step) - path_step_ends.begin();
+                const xp::XPPath& path = *paths[p];
+                uint64_t rank = step - (p ? path_step_ends[p-1] : 0);
+                // our partner is the step covering a position within the bandwidth, or anywhere, along the path
+                int64_t path_length = path.offsets.size();
+                int64_t pos_i = path.offsets_select(rank+1);
+                int64_t pos_j = bandwidth
+                    ? pos_i + std::uniform_int_distribution<int64_t>(-(int64_t)bandwidth, bandwidth)(gen)
+                    : std::uniform_int_distribution<int64_t>(0, path_length - 1)(gen);
+                if (pos_j < 0 || pos_j >= path_length) {
+                    continue;
+                }
+                uint64_t rank_j = path.step_rank_at_position(pos_j);
+                uint64_t i = handlegraph::number_bool_packing::unpack_number(path.handle(rank));
+                uint64_t j = handlegraph::number_bool_packing::unpack_number(path.handle(rank_j));
+                if (i == j) {
+                    continue;
+                }
+                // the path distance between the starts of the steps
+                double d = std::abs((int64_t)path.offsets_select(rank_j+1) - pos_i);
+                // both ends move, as we sample each pair from one side only
+                sgd_2d_update_pair(X.data(), i, j, d, 1.0 / (d * d), eta);
+            }
+        }
+    }
+    return final_layout();
+}
+
+}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+ * \file sgd_2d.hpp
+ *
+ * Parallel SGD for 2D stress majorization of a connected graph
+ */
+
+#include <vector>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <omp.h>
+#include <handlegraph/path_handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include "linear_sgd.hpp"
+#include "xp.hpp"
+
+namespace odgi {
+namespace algorithms {
+
+/// Lay out the connected graph of n nodes with the undirected edges (I[k], J[k]) in 2D, reducing the
+/// stress of X (x and y interleaved, holding the initial layout) against the hop distances in the graph.
+/// With pivots == 0 every pair of nodes gives a term, which costs O(n^2) memory and time per iteration.
+/// Otherwise the terms are the edges and the distances to that many random pivots, weighted by the size
+/// of the region each pivot stands for, following the sparse stress model of Ortmann et al.
+/// The distances come from one BFS per source, run in parallel, and the updates run Hogwild style over
+/// blocks of terms shuffled each iteration, so the result depends on thread timing when nthreads > 1.
+/// Only the last iters iterations of the schedule for t_max are run, which lets us continue from a layout
+/// we already have, and nodes marked in fixed (which may be empty) keep their position.
+void sgd_2d_layout(uint64_t n, double* X, const std::vector<uint64_t>& I, const std::vector<uint64_t>& J,
+                   uint64_t pivots, uint64_t t_max, uint64_t iters, double eps, uint64_t nthreads, uint64_t seed,
+                   const std::vector<bool>& fixed);
+
+/// Lay out the graph in 2D with SGD over pairs of steps sampled on the fly from the paths, taking their target
+/// distance from the path index as the distance in bp between the starts of the steps along the path.
+/// This is the 2D analogue of path_linear_sgd, needing memory only for the positions and the index.
+/// The partner of a step lies within bandwidth bp of it on the path, or anywhere on the path if bandwidth is 0,
+/// and sampling_rate gives the number of terms to sample per path step in each iteration.
+/// The layout is indexed by node rank, with x and y interleaved. Nodes start out in the graph order in x,
+/// so those on no path stay there.
+std::vector<double> path_sgd_2d_layout(const handlegraph::PathHandleGraph& graph,
+                                       const xp::XP& path_index,
+                                       const uint64_t& bandwidth,
+                                       const double& sampling_rate,
+                                       const uint64_t& t_max,
+                                       const double& eps,
+                                       const uint64_t& nthreads,
+                                       const uint64_t& seed);
+
+}
+}
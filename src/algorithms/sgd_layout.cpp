@@ -1,69 +1,257 @@
 #include "sgd_layout.hpp"
-#include "sgd2.hpp"
 
 namespace odgi {
 namespace algorithms {
 
 using namespace handlegraph;
 
-std::vector<double> sgd_layout(const HandleGraph& graph, uint64_t pivots, uint64_t t_max, double eps, double x_padding) {
-    std::vector<double> layout(graph.get_node_count()*2);
-    double max_x = 0;
-    auto weak_components = algorithms::weakly_connected_components(&graph);
-    for (auto& weak_component : weak_components) {
-        std::vector<handlegraph::nid_t> component_ids;
-        ska::flat_hash_map<handlegraph::nid_t, uint64_t> local_id;
-        for (auto& id : weak_component) {
-            component_ids.push_back(id);
+// all-pairs layout takes quadratic space, so bigger components fall back to this many pivots
+static const uint64_t max_all_pairs_nodes = 10000;
+static const uint64_t fallback_pivots = 30;
+// in a layout we start from, edges longer than this have been changed, as the layout gives edges about unit length
+static const double max_kept_edge_length = 3.0;
+
+// place the nodes of a component that have no position in the layout we start from at the mean of their placed
+// neighbors, in waves out from the placed nodes, and return the nodes that are more than radius hops from a change
+// as fixed, a change being a node we had to place or a node on a stretched edge
+static std::vector<bool> warm_start_component(std::vector<double>& X, std::vector<bool> placed,
+                                              const std::vector<uint64_t>& I, const std::vector<uint64_t>& J,
+                                              uint64_t radius, std::mt19937& rng) {
+    uint64_t n = placed.size();
+    std::vector<uint64_t> offsets(n+1, 0);
+    for (uint64_t k = 0; k < I.size(); ++k) {
+        ++offsets[I[k]+1];
+        ++offsets[J[k]+1];
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        offsets[i+1] += offsets[i];
+    }
+    std::vector<uint64_t> neighbors(offsets[n]);
+    std::vector<uint64_t> fill(offsets.begin(), offsets.end()-1);
+    for (uint64_t k = 0; k < I.size(); ++k) {
+        neighbors[fill[I[k]]++] = J[k];
+        neighbors[fill[J[k]]++] = I[k];
+    }
+    std::vector<uint64_t> changed;
+    for (uint64_t i = 0; i < n; ++i) {
+        if (!placed[i]) changed.push_back(i);
+    }
+    for (uint64_t k = 0; k < I.size(); ++k) {
+        uint64_t a = I[k];
+        uint64_t b = J[k];
+        if (placed[a] && placed[b]
+            && std::hypot(X[2*a] - X[2*b], X[2*a+1] - X[2*b+1]) > max_kept_edge_length) {
+            changed.push_back(a);
+            changed.push_back(b);
         }
-        std::sort(component_ids.begin(), component_ids.end());
-        for (uint64_t i = 0; i < component_ids.size(); ++i) {
-            local_id[component_ids[i]] = i;
+    }
+    // each wave is placed from the nodes placed before it, so the result doesn't depend on the order within it
+    std::uniform_real_distribution<double> jitter(-0.5, 0.5);
+    std::vector<bool> queued(placed);
+    std::vector<uint64_t> wave;
+    auto queue_neighbors = [&](uint64_t i, std::vector<uint64_t>& next) {
+        for (uint64_t k = offsets[i]; k < offsets[i+1]; ++k) {
+            uint64_t j = neighbors[k];
+            if (!queued[j]) {
+                queued[j] = true;
+                next.push_back(j);
+            }
         }
-        // convert to input format for SGD
-        std::vector<uint64_t> I, J;
-        graph.for_each_edge([&](const edge_t& e) {
-                if (weak_component.count(graph.get_id(e.first))
-                    && weak_component.count(graph.get_id(e.first))) {
-                    I.push_back(local_id[graph.get_id(e.first)]);
-                    J.push_back(local_id[graph.get_id(e.second)]);
+    };
+    for (uint64_t i = 0; i < n; ++i) {
+        if (placed[i]) queue_neighbors(i, wave);
+    }
+    while (!wave.empty()) {
+        for (auto& i : wave) {
+            double x = 0, y = 0;
+            uint64_t count = 0;
+            for (uint64_t k = offsets[i]; k < offsets[i+1]; ++k) {
+                uint64_t j = neighbors[k];
+                if (placed[j]) {
+                    x += X[2*j];
+                    y += X[2*j+1];
+                    ++count;
                 }
-            });
-        uint64_t n = weak_component.size();
-        std::vector<double> X(2*n);
+            }
+            X[2*i] = x / count + jitter(rng);
+            X[2*i+1] = y / count + jitter(rng);
+        }
+        std::vector<uint64_t> next;
+        for (auto& i : wave) {
+            placed[i] = true;
+            queue_neighbors(i, next);
+        }
+        wave.swap(next);
+    }
+    std::vector<bool> fixed;
+    if (radius == std::numeric_limits<uint64_t>::max()) {
+        return fixed;
+    }
+    // a breadth first search out from the changes marks the nodes we keep moving
+    fixed.assign(n, true);
+    std::vector<uint64_t> depth(n, 0);
+    std::vector<uint64_t> queue;
+    for (auto& i : changed) {
+        if (fixed[i]) {
+            fixed[i] = false;
+            queue.push_back(i);
+        }
+    }
+    for (uint64_t q = 0; q < queue.size(); ++q) {
+        uint64_t i = queue[q];
+        if (depth[i] == radius) continue;
+        for (uint64_t k = offsets[i]; k < offsets[i+1]; ++k) {
+            uint64_t j = neighbors[k];
+            if (fixed[j]) {
+                fixed[j] = false;
+                depth[j] = depth[i] + 1;
+                queue.push_back(j);
+            }
+        }
+    }
+    return fixed;
+}
+
+std::vector<double> sgd_layout(const HandleGraph& graph, uint64_t pivots, uint64_t t_max, double eps, double x_padding,
+                               uint64_t num_threads, const layout_t* start, uint64_t relayout_radius) {
+    // the layout is indexed by id, so the ids must be compacted to 1..n
+    uint64_t node_count = graph.get_node_count();
+    if (node_count && (graph.min_node_id() != 1 || graph.max_node_id() != (nid_t)node_count)) {
+        std::cerr << "[odgi::algorithms::sgd_layout] error: the node ids run from " << graph.min_node_id()
+                  << " to " << graph.max_node_id() << " over " << node_count
+                  << " nodes, but must be compacted to 1.." << node_count << std::endl;
+        exit(1);
+    }
+    std::vector<double> layout(node_count*2);
+    std::vector<uint64_t> component_sizes;
+    std::vector<uint64_t> labels = algorithms::weakly_connected_component_labels(&graph, component_sizes, num_threads);
+    uint64_t component_count = component_sizes.size();
+    // label each node with its component, and number it within the component in id order
+    std::vector<uint64_t> component_of(node_count);
+    graph.for_each_handle([&](const handle_t& handle) {
+            component_of[graph.get_id(handle)-1] = labels[number_bool_packing::unpack_number(handle)];
+        });
+    std::vector<uint64_t>().swap(labels);
+    std::vector<uint64_t> local_id(node_count);
+    std::vector<std::vector<handlegraph::nid_t>> component_ids(component_count);
+    for (uint64_t c = 0; c < component_count; ++c) {
+        component_ids[c].reserve(component_sizes[c]);
+    }
+    for (uint64_t i = 0; i < node_count; ++i) {
+        auto& ids = component_ids[component_of[i]];
+        local_id[i] = ids.size();
+        ids.push_back(i+1);
+    }
+    // convert to input format for SGD, partitioning the edges by component in one pass
+    std::vector<std::vector<uint64_t>> I(component_count), J(component_count);
+    graph.for_each_edge([&](const edge_t& e) {
+            uint64_t a = graph.get_id(e.first)-1;
+            uint64_t b = graph.get_id(e.second)-1;
+            uint64_t c = component_of[a];
+            I[c].push_back(local_id[a]);
+            J[c].push_back(local_id[b]);
+        });
+    // lay out the components in parallel, biggest first, so that the last ones to start are short
+    std::vector<uint64_t> by_size(component_count);
+    for (uint64_t c = 0; c < component_count; ++c) by_size[c] = c;
+    std::sort(by_size.begin(), by_size.end(), [&](const uint64_t& a, const uint64_t& b) {
+            return component_ids[a].size() > component_ids[b].size()
+                || (component_ids[a].size() == component_ids[b].size() && a < b);
+        });
+    std::vector<std::vector<double>> component_X(component_count);
+    // the components with nodes in the layout we start from, which keep their place
+    std::vector<bool> warm_started(component_count, false);
+    if (start) {
+        for (uint64_t i = 0; i < node_count; ++i) {
+            if (start->has(i+1)) warm_started[component_of[i]] = true;
+        }
+    }
+    auto layout_component = [&](uint64_t c, uint64_t threads) {
+        uint64_t n = component_ids[c].size();
+        std::vector<double>& X = component_X[c];
+        X.resize(2*n);
         std::random_device dev;
         // todo, seed with graph topology/contents to get a more stable result
         std::mt19937 rng(dev());
-        std::uniform_real_distribution<double> dist(0,1);
-        for (uint64_t i = 0; i < 2*n; ++i) {
-            X[i] = dist(rng);
+        std::vector<bool> placed(n, false);
+        if (warm_started[c]) {
+            for (uint64_t i = 0; i < n; ++i) {
+                nid_t id = component_ids[c][i];
+                if (start->has(id)) {
+                    X[2*i] = start->x(id);
+                    X[2*i+1] = start->y(id);
+                    placed[i] = true;
+                }
+            }
         }
         // do layout
-        if (pivots > 0) {
-            sgd2::layout_sparse_unweighted(n, X.data(), I.size(), I.data(), J.data(), pivots, t_max, eps);
+        uint64_t component_pivots = pivots == 0 && n > max_all_pairs_nodes ? fallback_pivots : pivots;
+        if (warm_started[c]) {
+            // the layout only has to settle around the changes, so we follow the end of the schedule
+            std::vector<bool> fixed = warm_start_component(X, placed, I[c], J[c], relayout_radius, rng);
+            sgd_2d_layout(n, X.data(), I[c], J[c], component_pivots, t_max, std::max((uint64_t)1, t_max/3), eps,
+                          threads, rng(), fixed);
         } else {
-            sgd2::layout_unweighted(n, X.data(), I.size(), I.data(), J.data(), t_max, eps);
+            std::uniform_real_distribution<double> dist(0,1);
+            for (uint64_t i = 0; i < 2*n; ++i) {
+                X[i] = dist(rng);
+            }
+            sgd_2d_layout(n, X.data(), I[c], J[c], component_pivots, t_max, t_max, eps, threads, rng(),
+                          std::vector<bool>());
         }
-
+        std::vector<uint64_t>().swap(I[c]);
+        std::vector<uint64_t>().swap(J[c]);
+    };
+    // components holding at least a thread's share of the nodes get all the threads, one after another,
+    // and the rest are laid out in parallel with one thread each
+    uint64_t big_count = 0;
+    while (num_threads > 1 && big_count < component_count
+           && component_ids[by_size[big_count]].size() * num_threads >= node_count) {
+        layout_component(by_size[big_count], num_threads);
+        ++big_count;
+    }
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t k = big_count; k < component_count; ++k) {
+        layout_component(by_size[k], 1);
+    }
+    // warm started components keep their coordinates, and we stitch the others together to their right
+    // in component order, each starting where the last one ended
+    double max_x = 0;
+    bool any_warm_started = false;
+    for (uint64_t c = 0; c < component_count; ++c) {
+        if (!warm_started[c]) continue;
+        auto& X = component_X[c];
+        uint64_t n = component_ids[c].size();
         for (uint64_t i = 0; i < 2*n; i+=2) {
-            //std::cerr << "i = " << i << std::endl;
-            uint64_t j = component_ids[i/2]-1;
-            layout[j*2] = X[i] + max_x;
+            uint64_t j = component_ids[c][i/2]-1;
+            layout[j*2] = X[i];
             layout[j*2+1] = X[i+1];
-            //std::cerr << "layout " << j << " " << layout[j*2] << " " << layout[j*2+1] << std::endl;
-        }
-        // set new max_x
-        for (uint64_t i = 0; i < 2*n; i+=2) {
-            max_x = std::max(X[i], max_x);
+            max_x = any_warm_started ? std::max(X[i], max_x) : X[i];
+            any_warm_started = true;
         }
+        std::vector<double>().swap(X);
+    }
+    if (any_warm_started) {
         max_x += x_padding;
     }
-    // all the weakly connected component layouts have been merged here
-    /*
-    for (uint64_t i = 0; i < layout.size(); i+=2) {
-        std::cerr << i/2 << " " << layout[i] << " " << layout[i+1] << std::endl;
+    for (uint64_t c = 0; c < component_count; ++c) {
+        if (warm_started[c]) continue;
+        auto& X = component_X[c];
+        uint64_t n = component_ids[c].size();
+        double min_x = X[0];
+        for (uint64_t i = 0; i < 2*n; i+=2) {
+            min_x = std::min(X[i], min_x);
+        }
+        double width = 0;
+        for (uint64_t i = 0; i < 2*n; i+=2) {
+            uint64_t j = component_ids[c][i/2]-1;
+            layout[j*2] = X[i] - min_x + max_x;
+            layout[j*2+1] = X[i+1];
+            width = std::max(X[i] - min_x, width);
+        }
+        max_x += width + x_padding;
+        std::vector<double>().swap(X);
     }
-    */
     return layout;
 }
 
@@ -9,14 +9,29 @@
 #include <handlegraph/handle_graph.hpp>
 #include <vector>
 #include <random>
+#include <algorithm>
+#include <omp.h>
 #include "weakly_connected_components.hpp"
+#include "sgd_2d.hpp"
+#include "layout.hpp"
 
 namespace odgi {
 namespace algorithms {
 
 using namespace handlegraph;
 
-std::vector<double> sgd_layout(const HandleGraph& graph, uint64_t pivots, uint64_t t_max, double eps, double x_padding);
+/// Lay out each weakly connected component with SGD and place them side by side in x, separated by
+/// x_padding. Components of at least 1/num_threads of the nodes are laid out using all the threads,
+/// the others in parallel. With pivots == 0, components of more than 10000 nodes use 30 pivots, as
+/// all-pairs layout takes quadratic space. Ids must be compacted to 1..n, and we exit with an error if they
+/// aren't; after deleting nodes, compact them in their order and renumber the layout with layout_t::compacted.
+/// Given a layout to start from, components with nodes in it keep their place and follow the last third of
+/// the SGD schedule, with their other nodes starting at the mean of their placed neighbors. If relayout_radius
+/// is set, only the nodes within that many hops of such a new node, or of an edge stretched in the layout we
+/// start from, are moved, which lets us lay out a graph again quickly after small edits.
+std::vector<double> sgd_layout(const HandleGraph& graph, uint64_t pivots, uint64_t t_max, double eps, double x_padding,
+                               uint64_t num_threads = 1, const layout_t* start = nullptr,
+                               uint64_t relayout_radius = std::numeric_limits<uint64_t>::max());
 
 }
 }
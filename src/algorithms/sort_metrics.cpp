@@ -0,0 +1,119 @@
+#include "sort_metrics.hpp"
+
+namespace odgi {
+
+namespace algorithms {
+
+sort_metrics_t sort_metrics(const PathHandleGraph& graph, uint64_t num_threads) {
+    sort_metrics_t metrics;
+    if (graph.get_node_count() == 0) {
+        return metrics;
+    }
+    nid_t min_id = graph.min_node_id();
+    nid_t max_id = graph.max_node_id();
+    std::vector<handle_t> handles;
+    handles.reserve(graph.get_node_count());
+    graph.for_each_handle([&](const handle_t& handle) { handles.push_back(handle); });
+
+    // the start of each node when we lay them out end to end in id order
+    std::vector<uint64_t> starts(max_id - min_id + 2, 0);
+    for (auto& handle : handles) {
+        starts[graph.get_id(handle) - min_id + 1] = graph.get_length(handle);
+    }
+    for (uint64_t i = 1; i < starts.size(); ++i) {
+        starts[i] += starts[i - 1];
+    }
+
+    uint64_t edge_count = 0;
+    uint64_t edge_delta_sum = 0;
+    uint64_t max_edge_delta = 0;
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads) reduction(+:edge_count,edge_delta_sum) reduction(max:max_edge_delta)
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        const handle_t& handle = handles[i];
+        nid_t id = graph.get_id(handle);
+        // count each edge from the side of its node with the lower id, as for_each_edge does
+        auto count_edge = [&](const nid_t& other_id) {
+            uint64_t delta = std::abs(other_id - id);
+            ++edge_count;
+            edge_delta_sum += delta;
+            max_edge_delta = std::max(max_edge_delta, delta);
+        };
+        graph.follow_edges(handle, false, [&](const handle_t& next) {
+                nid_t next_id = graph.get_id(next);
+                if (id <= next_id) count_edge(next_id);
+            });
+        graph.follow_edges(handle, true, [&](const handle_t& prev) {
+                nid_t prev_id = graph.get_id(prev);
+                // a left-to-left self loop comes back on our own reverse strand; the other self loops were counted on the right
+                if (id < prev_id || (id == prev_id && graph.get_is_reverse(prev))) count_edge(prev_id);
+            });
+    }
+    metrics.edge_count = edge_count;
+    metrics.mean_edge_delta = edge_count ? (double)edge_delta_sum / edge_count : 0;
+    metrics.max_edge_delta = max_edge_delta;
+
+    std::vector<path_handle_t> paths;
+    graph.for_each_path_handle([&](const path_handle_t& path) { paths.push_back(path); });
+    uint64_t path_steps = 0;
+    uint64_t step_pairs = 0;
+    double stress_sum = 0;
+    uint64_t backward_steps = 0;
+    uint64_t path_jumps = 0;
+    uint64_t jump_sum = 0;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) reduction(+:path_steps,step_pairs,stress_sum,backward_steps,path_jumps,jump_sum)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        bool first = true;
+        nid_t last_id = 0;
+        uint64_t last_length = 0;
+        graph.for_each_step_in_path(paths[i], [&](const step_handle_t& step) {
+                handle_t handle = graph.get_handle_of_step(step);
+                nid_t id = graph.get_id(handle);
+                ++path_steps;
+                if (!first) {
+                    ++step_pairs;
+                    // the path distance between the starts of the steps is the length of the last one
+                    double path_distance = std::max((uint64_t)1, last_length);
+                    double order_distance = std::abs((double)starts[id - min_id] - (double)starts[last_id - min_id]);
+                    double error = (order_distance - path_distance) / path_distance;
+                    stress_sum += error * error;
+                    if (id < last_id) {
+                        ++backward_steps;
+                    }
+                    uint64_t jump = std::abs(id - last_id);
+                    if (jump > 1) {
+                        ++path_jumps;
+                    }
+                    jump_sum += jump;
+                }
+                first = false;
+                last_id = id;
+                last_length = graph.get_length(handle);
+            });
+    }
+    metrics.path_count = paths.size();
+    metrics.path_steps = path_steps;
+    metrics.path_stress = step_pairs ? stress_sum / step_pairs : 0;
+    metrics.backward_steps = backward_steps;
+    metrics.mean_backward_steps_per_path = paths.size() ? (double)backward_steps / paths.size() : 0;
+    metrics.path_jumps = path_jumps;
+    metrics.mean_path_jump = step_pairs ? (double)jump_sum / step_pairs : 0;
+    return metrics;
+}
+
+void write_sort_metrics_json(std::ostream& out, const sort_metrics_t& metrics) {
+    out << "{\"edge_count\": " << metrics.edge_count
+        << ", \"mean_edge_delta\": " << metrics.mean_edge_delta
+        << ", \"max_edge_delta\": " << metrics.max_edge_delta
+        << ", \"path_count\": " << metrics.path_count
+        << ", \"path_steps\": " << metrics.path_steps
+        << ", \"path_stress\": " << metrics.path_stress
+        << ", \"backward_steps\": " << metrics.backward_steps
+        << ", \"mean_backward_steps_per_path\": " << metrics.mean_backward_steps_per_path
+        << ", \"path_jumps\": " << metrics.path_jumps
+        << ", \"mean_path_jump\": " << metrics.mean_path_jump
+        << "}";
+}
+
+}
+
+}
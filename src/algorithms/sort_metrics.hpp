@@ -0,0 +1,47 @@
+#pragma once
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <algorithm>
+#include <cmath>
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+// measures of how well the node ids of a graph follow its topology and paths
+// a sorted graph has its ids compacted to its order, so these describe the sort
+struct sort_metrics_t {
+    uint64_t edge_count = 0;
+    // the absolute difference between the ids of the nodes on each edge
+    double mean_edge_delta = 0;
+    uint64_t max_edge_delta = 0;
+    uint64_t path_count = 0;
+    uint64_t path_steps = 0;
+    // the mean squared relative error of the distance in the order between the starts of consecutive
+    // path steps, with nodes laid out end to end in id order, against their distance along the path
+    double path_stress = 0;
+    // steps to a node with a lower id than the last one
+    uint64_t backward_steps = 0;
+    double mean_backward_steps_per_path = 0;
+    // steps to a node that isn't next to the last one in the order, which likely costs a cache miss
+    // when walking a path in a graph stored in id order, and the mean id difference across steps
+    uint64_t path_jumps = 0;
+    double mean_path_jump = 0;
+};
+
+// compute the sort metrics of the graph using the given number of threads
+sort_metrics_t sort_metrics(const PathHandleGraph& graph, uint64_t num_threads);
+
+// write the metrics as a JSON object
+void write_sort_metrics_json(std::ostream& out, const sort_metrics_t& metrics);
+
+}
+
+}
@@ -144,5 +144,96 @@ using namespace handlegraph;
         return components;
     }
 
+    // the same search over flat arrays indexed by as_integer(handle), without the hash tables,
+    // so that it keeps up with graphs of millions of nodes
+    vector<uint64_t> strongly_connected_component_labels(const HandleGraph& handle_graph) {
+        
+        const uint64_t unvisited = numeric_limits<uint64_t>::max();
+        uint64_t max_rank = 0;
+        handle_graph.for_each_handle([&](const handle_t& handle) {
+            max_rank = max(max_rank, (uint64_t)number_bool_packing::unpack_number(handle));
+        });
+        vector<uint64_t> labels(max_rank + 1, unvisited);
+        if (handle_graph.get_node_count() == 0) {
+            return labels;
+        }
+        // discovery index and lowest reachable index of each oriented handle
+        vector<uint64_t> discover_idx(2 * (max_rank + 1), unvisited);
+        vector<uint64_t> low(2 * (max_rank + 1), unvisited);
+        vector<bool> on_stack(2 * (max_rank + 1), false);
+        vector<handle_t> stack;
+        // the search frames, with their edges in a range of a shared stack of targets
+        struct frame_t {
+            handle_t handle;
+            uint64_t begin;
+            uint64_t next;
+            uint64_t end;
+        };
+        vector<frame_t> frames;
+        vector<handle_t> targets;
+        uint64_t index = 0;
+        uint64_t component_count = 0;
+        
+        auto discover = [&](const handle_t& trav) {
+            uint64_t i = as_integer(trav);
+            discover_idx[i] = low[i] = index++;
+            stack.push_back(trav);
+            on_stack[i] = true;
+            uint64_t begin = targets.size();
+            handle_graph.follow_edges(trav, false, [&](const handle_t& next) {
+                targets.push_back(next);
+            });
+            frames.push_back({trav, begin, begin, targets.size()});
+        };
+        
+        handle_graph.for_each_handle([&](const handle_t& handle) {
+            for (const handle_t& root : { handle, handle_graph.flip(handle) }) {
+                if (discover_idx[as_integer(root)] != unvisited) continue;
+                discover(root);
+                while (!frames.empty()) {
+                    frame_t& frame = frames.back();
+                    uint64_t i = as_integer(frame.handle);
+                    if (frame.next < frame.end) {
+                        handle_t next = targets[frame.next++];
+                        uint64_t j = as_integer(next);
+                        if (discover_idx[j] == unvisited) {
+                            discover(next);
+                        } else if (on_stack[j]) {
+                            low[i] = min(low[i], discover_idx[j]);
+                        }
+                        continue;
+                    }
+                    if (low[i] == discover_idx[i]) {
+                        // everything above us on the stack is our component
+                        bool labeled_any = false;
+                        handle_t other;
+                        do {
+                            other = stack.back();
+                            stack.pop_back();
+                            on_stack[as_integer(other)] = false;
+                            auto& label = labels[number_bool_packing::unpack_number(other)];
+                            if (label == unvisited) {
+                                label = component_count;
+                                labeled_any = true;
+                            }
+                        } while (other != frame.handle);
+                        // the mirror of a component we've already labeled adds no new component
+                        if (labeled_any) {
+                            ++component_count;
+                        }
+                    }
+                    targets.resize(frame.begin);
+                    frames.pop_back();
+                    if (!frames.empty()) {
+                        uint64_t p = as_integer(frames.back().handle);
+                        low[p] = min(low[p], low[i]);
+                    }
+                }
+            }
+        });
+        
+        return labels;
+    }
+
 }
 }
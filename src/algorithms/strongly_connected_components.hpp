@@ -1,6 +1,9 @@
 #pragma once
 
 #include <unordered_set>
+#include <vector>
+#include <limits>
+#include <algorithm>
 #include <handlegraph/handle_graph.hpp>
 #include "hash_map.hpp"
 #include "dfs.hpp"
@@ -13,6 +16,11 @@ using namespace handlegraph;
 
 /// Find all of the nodes with no edges on their left sides.
 vector<ska::flat_hash_set<handlegraph::nid_t>> strongly_connected_components(const HandleGraph* g);
+
+/// Label each node by rank with the strongly connected component that first takes one of its
+/// orientations, numbering the components densely in the order they are completed.
+/// Handles must pack dense node ranks, as in graph_t.
+vector<uint64_t> strongly_connected_component_labels(const HandleGraph& g);
     
 }
 }
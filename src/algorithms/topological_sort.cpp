@@ -337,6 +337,163 @@ std::vector<handle_t> topological_order(const HandleGraph* g, bool use_heads, bo
     return sorted;
 }
 
+std::vector<handle_t> parallel_topological_order(const HandleGraph* g,
+                                                 bool use_heads,
+                                                 bool use_tails,
+                                                 bool progress_reporting,
+                                                 uint64_t num_threads) {
+    // frontiers smaller than this aren't worth spreading over threads
+    const uint64_t min_parallel_frontier = 1024;
+
+    uint64_t max_handle_rank = 0;
+    g->for_each_handle([&](const handle_t& found) {
+            max_handle_rank = std::max(max_handle_rank,
+                                       number_bool_packing::unpack_number(found));
+        });
+    uint64_t node_count = g->get_node_count();
+
+    // the number of edges on the left side of each oriented handle that we have yet to cross
+    std::vector<std::atomic<uint32_t>> in_degree(2 * (max_handle_rank + 1));
+    // for each node, the orientations in which it became ready
+    std::vector<std::atomic<uint8_t>> ready(max_handle_rank + 1);
+    // the nodes in this or an earlier frontier, which only change between frontiers
+    std::vector<bool> placed(max_handle_rank + 1, false);
+    // the orientations in which we've reached a node without it becoming ready,
+    // which make good entry points into cycles
+    std::vector<std::atomic<uint8_t>> suggested(max_handle_rank + 1);
+    // nodes that aren't in the graph are never unvisited
+    std::vector<bool> present(max_handle_rank + 1, false);
+    for (uint64_t i = 0; i <= max_handle_rank; ++i) {
+        ready[i].store(0, std::memory_order_relaxed);
+        suggested[i].store(0, std::memory_order_relaxed);
+    }
+    g->for_each_handle([&](const handle_t& found) {
+            present[number_bool_packing::unpack_number(found)] = true;
+        });
+    g->for_each_handle([&](const handle_t& found) {
+            for (bool is_rev : { false, true }) {
+                handle_t h = is_rev ? g->flip(found) : found;
+                uint32_t degree = 0;
+                g->follow_edges(h, true, [&](const handle_t& prev) { ++degree; });
+                in_degree[as_integer(h)].store(degree, std::memory_order_relaxed);
+            }
+        }, true);
+
+    // the current frontier, as oriented handles in rank order
+    std::vector<handle_t> frontier;
+    if (use_heads) {
+        frontier = head_nodes(g);
+    } else if (use_tails) {
+        // tails have no edges on their left once we turn them around
+        for (auto& tail : tail_nodes(g)) {
+            frontier.push_back(g->flip(tail));
+        }
+    }
+    for (auto& h : frontier) {
+        ready[number_bool_packing::unpack_number(h)].store(1 << number_bool_packing::unpack_bit(h),
+                                                         std::memory_order_relaxed);
+        placed[number_bool_packing::unpack_number(h)] = true;
+    }
+
+    std::vector<std::vector<uint64_t>> next_buffers(num_threads);
+    std::vector<std::vector<uint64_t>> seed_buffers(num_threads);
+    // candidate cycle entry points by rank, smallest first
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> seeds;
+    // everything below this rank has been placed or isn't in the graph
+    uint64_t first_unvisited = 0;
+
+    // cross the right side of h, releasing the nodes for which it was the last incoming edge
+    // we cross every edge into a node that isn't placed yet, even once it's ready in this frontier,
+    // so the orientations in which each node becomes ready don't depend on which thread gets there first
+    auto visit = [&](const handle_t& h, std::vector<uint64_t>& next, std::vector<uint64_t>& seed) {
+        g->follow_edges(h, false, [&](const handle_t& next_handle) {
+                uint64_t next_rank = number_bool_packing::unpack_number(next_handle);
+                if (placed[next_rank]) {
+                    return;
+                }
+                uint8_t orientation = 1 << number_bool_packing::unpack_bit(next_handle);
+                if (in_degree[as_integer(next_handle)].fetch_sub(1, std::memory_order_relaxed) == 1) {
+                    // only the first orientation to become ready queues the node
+                    if (!ready[next_rank].fetch_or(orientation, std::memory_order_relaxed)) {
+                        next.push_back(next_rank);
+                    }
+                } else if (!suggested[next_rank].fetch_or(orientation, std::memory_order_relaxed)) {
+                    seed.push_back(next_rank);
+                }
+            });
+    };
+
+    std::vector<handle_t> sorted;
+    sorted.reserve(node_count);
+    while (sorted.size() < node_count) {
+        if (frontier.empty()) {
+            // we're in a cycle, or between components, so start again from the best seed we know
+            while (!seeds.empty() && placed[seeds.top()]) {
+                seeds.pop();
+            }
+            uint64_t rank;
+            bool is_rev = false;
+            if (!seeds.empty()) {
+                rank = seeds.top();
+                seeds.pop();
+                // prefer to enter locally forward if we reached the node that way
+                is_rev = !(suggested[rank].load(std::memory_order_relaxed) & 1);
+            } else {
+                while (!present[first_unvisited] || placed[first_unvisited]) {
+                    ++first_unvisited;
+                }
+                rank = first_unvisited;
+            }
+            ready[rank].store(1 << is_rev, std::memory_order_relaxed);
+            placed[rank] = true;
+            frontier.push_back(number_bool_packing::pack(rank, is_rev));
+        }
+        uint64_t frontier_size = frontier.size();
+        for (auto& h : frontier) {
+            sorted.push_back(number_bool_packing::pack(number_bool_packing::unpack_number(h), false));
+        }
+        if (frontier.size() < min_parallel_frontier || num_threads == 1) {
+            for (auto& h : frontier) {
+                visit(h, next_buffers[0], seed_buffers[0]);
+            }
+        } else {
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+            for (uint64_t i = 0; i < frontier.size(); ++i) {
+                int tid = omp_get_thread_num();
+                visit(frontier[i], next_buffers[tid], seed_buffers[tid]);
+            }
+        }
+        // merge the per-thread buffers in rank order, so that the order is the same for any number of threads
+        frontier.clear();
+        for (auto& next : next_buffers) {
+            for (auto& rank : next) {
+                // if both orientations became ready together, we take the locally forward one
+                bool is_rev = !(ready[rank].load(std::memory_order_relaxed) & 1);
+                placed[rank] = true;
+                frontier.push_back(number_bool_packing::pack(rank, is_rev));
+            }
+            next.clear();
+        }
+        std::sort(frontier.begin(), frontier.end(),
+                  [](const handle_t& a, const handle_t& b) { return as_integer(a) < as_integer(b); });
+        for (auto& seed : seed_buffers) {
+            for (auto& rank : seed) {
+                seeds.push(rank);
+            }
+            seed.clear();
+        }
+        if (progress_reporting && sorted.size() / 1000 != (sorted.size() - frontier_size) / 1000) {
+            uint64_t i = sorted.size();
+            std::cerr << "topological sort " << i << " of " << node_count << " ~ " << (float)i/(float)node_count * 100 << "%" << "\r";
+        }
+    }
+    if (progress_reporting && sorted.size()) {
+        std::cerr << "topological sort " << sorted.size() << " of " << node_count << " ~ " << "100.0000%" << std::endl;
+    }
+
+    return sorted;
+}
+
 std::vector<handle_t> two_way_topological_order(const HandleGraph* g) {
     // take the average assigned order for each handle
     hash_map<handle_t, uint64_t> avg_order;
@@ -456,99 +613,146 @@ void topological_sort(MutableHandleGraph& g, bool compact_ids) {
     g.apply_ordering(topological_order(&g), compact_ids);
 }
 
-std::vector<handle_t> breadth_first_topological_order(const HandleGraph& g, const uint64_t& chunk_size,
-                                                      bool use_heads, bool use_tails) {
-
-    // This (s) is our set of oriented nodes.
-    //dyn::succinct_bitvector<dyn::spsi<dyn::packed_vector,256,16> > s;
-    uint64_t min_handle_rank = 0;
-    uint64_t max_handle_rank = 0;
-    g.for_each_handle([&](const handle_t& found) {
-                          uint64_t handle_rank = number_bool_packing::unpack_number(found);
-                          min_handle_rank = std::min(min_handle_rank, handle_rank);
-                          max_handle_rank = std::max(max_handle_rank, handle_rank);
-                      });
-
+// the nodes we have yet to visit, by handle rank, in a flat bitmap
+// the sorts always seed from the first unvisited node, so we keep a cursor to it that only moves forward
+class unvisited_ranks_t {
+public:
+    unvisited_ranks_t(const HandleGraph& g) {
+        uint64_t max_rank = 0;
+        g.for_each_handle([&](const handle_t& h) {
+                max_rank = std::max(max_rank, (uint64_t)number_bool_packing::unpack_number(h));
+            });
+        words.resize((max_rank >> 6) + 1, 0);
+        g.for_each_handle([&](const handle_t& h) {
+                uint64_t rank = number_bool_packing::unpack_number(h);
+                words[rank >> 6] |= (uint64_t)1 << (rank & 63);
+                ++remaining;
+            });
+    }
+    inline bool contains(const uint64_t& rank) const {
+        return words[rank >> 6] >> (rank & 63) & 1;
+    }
+    inline void erase(const uint64_t& rank) {
+        words[rank >> 6] &= ~((uint64_t)1 << (rank & 63));
+        --remaining;
+    }
+    inline bool empty(void) const {
+        return remaining == 0;
+    }
+    // the lowest unvisited rank, if there is one
+    uint64_t first(void) {
+        while (words[cursor] == 0) ++cursor;
+        return cursor << 6 | __builtin_ctzll(words[cursor]);
+    }
+private:
+    std::vector<uint64_t> words;
+    uint64_t cursor = 0;
+    uint64_t remaining = 0;
+};
+
+static std::vector<handle_t> chunked_sort_seeds(const HandleGraph& g, unvisited_ranks_t& unvisited,
+                                                bool use_heads, bool use_tails) {
     // Start with the heads of the graph.
     // We could also just use the first node of the graph.
-    std::vector<handle_t> seeds;
     if (use_heads) {
-        seeds = head_nodes(&g);
+        return head_nodes(&g);
     } else if (use_tails) {
-        seeds = tail_nodes(&g);
+        return tail_nodes(&g);
     } else {
-        handle_t min_handle = number_bool_packing::pack(min_handle_rank, false);
-        seeds = { min_handle };
+        return { number_bool_packing::pack(unvisited.first(), false) };
     }
+}
 
+std::vector<handle_t> breadth_first_topological_order(const HandleGraph& g, const uint64_t& chunk_size,
+                                                      bool use_heads, bool use_tails, uint64_t num_threads) {
+    if (g.get_node_count() == 0) {
+        return {};
+    }
     // We need to keep track of the nodes we haven't visited to seed subsequent
     // runs of the BFS
-    dyn::succinct_bitvector<dyn::spsi<dyn::packed_vector,256,16> > unvisited;
-    for (uint64_t i = 0; i <= max_handle_rank; ++i) {
-        unvisited.push_back(1);
-    }
-    /*
-    g.for_each_handle([&](const handle_t& found) {
-                          uint64_t rank = number_bool_packing::unpack_number(found);
-                          unvisited.set(rank, 1);
-                      });
-    */
-
-    uint64_t prev_max_root = 0;
-    uint64_t prev_max_length = 0;
-    
-    std::vector<bfs_state_t> order_raw;
-    while (unvisited.rank1(unvisited.size())!=0) {
-        /*
-        std::cerr << "unvisited size " << unvisited.rank1(unvisited.size()) << std::endl;
-        for (uint64_t i = 0; i < unvisited.size(); ++i) {
-            std::cerr << unvisited.at(i);
+    unvisited_ranks_t unvisited(g);
+    std::vector<handle_t> seeds = chunked_sort_seeds(g, unvisited, use_heads, use_tails);
+
+    // the nodes in the order we reach them, with the root we reached them from, numbered
+    // across all the chunks, and the length of the path we took from it
+    std::vector<handle_t> visited;
+    std::vector<uint64_t> roots;
+    std::vector<uint64_t> lengths;
+    visited.reserve(g.get_node_count());
+    roots.reserve(g.get_node_count());
+    lengths.reserve(g.get_node_count());
+    struct todo_t {
+        handle_t handle;
+        uint64_t root;
+        uint64_t length;
+    };
+    std::vector<todo_t> todo;
+    uint64_t root_count = 0;
+    while (!unvisited.empty()) {
+        // the search takes handles from the back of its queue, with the first seed on top
+        todo.clear();
+        for (uint64_t i = seeds.size(); i > 0; --i) {
+            todo.push_back({seeds[i - 1], root_count + i - 1, 0});
         }
-        std::cerr << std::endl;
-        */
         uint64_t seen_bp = 0;
-        uint64_t curr_max_root = 0;
-        uint64_t curr_max_length = 0;
-        bfs(g,
-            [&g,&order_raw,&unvisited,&seen_bp,
-             &prev_max_root,&curr_max_root,
-             &prev_max_length,&curr_max_length]
-            (const handle_t& h, const uint64_t& r, const uint64_t& l, const uint64_t& d) {
-                uint64_t i = number_bool_packing::unpack_number(h);
-                order_raw.push_back({h, r+prev_max_root, l+prev_max_length});
-                curr_max_root = std::max(r+prev_max_root, curr_max_root);
-                curr_max_length = std::max(l+prev_max_length, curr_max_length);
-                seen_bp += g.get_length(h);
-                unvisited.set(i, 0);
-            },
-            [&unvisited](const handle_t& h) {
-                uint64_t i = number_bool_packing::unpack_number(h);
-                return unvisited.at(i)==0;
-            },
-            [](const handle_t& l, const handle_t& h) { return false; },
-            [&seen_bp,&chunk_size](void) { return seen_bp > chunk_size; },
-            seeds,
-            { },
-            false); // don't use bidirectional search
+        while (!todo.empty()) {
+            todo_t curr = todo.back();
+            todo.pop_back();
+            uint64_t rank = number_bool_packing::unpack_number(curr.handle);
+            if (!unvisited.contains(rank)) continue;
+            unvisited.erase(rank);
+            visited.push_back(curr.handle);
+            roots.push_back(curr.root);
+            lengths.push_back(curr.length);
+            uint64_t length = g.get_length(curr.handle);
+            seen_bp += length;
+            // the rest of this chunk's queue is dropped, and we seed the next one afresh
+            if (seen_bp > chunk_size) break;
+            g.follow_edges(curr.handle, false, [&](const handle_t& next) {
+                    if (unvisited.contains(number_bool_packing::unpack_number(next))) {
+                        todo.push_back({next, curr.root, curr.length + length});
+                    }
+                });
+        }
+        // later chunks sort after earlier ones
+        root_count += seeds.size();
         // get another seed
-        prev_max_root = curr_max_root;
-        prev_max_length = curr_max_length;
-        if (unvisited.rank1(unvisited.size())!=0) {
-            uint64_t i = unvisited.select1(0);
-            handle_t h = number_bool_packing::pack(i, false);
-            seeds = { h };
+        if (!unvisited.empty()) {
+            seeds = { number_bool_packing::pack(unvisited.first(), false) };
         }
     }
-    //std::cerr << "order size " << order.size() << " graph size " << g.get_node_count() << std::endl;
-    //assert(order.size() == g.get_node_count());
-    std::sort(order_raw.begin(), order_raw.end(),
-              [](const bfs_state_t& a,
-                 const bfs_state_t& b) {
-                  return a.root < b.root || a.root == b.root && a.length < b.length;
-              });
 
-    std::vector<handle_t> order;
-    for (auto& o : order_raw) order.push_back(o.handle);
+    // order by root, then by the distance from it
+    // the roots are dense, so we bucket the nodes by root and sort each bucket in parallel
+    std::vector<uint64_t> root_offsets(root_count + 1, 0);
+    for (auto& root : roots) {
+        ++root_offsets[root + 1];
+    }
+    for (uint64_t r = 0; r < root_count; ++r) {
+        root_offsets[r + 1] += root_offsets[r];
+    }
+    std::vector<uint64_t> by_root(visited.size());
+    {
+        std::vector<uint64_t> fill(root_offsets.begin(), root_offsets.end() - 1);
+        for (uint64_t i = 0; i < roots.size(); ++i) {
+            by_root[fill[roots[i]]++] = i;
+        }
+    }
+    std::vector<uint64_t>().swap(roots);
+#pragma omp parallel for schedule(dynamic, 64) num_threads(num_threads)
+    for (uint64_t r = 0; r < root_count; ++r) {
+        if (root_offsets[r + 1] - root_offsets[r] < 2) continue;
+        // ties keep the order in which we reached the nodes
+        std::sort(by_root.begin() + root_offsets[r], by_root.begin() + root_offsets[r + 1],
+                  [&lengths](const uint64_t& a, const uint64_t& b) {
+                      return lengths[a] < lengths[b] || (lengths[a] == lengths[b] && a < b);
+                  });
+    }
+    std::vector<handle_t> order(visited.size());
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (uint64_t i = 0; i < by_root.size(); ++i) {
+        order[i] = visited[by_root[i]];
+    }
 
     return order;
 }
@@ -556,75 +760,65 @@ std::vector<handle_t> breadth_first_topological_order(const HandleGraph& g, cons
 
 std::vector<handle_t> depth_first_topological_order(const HandleGraph& g, const uint64_t& chunk_size,
                                                     bool use_heads, bool use_tails) {
-
-    uint64_t min_handle_rank = 0;
-    uint64_t max_handle_rank = 0;
-    g.for_each_handle([&](const handle_t& found) {
-                          uint64_t handle_rank = number_bool_packing::unpack_number(found);
-                          min_handle_rank = std::min(min_handle_rank, handle_rank);
-                          max_handle_rank = std::max(max_handle_rank, handle_rank);
-                      });
-
-    // Start with the heads of the graph.
-    // We could also just use the first node of the graph.
-    std::vector<handle_t> seeds;
-    if (use_heads) {
-        seeds = head_nodes(&g);
-    } else if (use_tails) {
-        seeds = tail_nodes(&g);
-    } else {
-        handle_t min_handle = number_bool_packing::pack(min_handle_rank, false);
-        seeds = { min_handle };
+    if (g.get_node_count() == 0) {
+        return {};
     }
-
     // We need to keep track of the nodes we haven't visited to seed subsequent
-    // runs of the BFS
-    dyn::succinct_bitvector<dyn::spsi<dyn::packed_vector,256,16> > unvisited;
-    for (uint64_t i = 0; i <= max_handle_rank; ++i) {
-        unvisited.push_back(1);
-    }
-    /*
-    g.for_each_handle([&](const handle_t& found) {
-                          uint64_t rank = number_bool_packing::unpack_number(found);
-                          unvisited.set(rank, 1);
-                      });
-    */
+    // runs of the DFS
+    unvisited_ranks_t unvisited(g);
+    std::vector<handle_t> seeds = chunked_sort_seeds(g, unvisited, use_heads, use_tails);
+
     std::vector<handle_t> order;
-    while (unvisited.rank1(unvisited.size())!=0) {
-        /*
-        std::cerr << "unvisited size " << unvisited.rank1(unvisited.size()) << std::endl;
-        for (uint64_t i = 0; i < unvisited.size(); ++i) {
-            std::cerr << unvisited.at(i);
+    order.reserve(g.get_node_count());
+    // the stack of nodes whose edges we're following, each with a range of the targets
+    // of its edges, which we keep on a stack of their own
+    struct frame_t {
+        uint64_t begin;
+        uint64_t next;
+        uint64_t end;
+    };
+    std::vector<frame_t> frames;
+    std::vector<handle_t> targets;
+    uint64_t bp_count = 0;
+    auto visit = [&](const handle_t& h) {
+        unvisited.erase(number_bool_packing::unpack_number(h));
+        order.push_back(h);
+        bp_count += g.get_length(h);
+        uint64_t begin = targets.size();
+        g.follow_edges(h, false, [&](const handle_t& next) {
+                if (unvisited.contains(number_bool_packing::unpack_number(next))) {
+                    targets.push_back(next);
+                }
+            });
+        frames.push_back({begin, begin, targets.size()});
+    };
+    while (!unvisited.empty()) {
+        bp_count = 0;
+        for (auto& seed : seeds) {
+            if (!unvisited.contains(number_bool_packing::unpack_number(seed))) continue;
+            frames.clear();
+            targets.clear();
+            // once we pass the chunk size, each remaining seed is taken alone
+            visit(seed);
+            if (bp_count > chunk_size) continue;
+            while (!frames.empty()) {
+                frame_t& frame = frames.back();
+                if (frame.next == frame.end) {
+                    targets.resize(frame.begin);
+                    frames.pop_back();
+                    continue;
+                }
+                handle_t next = targets[frame.next++];
+                if (!unvisited.contains(number_bool_packing::unpack_number(next))) continue;
+                visit(next);
+                if (bp_count > chunk_size) break;
+            }
         }
-        std::cerr << std::endl;
-        */
-        uint64_t bp_count = 0;
-        dfs(g,
-            [&g,&order,&unvisited,&bp_count](const handle_t& h) {
-                uint64_t i = number_bool_packing::unpack_number(h);
-                bp_count += g.get_length(h);
-                order.push_back(h);
-                unvisited.set(i, 0);
-            },
-            [](const handle_t& h) { },
-            [&unvisited](const handle_t& h) {
-                uint64_t i = number_bool_packing::unpack_number(h);
-                return unvisited.at(i)==0;
-            },
-            [&bp_count,&chunk_size](void) {
-                //std::cerr << "bp_count " << bp_count << std::endl;
-                return bp_count > chunk_size;
-            },
-            seeds);
         // get another seed
-        if (unvisited.rank1(unvisited.size())!=0) {
-            uint64_t i = unvisited.select1(0);
-            handle_t h = number_bool_packing::pack(i, false);
-            seeds = { h };
+        if (!unvisited.empty()) {
+            seeds = { number_bool_packing::pack(unvisited.first(), false) };
         }
     }
-    //std::cerr << "order size " << order.size() << " graph size " << g.get_node_count() << std::endl;
-    //assert(order.size() == g.get_node_count());
 
     return order;
 
@@ -10,6 +10,9 @@
 //#include <set>
 #include <map>
 #include <iostream>
+#include <atomic>
+#include <queue>
+#include <omp.h>
 #include "../hash_map.hpp"
 #include <handlegraph/handle_graph.hpp>
 #include <handlegraph/util.hpp>
@@ -65,6 +68,25 @@ std::vector<handle_t> topological_order(const HandleGraph* g,
                                         bool use_tails = false,
                                         bool progress_reporting = false);
 
+/**
+ * Order the nodes in the graph with a frontier-based variant of Kahn's sort that
+ * processes each frontier of nodes with no remaining incoming edges in parallel.
+ * In-degrees are kept as atomic counters on each side of each node, and the next
+ * frontier is gathered in per-thread buffers and sorted by rank. Every edge into a node
+ * that isn't yet placed is crossed, and a node that becomes ready in both orientations
+ * within one frontier is taken locally forward, so the order does not depend on the
+ * number of threads or on their timing. This gives a valid topological order
+ * whenever the graph has one in the orientation we reach its nodes. When the frontier
+ * empties before every node is placed, we break into the remaining cycles as
+ * topological_order() does: from a node we have reached through some of its edges,
+ * or else from the first unvisited node, locally forward.
+ */
+std::vector<handle_t> parallel_topological_order(const HandleGraph* g,
+                                                 bool use_heads = true,
+                                                 bool use_tails = false,
+                                                 bool progress_reporting = false,
+                                                 uint64_t num_threads = 1);
+
 std::vector<handle_t> two_way_topological_order(const HandleGraph* g);
 
 /**
@@ -85,9 +107,19 @@ std::vector<handle_t> lazier_topological_order(const HandleGraph* g);
 
 void topological_sort(MutableHandleGraph& g, bool compact_ids);
 
+/**
+ * Order the nodes by a search from the heads (or tails, or the first node) that stops once it has
+ * seen chunk_size bp, then starts again from the first node it hasn't visited. Nodes are ordered by
+ * the root they were reached from and then by their distance from it. The roots are sorted in parallel.
+ */
 std::vector<handle_t> breadth_first_topological_order(const HandleGraph& g, const uint64_t& chunk_size,
-                                                      bool use_heads = true, bool use_tails = false);
+                                                      bool use_heads = true, bool use_tails = false,
+                                                      uint64_t num_threads = 1);
 
+/**
+ * Order the nodes as a depth first search visits them, in chunks of chunk_size bp, starting each
+ * chunk from the first node we haven't visited.
+ */
 std::vector<handle_t> depth_first_topological_order(const HandleGraph& g, const uint64_t& chunk_size,
                                                     bool use_heads = false, bool use_tails = false);
 
@@ -6,48 +6,102 @@ namespace algorithms {
 using namespace handlegraph;
 
 std::vector<ska::flat_hash_set<handlegraph::nid_t>> weakly_connected_components(const HandleGraph* graph) {
-    std::vector<ska::flat_hash_set<handlegraph::nid_t>> to_return;
+    std::vector<uint64_t> component_sizes;
+    std::vector<uint64_t> labels = weakly_connected_component_labels(graph, component_sizes);
+    std::vector<ska::flat_hash_set<handlegraph::nid_t>> to_return(component_sizes.size());
+    for (uint64_t c = 0; c < component_sizes.size(); ++c) {
+        to_return[c].reserve(component_sizes[c]);
+    }
+    graph->for_each_handle([&](const handle_t& handle) {
+        to_return[labels[number_bool_packing::unpack_number(handle)]].insert(graph->get_id(handle));
+    });
+    return to_return;
+}
+
+std::vector<uint64_t> weakly_connected_component_labels(const HandleGraph* graph,
+                                                        std::vector<uint64_t>& component_sizes,
+                                                        uint64_t num_threads) {
+    const uint64_t unlabeled = std::numeric_limits<uint64_t>::max();
+    std::vector<handle_t> handles;
+    handles.reserve(graph->get_node_count());
+    uint64_t max_rank = 0;
+    graph->for_each_handle([&](const handle_t& handle) {
+        handles.push_back(graph->forward(handle));
+        max_rank = std::max(max_rank, (uint64_t)number_bool_packing::unpack_number(handle));
+    });
+    component_sizes.clear();
+    if (handles.empty()) {
+        return std::vector<uint64_t>();
+    }
     
-    // This only holds locally forward handles
-    ska::flat_hash_set<handle_t> traversed;
+    // Every node starts as its own root. Roots are only ever linked under a root
+    // of lower rank, so the parents never form a cycle and each component ends up
+    // rooted at its lowest rank, whatever order the threads link them in.
+    std::vector<std::atomic<uint64_t>> parent(max_rank + 1);
+    for (uint64_t i = 0; i <= max_rank; ++i) {
+        parent[i].store(i, std::memory_order_relaxed);
+    }
+    auto find = [&](uint64_t x) {
+        while (true) {
+            uint64_t p = parent[x].load();
+            if (p == x) return x;
+            // path halving, which is safe to race with other finds and links
+            uint64_t grandparent = parent[p].load();
+            if (p != grandparent) {
+                parent[x].compare_exchange_weak(p, grandparent);
+            }
+            x = grandparent;
+        }
+    };
+    auto unite = [&](uint64_t a, uint64_t b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            // link the higher root under the lower one, unless someone linked it first
+            uint64_t expected = a;
+            if (parent[a].compare_exchange_strong(expected, b)) return;
+        }
+    };
     
-    graph->for_each_handle([&](const handle_t& handle) {
-        
-        // Only think about it in the forward orientation
-        auto forward = graph->forward(handle);
-        
-        if (traversed.count(forward)) {
-            // Already have this node, so don't start a search from it.
-            return;
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        const handle_t& here = handles[i];
+        uint64_t rank = number_bool_packing::unpack_number(here);
+        // Look at edges in both directions
+        auto handle_other = [&](const handle_t& other) {
+            uint64_t other_rank = number_bool_packing::unpack_number(other);
+            // each edge is seen from both ends, so we only need to link it from one
+            if (other_rank < rank) {
+                unite(rank, other_rank);
+            }
+        };
+        graph->follow_edges(here, false, handle_other);
+        graph->follow_edges(here, true, handle_other);
+    }
+    
+    // Number the components in the order we first reach them
+    std::vector<uint64_t> labels(max_rank + 1, unlabeled);
+    for (auto& handle : handles) {
+        uint64_t root = find(number_bool_packing::unpack_number(handle));
+        if (labels[root] == unlabeled) {
+            labels[root] = component_sizes.size();
+            component_sizes.push_back(0);
         }
-        
-        // The stack only holds locally forward handles
-        std::vector<handle_t> stack{forward};
-        to_return.emplace_back();
-        while (!stack.empty()) {
-            handle_t here = stack.back();
-            stack.pop_back();
-            
-            traversed.insert(here);
-            to_return.back().insert(graph->get_id(here));
-            
-            // We have a function to handle all connected handles
-            auto handle_other = [&](const handle_t& other) {
-                // Again, make it forward
-                auto other_forward = graph->forward(other);
-                
-                if (!traversed.count(other_forward)) {
-                    stack.push_back(other_forward);
-                }
-            };
-            
-            // Look at edges in both directions
-            graph->follow_edges(here, false, handle_other);
-            graph->follow_edges(here, true, handle_other);
-            
+    }
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        uint64_t rank = number_bool_packing::unpack_number(handles[i]);
+        uint64_t root = find(rank);
+        if (root != rank) {
+            labels[rank] = labels[root];
         }
-    });
-    return to_return;
+    }
+    for (auto& handle : handles) {
+        ++component_sizes[labels[number_bool_packing::unpack_number(handle)]];
+    }
+    return labels;
 }
 
 std::vector<std::pair<ska::flat_hash_set<handlegraph::nid_t>, std::vector<handle_t>>> weakly_connected_components_with_tips(const HandleGraph* graph) {
@@ -7,9 +7,14 @@
  */
 
 #include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
 
 #include "hash_map.hpp"
 #include <vector>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <omp.h>
 
 namespace odgi {
 namespace algorithms {
@@ -23,6 +28,15 @@ using namespace handlegraph;
 /// connected component is orientation-independent.
 std::vector<ska::flat_hash_set<handlegraph::nid_t>> weakly_connected_components(const HandleGraph* graph);
 
+/// Label each node by rank with the weakly connected component it belongs to. The components
+/// are numbered densely in the order for_each_handle first reaches them, and their sizes are
+/// written to component_sizes. Runs a lock-free union-find over the edges with the given number
+/// of threads. Handles must pack dense node ranks, as in graph_t; missing ranks get the largest
+/// uint64_t as their label.
+std::vector<uint64_t> weakly_connected_component_labels(const HandleGraph* graph,
+                                                        std::vector<uint64_t>& component_sizes,
+                                                        uint64_t num_threads = 1);
+
 /// Return pairs of weakly connected component ID sets and the handles that are
 /// their tips, oriented inward. If a node is both a head and a tail, it will
 /// appear in tips in both orientations.
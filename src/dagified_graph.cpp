@@ -0,0 +1,289 @@
+#include "dagified_graph.hpp"
+
+namespace odgi {
+
+dagified_graph_t::dagified_graph_t(const HandleGraph* underlying, size_t min_preserved_path_length) : underlying(underlying) {
+
+    // find the strongly connected components of the underlying graph
+    component_of = algorithms::strongly_connected_component_labels(*underlying);
+    uint64_t rank_count = component_of.size();
+    uint64_t component_count = 0;
+    for (auto& c : component_of) {
+        if (c != std::numeric_limits<uint64_t>::max()) {
+            component_count = std::max(component_count, c + 1);
+        }
+    }
+    layout_offset.assign(component_count + 1, 0);
+    for (auto& c : component_of) {
+        if (c < component_count) {
+            ++layout_offset[c + 1];
+        }
+    }
+    for (uint64_t c = 0; c < component_count; ++c) {
+        layout_offset[c + 1] += layout_offset[c];
+    }
+
+    // lay out each component in the reverse of the order a depth first search finishes its nodes,
+    // so that only the edges closing cycles point backward
+    std::vector<uint64_t> finished;
+    finished.reserve(layout_offset.back());
+    {
+        std::vector<bool> visited(rank_count, false);
+        struct frame_t {
+            uint64_t rank;
+            // the range of the targets stack holding the node's edges within its component
+            uint64_t begin;
+            uint64_t next;
+            uint64_t end;
+        };
+        std::vector<frame_t> frames;
+        std::vector<uint64_t> targets;
+        auto discover = [&](const uint64_t& rank) {
+            visited[rank] = true;
+            uint64_t begin = targets.size();
+            underlying->follow_edges(number_bool_packing::pack(rank, false), false, [&](const handle_t& next) {
+                    if (number_bool_packing::unpack_bit(next)) {
+                        std::cerr << "[odgi::dagified_graph_t] error: the underlying graph has an edge into the "
+                                  << "reverse strand of a node, consider splitting its strands first" << std::endl;
+                        exit(1);
+                    }
+                    uint64_t target = number_bool_packing::unpack_number(next);
+                    if (component_of[target] == component_of[rank]) {
+                        targets.push_back(target);
+                    }
+                });
+            frames.push_back({rank, begin, begin, targets.size()});
+        };
+        for (uint64_t root = 0; root < rank_count; ++root) {
+            if (visited[root] || component_of[root] >= component_count) continue;
+            discover(root);
+            while (!frames.empty()) {
+                frame_t& frame = frames.back();
+                if (frame.next == frame.end) {
+                    finished.push_back(frame.rank);
+                    targets.resize(frame.begin);
+                    frames.pop_back();
+                    continue;
+                }
+                uint64_t next = targets[frame.next++];
+                if (!visited[next]) {
+                    discover(next);
+                }
+            }
+        }
+    }
+    layout.resize(layout_offset.back());
+    position_of.assign(rank_count, 0);
+    {
+        std::vector<uint64_t> fill(component_count, 0);
+        for (auto f = finished.rbegin(); f != finished.rend(); ++f) {
+            uint64_t c = component_of[*f];
+            position_of[*f] = fill[c]++;
+            layout[layout_offset[c] + position_of[*f]] = *f;
+        }
+    }
+    finished.clear();
+    finished.shrink_to_fit();
+
+    // count the copies of each component that we need to preserve its paths, following the
+    // dynamic programming of algorithms::dagify over the distances within each copy
+    copies.assign(component_count, 0);
+    const int64_t infinity = std::numeric_limits<int64_t>::max();
+    std::vector<int64_t> distances;
+    std::vector<int64_t> next_distances;
+    std::vector<std::pair<uint64_t, uint64_t>> backward_edges;
+    for (uint64_t c = 0; c < component_count; ++c) {
+        uint64_t size = component_size(c);
+        const uint64_t* component_layout = &layout[layout_offset[c]];
+        auto length_at = [&](const uint64_t& i) {
+            return (int64_t)underlying->get_length(number_bool_packing::pack(component_layout[i], false));
+        };
+        // the edges that don't point forward in the layout, as pairs of positions
+        backward_edges.clear();
+        for (uint64_t i = 0; i < size; ++i) {
+            underlying->follow_edges(number_bool_packing::pack(component_layout[i], false), false, [&](const handle_t& next) {
+                    uint64_t target = number_bool_packing::unpack_number(next);
+                    if (component_of[target] == c && position_of[target] <= i) {
+                        backward_edges.emplace_back(i, position_of[target]);
+                    }
+                });
+        }
+        // measure from the end of the heads of backward edges, which cross to the next copy
+        distances.assign(size, infinity);
+        next_distances.assign(size, infinity);
+        for (auto& bwd_edge : backward_edges) {
+            distances[bwd_edge.first] = -length_at(bwd_edge.first);
+        }
+        int64_t min_relaxed_dist = -1;
+        // the distance to the next copy never shrinks, and it grows at least every size copies, as the paths
+        // across them repeat nodes, unless a cycle of zero-length nodes lets the paths cross copies for free,
+        // in which case no number of copies would preserve them, so we stop once it stalls for that long
+        int64_t grown_dist = -1;
+        uint64_t grown_copy = 0;
+        for (uint64_t copy_num = 0; min_relaxed_dist < int64_t(min_preserved_path_length); ++copy_num) {
+            copies[c] = copy_num + 1;
+            // find the shortest path to the nodes, staying within this copy of the component
+            for (uint64_t i = 0; i < size; ++i) {
+                if (distances[i] == infinity) continue;
+                int64_t dist_thru = distances[i] + length_at(i);
+                underlying->follow_edges(number_bool_packing::pack(component_layout[i], false), false, [&](const handle_t& next) {
+                        uint64_t target = number_bool_packing::unpack_number(next);
+                        if (component_of[target] == c && position_of[target] > i) {
+                            distances[position_of[target]] = std::min(distances[position_of[target]], dist_thru);
+                        }
+                    });
+            }
+            // and the minimum distance to the nodes in the next copy
+            min_relaxed_dist = infinity;
+            for (auto& bwd_edge : backward_edges) {
+                if (distances[bwd_edge.first] == infinity) continue;
+                int64_t dist_thru = distances[bwd_edge.first] + length_at(bwd_edge.first);
+                if (dist_thru < next_distances[bwd_edge.second]) {
+                    next_distances[bwd_edge.second] = dist_thru;
+                    min_relaxed_dist = std::min(min_relaxed_dist, dist_thru);
+                }
+            }
+            distances.swap(next_distances);
+            next_distances.assign(size, infinity);
+            if (min_relaxed_dist > grown_dist) {
+                grown_dist = min_relaxed_dist;
+                grown_copy = copy_num;
+            } else if (copy_num - grown_copy >= size) {
+                break;
+            }
+        }
+    }
+
+    rank_offset.assign(component_count + 1, 0);
+    for (uint64_t c = 0; c < component_count; ++c) {
+        rank_offset[c + 1] = rank_offset[c] + copies[c] * component_size(c);
+    }
+}
+
+void dagified_graph_t::locate(uint64_t rank, uint64_t& component, uint64_t& copy, uint64_t& position) const {
+    component = std::upper_bound(rank_offset.begin(), rank_offset.end(), rank) - rank_offset.begin() - 1;
+    uint64_t offset = rank - rank_offset[component];
+    uint64_t size = component_size(component);
+    copy = offset / size;
+    position = offset % size;
+}
+
+handle_t dagified_graph_t::get_underlying_handle(const handle_t& handle) const {
+    uint64_t component, copy, position;
+    locate(number_bool_packing::unpack_number(handle), component, copy, position);
+    return number_bool_packing::pack(layout[layout_offset[component] + position], get_is_reverse(handle));
+}
+
+bool dagified_graph_t::has_node(nid_t node_id) const {
+    return node_id >= 1 && (uint64_t)node_id <= rank_offset.back();
+}
+
+handle_t dagified_graph_t::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id - 1, is_reverse);
+}
+
+nid_t dagified_graph_t::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle) + 1;
+}
+
+bool dagified_graph_t::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t dagified_graph_t::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t dagified_graph_t::get_length(const handle_t& handle) const {
+    return underlying->get_length(get_underlying_handle(handle));
+}
+
+std::string dagified_graph_t::get_sequence(const handle_t& handle) const {
+    return underlying->get_sequence(get_underlying_handle(handle));
+}
+
+size_t dagified_graph_t::get_degree(const handle_t& handle, bool go_left) const {
+    size_t degree = 0;
+    follow_edges_impl(handle, go_left, [&](const handle_t& next) { ++degree; return true; });
+    return degree;
+}
+
+size_t dagified_graph_t::get_node_count(void) const {
+    return rank_offset.back();
+}
+
+nid_t dagified_graph_t::min_node_id(void) const {
+    return 1;
+}
+
+nid_t dagified_graph_t::max_node_id(void) const {
+    return rank_offset.back();
+}
+
+bool dagified_graph_t::follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    // the left side of a handle is the right side of its reverse
+    if (get_is_reverse(handle)) {
+        return follow_edges_impl(flip(handle), !go_left, [&](const handle_t& next) {
+                return iteratee(flip(next));
+            });
+    }
+    uint64_t component, copy, position;
+    locate(number_bool_packing::unpack_number(handle), component, copy, position);
+    uint64_t last_copy = copies[component] - 1;
+    bool keep_going = true;
+    auto emit = [&](const uint64_t& c, const uint64_t& k, const uint64_t& p) {
+        keep_going = iteratee(number_bool_packing::pack(rank_of(c, k, p), false));
+        return keep_going;
+    };
+    underlying->follow_edges(number_bool_packing::pack(layout[layout_offset[component] + position], false), go_left,
+                             [&](const handle_t& other) {
+            uint64_t rank = number_bool_packing::unpack_number(other);
+            uint64_t c = component_of[rank];
+            uint64_t p = position_of[rank];
+            if (c == component) {
+                // edges forward in the layout stay within the copy, and backward ones lead into the next
+                if (!go_left) {
+                    if (p > position) return emit(c, copy, p);
+                    if (copy < last_copy) return emit(c, copy + 1, p);
+                } else {
+                    if (p < position) return emit(c, copy, p);
+                    if (copy > 0) return emit(c, copy - 1, p);
+                }
+                return true;
+            }
+            // edges between components run from the last copy of one to every copy of the other
+            if (!go_left) {
+                if (copy == last_copy) {
+                    for (uint64_t k = 0; k < copies[c]; ++k) {
+                        if (!emit(c, k, p)) return false;
+                    }
+                }
+                return true;
+            }
+            return emit(c, copies[c] - 1, p);
+        });
+    return keep_going;
+}
+
+bool dagified_graph_t::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    uint64_t rank_count = rank_offset.back();
+    if (parallel) {
+        volatile bool flag = true;
+#pragma omp parallel for
+        for (uint64_t i = 0; i < rank_count; ++i) {
+            if (!flag) continue;
+            bool result = iteratee(number_bool_packing::pack(i, false));
+#pragma omp atomic
+            flag &= result;
+        }
+        return flag;
+    }
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        if (!iteratee(number_bool_packing::pack(i, false))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+/** \file
+ * dagified_graph.hpp: defines a handle graph view that unrolls the cycles of another graph
+ */
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <omp.h>
+#include "algorithms/strongly_connected_components.hpp"
+
+namespace odgi {
+
+using namespace handlegraph;
+
+    /**
+     * A HandleGraph view of a graph like the one algorithms::dagify builds: each strongly
+     * connected component of the underlying graph is laid out, and copied as many times
+     * as we need to preserve its paths up to a given length, with the edges that point
+     * backward in the layout leading into the next copy. The layout is the reverse of the
+     * order a depth first search finishes the component's nodes, not the one dagify takes
+     * from its subgraph, so the backward edges, the copies, and the orders sorted from
+     * them can differ from dagify's. Only the layout of each
+     * component and its number of copies are stored. The copies get consecutive ranks,
+     * so nodes and edges come from id arithmetic on the layout and the underlying graph.
+     * Paths around cycles of zero-length nodes never grow, so a component with one gets
+     * only as many copies as it has nodes past the last one that lengthened its paths.
+     * The underlying graph's handles must pack dense node ranks, and its edges must join
+     * its nodes in their forward orientations, as in a split_strand_graph_t.
+     */
+    class dagified_graph_t : public HandleGraph {
+    public:
+
+        /// Lay out and count the copies of the strongly connected components of the underlying graph
+        dagified_graph_t(const HandleGraph* underlying, size_t min_preserved_path_length);
+
+        /// The handle of the underlying graph that a handle of the view is a copy of
+        handle_t get_underlying_handle(const handle_t& handle) const;
+
+        //////////////////////////
+        /// HandleGraph interface
+        //////////////////////////
+
+        /// Method to check if a node exists by ID
+        bool has_node(nid_t node_id) const;
+
+        /// Look up the handle for the node with the given ID in the given orientation
+        handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+        /// Get the ID from a handle
+        nid_t get_id(const handle_t& handle) const;
+
+        /// Get the orientation of a handle
+        bool get_is_reverse(const handle_t& handle) const;
+
+        /// Invert the orientation of a handle (potentially without getting its ID)
+        handle_t flip(const handle_t& handle) const;
+
+        /// Get the length of a node
+        size_t get_length(const handle_t& handle) const;
+
+        /// Get the sequence of a node, presented in the handle's local forward orientation.
+        std::string get_sequence(const handle_t& handle) const;
+
+        /// Get the number of edges on the right (go_left = false) or left (go_left
+        /// = true) side of the given handle.
+        size_t get_degree(const handle_t& handle, bool go_left) const;
+
+        /// Return the number of nodes in the graph
+        size_t get_node_count(void) const;
+
+        /// Return the smallest ID in the graph
+        nid_t min_node_id(void) const;
+
+        /// Return the largest ID in the graph
+        nid_t max_node_id(void) const;
+
+    protected:
+
+        /// Loop over all the handles to next/previous (right/left) nodes.
+        bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+        /// Loop over all the nodes in the graph in their local forward orientations, in rank order.
+        bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+    private:
+
+        /// Find the component, copy, and position in the component's layout of a rank of the view
+        void locate(uint64_t rank, uint64_t& component, uint64_t& copy, uint64_t& position) const;
+
+        /// The rank of the view for a copy of the node at a position in a component's layout
+        inline uint64_t rank_of(uint64_t component, uint64_t copy, uint64_t position) const {
+            return rank_offset[component] + copy * component_size(component) + position;
+        }
+
+        inline uint64_t component_size(uint64_t component) const {
+            return layout_offset[component + 1] - layout_offset[component];
+        }
+
+        const HandleGraph* underlying = nullptr;
+        /// the component of each underlying node, by rank
+        std::vector<uint64_t> component_of;
+        /// the position of each underlying node, by rank, in the layout of its component
+        std::vector<uint64_t> position_of;
+        /// the underlying ranks in the layout of each component, one component after another
+        std::vector<uint64_t> layout;
+        /// where each component starts in the layout, with the end of the last one at the back
+        std::vector<uint64_t> layout_offset;
+        /// the number of copies we make of each component
+        std::vector<uint64_t> copies;
+        /// the first rank of the view for each component, with the number of nodes at the back
+        std::vector<uint64_t> rank_offset;
+    };
+
+}
@@ -1,77 +1,588 @@
 #include "gfa_to_handle.hpp"
+#include "topology_graph.hpp"
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
 
 namespace odgi {
 
-    void gfa_to_handle(const string& gfa_filename, handlegraph::MutablePathMutableHandleGraph* graph,
-                       bool show_progress) {
-        
-        char* filename = (char*) gfa_filename.c_str();
-        //std::cerr << "filename is " << filename << std::endl;
-        gfak::GFAKluge gg;
-        //double version = gg.detect_version_from_file(filename);
-        //std::cerr << version << " be version" << std::endl;
-        //assert(version == 1.0);
-        /*
-         uint64_t num_nodes = 0;
-         gg.for_each_sequence_line_in_file(filename, [&](gfak::sequence_elem s) {
-         ++num_nodes;
-         });
-         graph_t graph(num_nodes+1); // include delimiter
-         */
-        uint64_t i = 0;
-        uint64_t min_id = std::numeric_limits<uint64_t>::max();
-        uint64_t max_id = std::numeric_limits<uint64_t>::min();
-        gg.for_each_sequence_line_in_file(filename, [&](gfak::sequence_elem s) {
-                uint64_t id = stol(s.name);
-                min_id = std::min(min_id, id);
-                max_id = std::max(max_id, id);
-            });
-        uint64_t id_increment = min_id - 1;
-        graph->set_id_increment(id_increment);
-        // set the min id as an offset
-        gg.for_each_sequence_line_in_file(filename, [&](gfak::sequence_elem s) {
-            uint64_t id = stol(s.name);
-            graph->create_handle(s.sequence, id - id_increment);
-            if (show_progress) {
-                if (i % 1000 == 0) std::cerr << "node " << i << "\r";
-                ++i;
+    namespace {
+
+        /// A segment, with its sequence pointing into the GFA text
+        struct gfa_segment_t {
+            uint64_t id;
+            const char* seq;
+            uint64_t len;
+        };
+
+        /// A link between two oriented segments
+        struct gfa_link_t {
+            uint64_t from;
+            uint64_t to;
+            bool from_rev;
+            bool to_rev;
+        };
+
+        /// A path, with its steps packed as (id << 1 | is_rev)
+        /// Continuations are the tail of a P line that was split across chunks,
+        /// and extend the path that precedes them.
+        struct gfa_path_t {
+            std::string name;
+            std::vector<uint64_t> steps;
+            bool is_circular = false;
+            bool is_continuation = false;
+        };
+
+        /// The records buffered while scanning the GFA, kept in file order
+        struct gfa_records_t {
+            std::vector<gfa_segment_t> segments;
+            std::vector<gfa_link_t> links;
+            std::vector<gfa_path_t> paths;
+            uint64_t min_id = std::numeric_limits<uint64_t>::max();
+            uint64_t max_id = 0;
+            /// the decompressed text the segments point into, when it isn't mapped
+            std::vector<char> text;
+        };
+
+        [[noreturn]] void gfa_error(const std::string& msg) {
+            std::cerr << "[odgi::gfa_to_handle] error: " << msg << std::endl;
+            exit(1);
+        }
+
+        /// The GFA text, mapped from disk when possible and otherwise read into memory.
+        /// Segment sequences point into it, so it must outlive the parsed records.
+        class gfa_buffer_t {
+        public:
+            gfa_buffer_t(const std::string& filename) {
+                int fd = open(filename.c_str(), O_RDONLY);
+                if (fd == -1) {
+                    gfa_error("could not open " + filename);
+                }
+                struct stat st;
+                if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                    void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (m != MAP_FAILED) {
+                        madvise(m, st.st_size, MADV_SEQUENTIAL);
+                        _data = (const char*)m;
+                        _size = st.st_size;
+                        _mapped = true;
+                    }
+                }
+                close(fd);
+                if (!_mapped) {
+                    // pipes, empty files, or a failed map
+                    std::ifstream in(filename.c_str(), std::ios::binary);
+                    read_stream(in);
+                }
+            }
+            ~gfa_buffer_t(void) {
+                if (_mapped) munmap((void*)_data, _size);
+            }
+            gfa_buffer_t(const gfa_buffer_t& other) = delete;
+            gfa_buffer_t& operator=(const gfa_buffer_t& other) = delete;
+            const char* begin(void) const { return _data; }
+            const char* end(void) const { return _data + _size; }
+        private:
+            void read_stream(std::istream& in) {
+                _owned.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                _data = _owned.data();
+                _size = _owned.size();
+            }
+            const char* _data = nullptr;
+            uint64_t _size = 0;
+            bool _mapped = false;
+            std::vector<char> _owned;
+        };
+
+        /// Returns the end of the tab-delimited field starting at p
+        inline const char* field_end(const char* p, const char* line_end) {
+            const char* t = (const char*)memchr(p, '\t', line_end - p);
+            return t ? t : line_end;
+        }
+
+        inline bool parse_id(const char* b, const char* e, uint64_t& id) {
+            if (b == e) return false;
+            uint64_t v = 0;
+            for ( ; b != e; ++b) {
+                if (*b < '0' || *b > '9') return false;
+                v = v * 10 + (*b - '0');
+            }
+            id = v;
+            return v > 0;
+        }
+
+        void parse_segment(const char* b, const char* e, gfa_records_t& records) {
+            const char* name_end = field_end(b, e);
+            uint64_t id;
+            if (!parse_id(b, name_end, id)) {
+                gfa_error("segment names must be positive integers, got '" + std::string(b, name_end) + "'");
+            }
+            if (name_end == e) {
+                gfa_error("segment " + std::to_string(id) + " has no sequence");
+            }
+            const char* seq = name_end + 1;
+            const char* seq_end = field_end(seq, e);
+            records.segments.push_back({id, seq, (uint64_t)(seq_end - seq)});
+            records.min_id = std::min(records.min_id, id);
+            records.max_id = std::max(records.max_id, id);
+        }
+
+        void parse_link(const char* b, const char* e, gfa_records_t& records) {
+            const char* f[4];
+            const char* p = b;
+            for (uint64_t i = 0; i < 4; ++i) {
+                if (p >= e) gfa_error("truncated link line '" + std::string(b, e) + "'");
+                f[i] = p;
+                p = field_end(p, e) + 1;
+            }
+            const char* from_end = field_end(f[0], e);
+            if (from_end == f[0]) return; // nothing to link
+            gfa_link_t link;
+            if (!parse_id(f[0], from_end, link.from)
+                || !parse_id(f[2], field_end(f[2], e), link.to)
+                || (*f[1] != '+' && *f[1] != '-')
+                || (*f[3] != '+' && *f[3] != '-')) {
+                gfa_error("malformed link line '" + std::string(b, e) + "'");
+            }
+            link.from_rev = *f[1] == '-';
+            link.to_rev = *f[3] == '-';
+            records.links.push_back(link);
+        }
+
+        /// Parse the step list starting at s and any tags that follow it
+        void parse_path_steps(const char* s, const char* e, gfa_path_t& path) {
+            const char* steps_end = field_end(s, e);
+            path.steps.reserve(std::count(s, steps_end, ',') + 1);
+            while (s < steps_end) {
+                const char* c = (const char*)memchr(s, ',', steps_end - s);
+                const char* step_end = c ? c : steps_end;
+                uint64_t id;
+                if (step_end - s < 2
+                    || (*(step_end-1) != '+' && *(step_end-1) != '-')
+                    || !parse_id(s, step_end-1, id)) {
+                    gfa_error("malformed step '" + std::string(s, step_end) + "' in path " + path.name);
+                }
+                path.steps.push_back(id << 1 | (*(step_end-1) == '-'));
+                s = c ? c + 1 : steps_end;
+            }
+            // skip the overlaps and look for our circularity tag
+            if (steps_end == e) return;
+            const char* t = field_end(steps_end + 1, e);
+            static const std::string circular_tag = "TP:Z:circular";
+            while (t < e) {
+                const char* tag = t + 1;
+                t = field_end(tag, e);
+                if (t - tag == (int64_t)circular_tag.size()
+                    && std::equal(tag, t, circular_tag.begin())) {
+                    path.is_circular = true;
+                }
+            }
+        }
+
+        void parse_path(const char* b, const char* e, gfa_records_t& records) {
+            const char* name_end = field_end(b, e);
+            records.paths.emplace_back();
+            auto& path = records.paths.back();
+            path.name.reserve(name_end - b);
+            for (const char* c = b; c != name_end; ++c) {
+                if (!std::isspace(*c)) path.name.push_back(*c);
+            }
+            if (name_end == e) return; // no steps
+            parse_path_steps(name_end + 1, e, path);
+        }
+
+        /// Tokenize the S, L and P lines in [begin, end), buffering their records in order.
+        /// If in_path is set, begin falls inside the step list of a P line.
+        void parse_gfa_lines(const char* begin, const char* end, gfa_records_t& records,
+                             bool in_path = false) {
+            const char* p = begin;
+            if (in_path) {
+                const char* nl = (const char*)memchr(p, '\n', end - p);
+                const char* line_end = nl ? nl : end;
+                if (line_end > p && *(line_end-1) == '\r') --line_end;
+                records.paths.emplace_back();
+                records.paths.back().is_continuation = true;
+                parse_path_steps(p, line_end, records.paths.back());
+                p = nl ? nl + 1 : end;
+            }
+            while (p < end) {
+                const char* nl = (const char*)memchr(p, '\n', end - p);
+                const char* line_end = nl ? nl : end;
+                const char* next = nl ? nl + 1 : end;
+                if (line_end > p && *(line_end-1) == '\r') --line_end;
+                if (line_end - p > 2 && p[1] == '\t') {
+                    switch (*p) {
+                    case 'S': parse_segment(p + 2, line_end, records); break;
+                    case 'L': parse_link(p + 2, line_end, records); break;
+                    case 'P': parse_path(p + 2, line_end, records); break;
+                    default: break;
+                    }
+                }
+                p = next;
+            }
+        }
+
+        /// Split [begin, end) into about n chunks that can be parsed independently.
+        /// Chunks start at line starts, except inside the step list of a P line,
+        /// where they start after a comma so that long paths are parsed in parallel.
+        /// Returns the chunk starts followed by end, and marks the chunks that begin in a path.
+        std::vector<const char*> chunk_gfa(const char* begin, const char* end, uint64_t n,
+                                           std::vector<bool>& in_path) {
+            std::vector<const char*> bounds = { begin };
+            in_path = { false };
+            uint64_t size = end - begin;
+            for (uint64_t i = 1; i < n; ++i) {
+                const char* b = std::max(begin + size / n * i, bounds.back());
+                if (b >= end) break;
+                bool b_in_path = false;
+                if (b == begin || *(b-1) != '\n') {
+                    const char* nl = (const char*)memrchr(begin, '\n', b - begin);
+                    const char* line_start = nl ? nl + 1 : begin;
+                    nl = (const char*)memchr(b, '\n', end - b);
+                    const char* line_end = nl ? nl : end;
+                    const char* next_line = nl ? nl + 1 : end;
+                    const char* steps = nullptr;
+                    if (line_end - line_start > 2 && line_start[0] == 'P' && line_start[1] == '\t') {
+                        const char* name_end = field_end(line_start + 2, line_end);
+                        if (name_end < line_end) steps = name_end + 1;
+                    }
+                    const char* c = nullptr;
+                    if (steps && b > steps) {
+                        const char* steps_end = field_end(steps, line_end);
+                        if (b < steps_end) {
+                            c = (const char*)memchr(b, ',', steps_end - b);
+                        }
+                    }
+                    if (c) {
+                        b = c + 1;
+                        b_in_path = true;
+                    } else {
+                        b = next_line;
+                    }
+                }
+                if (b >= end || b == bounds.back()) continue;
+                bounds.push_back(b);
+                in_path.push_back(b_in_path);
             }
-        });
-        if (show_progress) {
-            i = 0; std::cerr << std::endl;
+            bounds.push_back(end);
+            return bounds;
         }
-        gg.for_each_edge_line_in_file(filename, [&](gfak::edge_elem e) {
-            if (e.source_name.empty()) return;
-            handlegraph::handle_t a = graph->get_handle(stol(e.source_name), !e.source_orientation_forward);
-            handlegraph::handle_t b = graph->get_handle(stol(e.sink_name), !e.sink_orientation_forward);
-            graph->create_edge(a, b);
+
+        /// A bounded queue of line-aligned blocks of GFA text, numbered in file order
+        class block_queue_t {
+        public:
+            block_queue_t(uint64_t capacity) : _capacity(capacity) { }
+            /// Blocks until there is room for the block
+            void push(std::vector<char>&& block) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _not_full.wait(lock, [this](void) { return _blocks.size() < _capacity; });
+                _blocks.emplace_back(_pushed++, std::move(block));
+                _not_empty.notify_one();
+            }
+            /// Signal that no more blocks will be pushed
+            void close(void) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _closed = true;
+                _not_empty.notify_all();
+            }
+            /// Blocks until a block is available, returning false once the queue is closed and drained
+            bool pop(std::pair<uint64_t, std::vector<char>>& item) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _not_empty.wait(lock, [this](void) { return !_blocks.empty() || _closed; });
+                if (_blocks.empty()) return false;
+                item = std::move(_blocks.front());
+                _blocks.pop_front();
+                _not_full.notify_one();
+                return true;
+            }
+        private:
+            uint64_t _capacity;
+            uint64_t _pushed = 0;
+            bool _closed = false;
+            std::deque<std::pair<uint64_t, std::vector<char>>> _blocks;
+            std::mutex _mutex;
+            std::condition_variable _not_full;
+            std::condition_variable _not_empty;
+        };
+
+        /// Check for the gzip magic number at the start of a regular file
+        bool is_gzipped(const std::string& filename) {
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            unsigned char magic[2];
+            return in.read((char*)magic, 2) && magic[0] == 0x1f && magic[1] == 0x8b;
+        }
+
+        /// Inflate the stream into blocks that end at a line boundary and queue them.
+        /// Lines longer than a block are carried over until their newline is read.
+        void inflate_blocks(gzFile gz, const std::string& filename, block_queue_t& queue) {
+            const uint64_t block_size = 1 << 23;
+            std::vector<char> carry;
+            while (true) {
+                std::vector<char> block = std::move(carry);
+                carry.clear();
+                uint64_t old_size = block.size();
+                block.resize(old_size + block_size);
+                int n = gzread(gz, block.data() + old_size, block_size);
+                if (n < 0) {
+                    int err;
+                    gfa_error("could not decompress " + filename + ": " + gzerror(gz, &err));
+                }
+                block.resize(old_size + n);
+                if (n == 0) {
+                    if (!block.empty()) queue.push(std::move(block));
+                    break;
+                }
+                const char* nl = (const char*)memrchr(block.data() + old_size, '\n', n);
+                if (!nl) {
+                    carry = std::move(block);
+                    continue;
+                }
+                uint64_t line_aligned = nl - block.data() + 1;
+                carry.assign(block.begin() + line_aligned, block.end());
+                block.resize(line_aligned);
+                queue.push(std::move(block));
+            }
+            queue.close();
+        }
+
+        /// Stream a gzipped (or, from stdin, possibly plain) GFA through a decompression thread
+        /// that feeds n_threads parsing threads, returning the parsed blocks in file order.
+        std::vector<gfa_records_t> parse_compressed_gfa(const std::string& filename, uint64_t n_threads) {
+            gzFile gz = filename == "-" ? gzdopen(dup(STDIN_FILENO), "rb") : gzopen(filename.c_str(), "rb");
+            if (gz == nullptr) {
+                gfa_error("could not open " + filename);
+            }
+            gzbuffer(gz, 1 << 20);
+            // bound the decompressed text waiting to be parsed
+            block_queue_t queue(n_threads * 2);
+            std::thread inflater(inflate_blocks, gz, std::cref(filename), std::ref(queue));
+            std::vector<gfa_records_t> chunks;
+            std::mutex chunks_mutex;
+            auto parser = [&](void) {
+                std::pair<uint64_t, std::vector<char>> block;
+                while (queue.pop(block)) {
+                    gfa_records_t records;
+                    parse_gfa_lines(block.second.data(), block.second.data() + block.second.size(), records);
+                    // the vector's storage moves with it, so the sequence pointers stay valid
+                    records.text = std::move(block.second);
+                    std::lock_guard<std::mutex> lock(chunks_mutex);
+                    if (chunks.size() <= block.first) chunks.resize(block.first + 1);
+                    chunks[block.first] = std::move(records);
+                }
+            };
+            std::vector<std::thread> parsers;
+            for (uint64_t t = 1; t < n_threads; ++t) {
+                parsers.emplace_back(parser);
+            }
+            parser();
+            for (auto& p : parsers) p.join();
+            inflater.join();
+            gzclose(gz);
+            return chunks;
+        }
+
+        void insert_records(const std::vector<gfa_records_t>& chunks,
+                            handlegraph::MutablePathMutableHandleGraph* graph,
+                            bool show_progress) {
+            uint64_t min_id = std::numeric_limits<uint64_t>::max();
+            for (auto& records : chunks) {
+                if (!records.segments.empty()) min_id = std::min(min_id, records.min_id);
+            }
+            if (min_id == std::numeric_limits<uint64_t>::max()) return;
+            uint64_t id_increment = min_id - 1;
+            // set the min id as an offset
+            graph->set_id_increment(id_increment);
+            uint64_t i = 0;
+            for (auto& records : chunks) {
+                for (auto& s : records.segments) {
+                    graph->create_handle(std::string(s.seq, s.len), s.id - id_increment);
+                    if (show_progress) {
+                        if (i % 1000 == 0) std::cerr << "node " << i << "\r";
+                        ++i;
+                    }
+                }
+            }
+            if (show_progress) {
+                i = 0; std::cerr << std::endl;
+            }
+            for (auto& records : chunks) {
+                for (auto& l : records.links) {
+                    graph->create_edge(graph->get_handle(l.from, l.from_rev),
+                                       graph->get_handle(l.to, l.to_rev));
+                    if (show_progress) {
+                        if (i % 1000 == 0) std::cerr << "edge " << i << "\r";
+                        ++i;
+                    }
+                }
+            }
             if (show_progress) {
-                if (i % 1000 == 0) std::cerr << "edge " << i << "\r";
-                ++i;
+                i = 0; std::cerr << std::endl;
+            }
+            handlegraph::path_handle_t path;
+            bool has_curr_path = false;
+            for (auto& records : chunks) {
+                for (auto& p : records.paths) {
+                    if (p.is_continuation) {
+                        // stitch onto the path begun in an earlier chunk
+                        if (!has_curr_path) continue;
+                        if (p.is_circular) graph->set_circularity(path, true);
+                    } else {
+                        has_curr_path = !p.steps.empty();
+                        if (!has_curr_path) continue;
+                        if (!graph->has_path(p.name)) {
+                            if (show_progress) {
+                                std::cerr << "path " << ++i << "\r";
+                            }
+                            path = graph->create_path_handle(p.name, p.is_circular);
+                        } else {
+                            path = graph->get_path_handle(p.name);
+                        }
+                    }
+                    for (auto& s : p.steps) {
+                        graph->append_step(path, graph->get_handle(s >> 1, s & 1));
+                    }
+                }
             }
-        });
-        if (show_progress) {
-            i = 0; std::cerr << std::endl;
         }
-        gg.for_each_path_element_in_file(filename, [&](const std::string& path_name_raw,
-                                                       const std::string& node_id,
-                                                       bool is_rev,
-                                                       const std::string& cigar,
-                                                       bool is_empty,
-                                                       bool is_circular) {
+
+        /// Order the records with the given sorts on a topology-only graph, then build
+        /// the graph once, with its nodes in their final order and compacted ids.
+        /// The path steps are moved out of the records as they're indexed.
+        void insert_ordered_records(std::vector<gfa_records_t>& chunks,
+                                    handlegraph::MutablePathMutableHandleGraph* graph,
+                                    const std::vector<graph_order_f>& sorts,
+                                    bool show_progress) {
+            topology_graph_t topology;
+            for (auto& records : chunks) {
+                for (auto& s : records.segments) {
+                    topology.add_node(s.id, s.seq, s.len);
+                }
+                for (auto& l : records.links) {
+                    topology.add_edge(l.from, l.from_rev, l.to, l.to_rev);
+                }
+                std::vector<gfa_link_t>().swap(records.links);
+            }
+            std::unordered_map<std::string, handlegraph::path_handle_t> path_handles;
             handlegraph::path_handle_t path;
-            std::string path_name = path_name_raw;
-            path_name.erase(std::remove_if(path_name.begin(), path_name.end(), [](char c) { return std::isspace(c); }), path_name.end());
-            if (!graph->has_path(path_name)) {
-                if (show_progress) {
-                    std::cerr << "path " << ++i << "\r";
-                }
-                path = graph->create_path_handle(path_name);
-            } else {
-                path = graph->get_path_handle(path_name);
-            }
-            handlegraph::handle_t occ = graph->get_handle(stol(node_id), is_rev);
-            graph->append_step(path, occ);
-        });
+            bool has_curr_path = false;
+            for (auto& records : chunks) {
+                for (auto& p : records.paths) {
+                    if (p.is_continuation) {
+                        if (!has_curr_path) continue;
+                    } else {
+                        has_curr_path = !p.steps.empty();
+                        if (!has_curr_path) continue;
+                        auto f = path_handles.find(p.name);
+                        if (f == path_handles.end()) {
+                            path = topology.add_path(p.name, false);
+                            path_handles[p.name] = path;
+                        } else {
+                            path = f->second;
+                        }
+                    }
+                    // circularity may be tagged on any fragment of a P line
+                    if (p.is_circular) topology.set_circularity(path, true);
+                    for (auto& s : p.steps) {
+                        topology.append_step(path, s >> 1, s & 1);
+                    }
+                    std::vector<uint64_t>().swap(p.steps);
+                }
+            }
+            topology.index();
+            for (auto& sort : sorts) {
+                topology.apply_ordering(sort(topology));
+            }
+            if (topology.get_node_count() == 0) return;
+            // ids follow the final rank of each node
+            graph->set_id_increment(0);
+            uint64_t i = 0;
+            topology.for_each_handle([&](const handlegraph::handle_t& h) {
+                    graph->create_handle(std::string(topology.get_sequence_data(h), topology.get_length(h)),
+                                         topology.get_rank(h) + 1);
+                    if (show_progress) {
+                        if (i % 1000 == 0) std::cerr << "node " << i << "\r";
+                        ++i;
+                    }
+                });
+            if (show_progress) {
+                i = 0; std::cerr << std::endl;
+            }
+            auto to_graph = [&](const handlegraph::handle_t& h) {
+                return graph->get_handle(topology.get_rank(h) + 1, topology.get_is_reverse(h));
+            };
+            topology.for_each_edge([&](const handlegraph::edge_t& e) {
+                    graph->create_edge(to_graph(e.first), to_graph(e.second));
+                    if (show_progress) {
+                        if (i % 1000 == 0) std::cerr << "edge " << i << "\r";
+                        ++i;
+                    }
+                });
+            if (show_progress) {
+                i = 0; std::cerr << std::endl;
+            }
+            topology.for_each_path_handle([&](const handlegraph::path_handle_t& p) {
+                    if (show_progress) {
+                        std::cerr << "path " << ++i << "\r";
+                    }
+                    handlegraph::path_handle_t new_path = graph->create_path_handle(topology.get_path_name(p),
+                                                                                    topology.get_is_circular(p));
+                    topology.for_each_step_in_path(p, [&](const handlegraph::step_handle_t& step) {
+                            graph->append_step(new_path, to_graph(topology.get_handle_of_step(step)));
+                        });
+                });
+        }
+
+        /// Parse the GFA into chunks of records, in file order, and hand them to the callback
+        /// while the text their sequences point into is still alive.
+        void parse_gfa(const std::string& gfa_filename, uint64_t n_threads,
+                       const std::function<void(std::vector<gfa_records_t>&)>& callback) {
+            if (!n_threads) n_threads = 1;
+            if (gfa_filename == "-" || is_gzipped(gfa_filename)) {
+                std::vector<gfa_records_t> chunks = parse_compressed_gfa(gfa_filename, n_threads);
+                callback(chunks);
+                return;
+            }
+            gfa_buffer_t gfa(gfa_filename);
+            // oversplit so that threads stay busy when line lengths are uneven
+            std::vector<bool> in_path;
+            std::vector<const char*> bounds = chunk_gfa(gfa.begin(), gfa.end(),
+                                                        n_threads == 1 ? 1 : n_threads * 8,
+                                                        in_path);
+            std::vector<gfa_records_t> chunks(bounds.size() - 1);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+            for (uint64_t i = 0; i < chunks.size(); ++i) {
+                parse_gfa_lines(bounds[i], bounds[i+1], chunks[i], in_path[i]);
+            }
+            callback(chunks);
+        }
+
+    }
+
+    void gfa_to_handle(const std::string& gfa_filename, handlegraph::MutablePathMutableHandleGraph* graph,
+                       bool show_progress, uint64_t n_threads) {
+        parse_gfa(gfa_filename, n_threads, [&](std::vector<gfa_records_t>& chunks) {
+                insert_records(chunks, graph, show_progress);
+            });
+    }
+
+    void gfa_to_handle_ordered(const std::string& gfa_filename,
+                               handlegraph::MutablePathMutableHandleGraph* graph,
+                               const std::vector<graph_order_f>& sorts,
+                               bool show_progress, uint64_t n_threads) {
+        parse_gfa(gfa_filename, n_threads, [&](std::vector<gfa_records_t>& chunks) {
+                insert_ordered_records(chunks, graph, sorts, show_progress);
+            });
     }
 }
@@ -8,18 +8,42 @@
  *
  */
 
-#include "gfakluge.hpp"
 #include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
 #include <limits>
+#include <handlegraph/path_handle_graph.hpp>
 #include <handlegraph/mutable_path_mutable_handle_graph.hpp>
 
 namespace odgi {
 
     /// Fills a handle graph with an instantiation of a sequence graph from a GFA file.
     /// Handle graph must be empty when passed into function.
-    void gfa_to_handle(const string& gfa_filename,
+    /// The file is memory mapped and its S, L and P lines are read in a single scan,
+    /// buffering the records until the id range of the graph is known.
+    /// Gzipped files, and anything read from stdin via "-", are instead inflated on a
+    /// dedicated thread that feeds line-aligned blocks to the parsing threads through a bounded queue.
+    /// With n_threads > 1 the text is split into chunks that are parsed in parallel,
+    /// and their records are inserted in file order, so the graph matches the serial build.
+    void gfa_to_handle(const std::string& gfa_filename,
                        handlegraph::MutablePathMutableHandleGraph* graph,
-                       bool show_progress = false);
+                       bool show_progress = false,
+                       uint64_t n_threads = 1);
+
+    /// A sort, returning the handles of the graph in their new order
+    typedef std::function<std::vector<handlegraph::handle_t>(const handlegraph::PathHandleGraph&)> graph_order_f;
+
+    /// Fills an empty handle graph from a GFA file, with its nodes in the order given by a series of sorts.
+    /// The sorts run on a lightweight topology_graph_t of ids, links and paths that refers to the
+    /// sequences in the GFA text, which is renumbered after each sort just as
+    /// graph_t::apply_ordering(order, true) would be. The graph is then built once, in its final
+    /// order and with ids compacted to 1..n, rather than being built and then rebuilt sorted.
+    void gfa_to_handle_ordered(const std::string& gfa_filename,
+                               handlegraph::MutablePathMutableHandleGraph* graph,
+                               const std::vector<graph_order_f>& sorts,
+                               bool show_progress = false,
+                               uint64_t n_threads = 1);
 
 }
 #endif
@@ -66,6 +66,7 @@ public:
     };
     uint64_t sequence_size(void) const;
     const std::string sequence(void) const;
+    inline const char* sequence_data(void) const { return (const char*)bytes.data() + seq_start(); }
     void set_sequence(const std::string& seq);
     std::vector<uint64_t> edges(void) const;
     void add_edge(const uint64_t& relative_id, const uint64_t& edge_type);
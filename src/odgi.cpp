@@ -1370,54 +1370,98 @@ void graph_t::display(void) const {
 
 }
 
-void graph_t::to_gfa(std::ostream& out) const {
-    out << "H\tVN:Z:1.0" << std::endl;
-    // for each node
-    for_each_handle([&out,this](const handle_t& h) {
-            out << "S\t" << get_id(h) << "\t" << get_sequence(h) << std::endl;
-            {
+/// Append the decimal representation of i to the buffer
+static inline void append_uint(std::string& buf, uint64_t i) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = '0' + i % 10;
+        i /= 10;
+    } while (i);
+    while (n) buf.push_back(tmp[--n]);
+}
+
+void graph_t::to_gfa(std::ostream& out, uint64_t nthreads) const {
+    if (!nthreads) nthreads = 1;
+    out << "H\tVN:Z:1.0\n";
+    // we format a batch of chunks in parallel, then write them in order,
+    // which bounds the memory used by our buffers
+    const uint64_t batch_size = nthreads * 4;
+    std::vector<std::string> buffers(batch_size);
+    // nodes and their edges, in chunks of node ranks
+    const uint64_t node_chunk_size = 16384;
+    uint64_t node_chunks = (node_v.size() + node_chunk_size - 1) / node_chunk_size;
+    for (uint64_t batch = 0; batch < node_chunks; batch += batch_size) {
+        uint64_t batch_end = std::min(batch + batch_size, node_chunks);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+        for (uint64_t c = batch; c < batch_end; ++c) {
+            std::string& buf = buffers[c - batch];
+            buf.clear();
+            uint64_t end = std::min((c + 1) * node_chunk_size, (uint64_t)node_v.size());
+            for (uint64_t i = c * node_chunk_size; i < end; ++i) {
+                if (deleted_node_bv.at(i) == 1) continue;
+                const node_t& node = node_v[i];
+                nid_t node_id = get_id(number_bool_packing::pack(i, false));
+                buf.append("S\t");
+                append_uint(buf, node_id);
+                buf.push_back('\t');
+                buf.append(node.sequence_data(), node.sequence_size());
+                buf.push_back('\n');
                 // use this direct iteration to avoid double counting edges
                 // we only consider write the edges relative to their start
-                const node_t& node = node_v.at(number_bool_packing::unpack_number(h));
-                bool is_rev = get_is_reverse(h);
-                nid_t node_id = get_id(h);
                 const std::vector<uint64_t> node_edges = node.edges();
-                for (uint64_t i = 0; i < node_edges.size(); i+=2) {
+                for (uint64_t j = 0; j < node_edges.size(); j+=2) {
                     // unpack the edge
-                    uint64_t other_id = edge_delta_to_id(node_id, node_edges.at(i));
-                    uint8_t packed_edge = node_edges.at(i+1);
-                    bool on_rev = edge_helper::unpack_on_rev(packed_edge);
-                    bool other_rev = edge_helper::unpack_other_rev(packed_edge);
-                    bool to_curr = edge_helper::unpack_to_curr(packed_edge);
-                    if (!to_curr) {
-                        out << "L\t" << node_id << "\t"
-                            << (on_rev?"-":"+")
-                            << "\t" << other_id << "\t"
-                            << (other_rev?"-":"+")
-                            << "\t0M" << std::endl;
-                    }
+                    uint8_t packed_edge = node_edges[j+1];
+                    if (edge_helper::unpack_to_curr(packed_edge)) continue;
+                    uint64_t other_id = edge_delta_to_id(node_id, node_edges[j]);
+                    buf.append("L\t");
+                    append_uint(buf, node_id);
+                    buf.append(edge_helper::unpack_on_rev(packed_edge) ? "\t-\t" : "\t+\t");
+                    append_uint(buf, other_id);
+                    buf.append(edge_helper::unpack_other_rev(packed_edge) ? "\t-\t0M\n" : "\t+\t0M\n");
                 }
             }
+        }
+        for (uint64_t c = batch; c < batch_end; ++c) {
+            out.write(buffers[c - batch].data(), buffers[c - batch].size());
+        }
+    }
+    // paths, one buffer per path
+    std::vector<path_handle_t> paths;
+    for_each_path_handle([&paths](const path_handle_t& p) {
+            paths.push_back(p);
         });
-    for_each_path_handle([&out,this](const path_handle_t& p) {
-            //step_handle_t step = path_begin(p);
-            out << "P\t" << get_path_name(p) << "\t";
-            for_each_step_in_path(p, [this,&out](const step_handle_t& step) {
+    for (uint64_t batch = 0; batch < paths.size(); batch += batch_size) {
+        uint64_t batch_end = std::min(batch + batch_size, (uint64_t)paths.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+        for (uint64_t k = batch; k < batch_end; ++k) {
+            std::string& buf = buffers[k - batch];
+            buf.clear();
+            const path_handle_t& p = paths[k];
+            buf.append("P\t");
+            buf.append(get_path_name(p));
+            buf.push_back('\t');
+            bool first = true;
+            for_each_step_in_path(p, [this,&buf,&first](const step_handle_t& step) {
                     handle_t h = get_handle_of_step(step);
-                    out << get_id(h) << (get_is_reverse(h)?"-":"+");
-                    if (has_next_step(step)) out << ",";
+                    if (!first) buf.push_back(',');
+                    first = false;
+                    append_uint(buf, get_id(h));
+                    buf.push_back(get_is_reverse(h) ? '-' : '+');
                 });
-            out << "\t";
-            uint64_t steps_for_asterisk = get_step_count(p)-1;
-            for (uint64_t i = 0; i < steps_for_asterisk; ++i) {
-                out << "*";
-                if (i < steps_for_asterisk-1) out << ",";
-            }
+            // the overlaps are implied by the edges
+            buf.append("\t*");
             if (get_is_circular(p)) {
-                out << "\t" << "TP:Z:circular";
+                buf.append("\tTP:Z:circular");
             }
-            out << std::endl;
-        });
+            buf.push_back('\n');
+        }
+        for (uint64_t k = batch; k < batch_end; ++k) {
+            out.write(buffers[k - batch].data(), buffers[k - batch].size());
+        }
+    }
+    out.flush();
 }
 
 uint32_t graph_t::get_magic_number(void) const {
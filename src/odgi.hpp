@@ -366,8 +366,8 @@ public:
     /// A helper function to visualize the state of the graph
     void display(void) const;
 
-    /// Convert to GFA (for debugging)
-    void to_gfa(std::ostream& out) const;
+    /// Convert to GFA, formatting nodes, edges and paths into buffers in parallel
+    void to_gfa(std::ostream& out, uint64_t nthreads = 1) const;
 
     /// Magic number header for serialization
     uint32_t get_magic_number(void) const;
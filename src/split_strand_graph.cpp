@@ -0,0 +1,88 @@
+#include "split_strand_graph.hpp"
+
+namespace odgi {
+
+split_strand_graph_t::split_strand_graph_t(const HandleGraph* underlying) : underlying(underlying) {
+    uint64_t max_rank = 0;
+    underlying->for_each_handle([&](const handle_t& handle) {
+            max_rank = std::max(max_rank, (uint64_t)number_bool_packing::unpack_number(handle));
+        });
+    rank_count = underlying->get_node_count() ? 2 * (max_rank + 1) : 0;
+}
+
+bool split_strand_graph_t::has_node(nid_t node_id) const {
+    return node_id >= 1 && (uint64_t)node_id <= rank_count;
+}
+
+handle_t split_strand_graph_t::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id - 1, is_reverse);
+}
+
+nid_t split_strand_graph_t::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle) + 1;
+}
+
+bool split_strand_graph_t::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t split_strand_graph_t::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t split_strand_graph_t::get_length(const handle_t& handle) const {
+    return underlying->get_length(get_underlying_handle(handle));
+}
+
+std::string split_strand_graph_t::get_sequence(const handle_t& handle) const {
+    return underlying->get_sequence(get_underlying_handle(handle));
+}
+
+size_t split_strand_graph_t::get_degree(const handle_t& handle, bool go_left) const {
+    return underlying->get_degree(get_underlying_handle(handle), go_left);
+}
+
+size_t split_strand_graph_t::get_node_count(void) const {
+    return rank_count;
+}
+
+nid_t split_strand_graph_t::min_node_id(void) const {
+    return 1;
+}
+
+nid_t split_strand_graph_t::max_node_id(void) const {
+    return rank_count;
+}
+
+bool split_strand_graph_t::follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    // an underlying handle reached from a handle of the view lies on the node for its strand,
+    // read in the same orientation as the handle we started from
+    bool is_rev = get_is_reverse(handle);
+    return underlying->follow_edges(get_underlying_handle(handle), go_left, [&](const handle_t& next) {
+            return iteratee(number_bool_packing::pack(2 * number_bool_packing::unpack_number(next)
+                                                      + (number_bool_packing::unpack_bit(next) ^ is_rev),
+                                                      is_rev));
+        });
+}
+
+bool split_strand_graph_t::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    if (parallel) {
+        volatile bool flag = true;
+#pragma omp parallel for
+        for (uint64_t i = 0; i < rank_count; ++i) {
+            if (!flag) continue;
+            bool result = iteratee(number_bool_packing::pack(i, false));
+#pragma omp atomic
+            flag &= result;
+        }
+        return flag;
+    }
+    for (uint64_t i = 0; i < rank_count; ++i) {
+        if (!iteratee(number_bool_packing::pack(i, false))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+/** \file
+ * split_strand_graph.hpp: defines a handle graph view that splits the strands of
+ * another graph into separate nodes
+ */
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include <string>
+#include <algorithm>
+#include <omp.h>
+
+namespace odgi {
+
+using namespace handlegraph;
+
+    /**
+     * A HandleGraph view with the same sequence and path space as the underlying graph,
+     * but with every sequence on the forward strand, as algorithms::split_strands
+     * builds. Each underlying node of rank r has a node of rank 2r for its forward
+     * strand and 2r + 1 for its reverse strand, and edges join the nodes only in their
+     * forward orientations. Nothing is copied: ids and edges come from id arithmetic
+     * on the underlying graph, whose handles must pack dense node ranks, as in graph_t.
+     */
+    class split_strand_graph_t : public HandleGraph {
+    public:
+
+        /// Initialize as a view of the strands of the underlying graph
+        split_strand_graph_t(const HandleGraph* underlying);
+
+        /// The handle of the underlying graph that reads the same sequence as a handle of the view
+        inline handle_t get_underlying_handle(const handle_t& handle) const {
+            uint64_t rank = number_bool_packing::unpack_number(handle);
+            return number_bool_packing::pack(rank >> 1, (rank & 1) ^ number_bool_packing::unpack_bit(handle));
+        }
+
+        //////////////////////////
+        /// HandleGraph interface
+        //////////////////////////
+
+        /// Method to check if a node exists by ID
+        bool has_node(nid_t node_id) const;
+
+        /// Look up the handle for the node with the given ID in the given orientation
+        handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+        /// Get the ID from a handle
+        nid_t get_id(const handle_t& handle) const;
+
+        /// Get the orientation of a handle
+        bool get_is_reverse(const handle_t& handle) const;
+
+        /// Invert the orientation of a handle (potentially without getting its ID)
+        handle_t flip(const handle_t& handle) const;
+
+        /// Get the length of a node
+        size_t get_length(const handle_t& handle) const;
+
+        /// Get the sequence of a node, presented in the handle's local forward orientation.
+        std::string get_sequence(const handle_t& handle) const;
+
+        /// Get the number of edges on the right (go_left = false) or left (go_left
+        /// = true) side of the given handle.
+        size_t get_degree(const handle_t& handle, bool go_left) const;
+
+        /// Return the number of nodes in the graph
+        size_t get_node_count(void) const;
+
+        /// Return the smallest ID in the graph
+        nid_t min_node_id(void) const;
+
+        /// Return the largest ID in the graph
+        nid_t max_node_id(void) const;
+
+    protected:
+
+        /// Loop over all the handles to next/previous (right/left) nodes.
+        bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+        /// Loop over all the nodes in the graph in their local forward orientations, in rank order.
+        bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+    private:
+
+        const HandleGraph* underlying = nullptr;
+        /// the number of ranks in the view, twice those of the underlying graph
+        uint64_t rank_count = 0;
+    };
+
+}
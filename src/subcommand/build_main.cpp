@@ -2,9 +2,10 @@
 #include "odgi.hpp"
 #include "gfa_to_handle.hpp"
 #include "args.hxx"
+#include "threads.hpp"
 #include <cstdio>
 #include <algorithm>
-#include "algorithms/topological_sort.hpp"
+#include "algorithms/pipeline_sort.hpp"
 
 namespace odgi {
 
@@ -22,12 +23,15 @@ int main_build(int argc, char** argv) {
     
     args::ArgumentParser parser("construct a dynamic succinct variation graph");
     args::HelpFlag help(parser, "help", "display this help summary", {'h', "help"});
-    args::ValueFlag<std::string> gfa_file(parser, "FILE", "construct the graph from this GFA input file", {'g', "gfa"});
+    args::ValueFlag<std::string> gfa_file(parser, "FILE", "construct the graph from this GFA input file, which may be gzipped (- for stdin)", {'g', "gfa"});
     args::ValueFlag<std::string> dg_out_file(parser, "FILE", "store the graph self index in this file", {'o', "out"});
     args::Flag to_gfa(parser, "to_gfa", "write the graph to stdout in GFA format", {'G', "to-gfa"});
     args::Flag toposort(parser, "sort", "apply generalized topological sort to the graph and set node ids to order", {'s', "sort"});
+    args::ValueFlag<std::string> sort_pipeline(parser, "STRING", "order the graph while it is built by this series of single-character odgi sort pipeline sorts (e.g. 's' for the default topological sort, as -s), setting node ids to order", {'S', "sort-pipeline"});
+    args::Flag frontier_topo(parser, "frontier-topo", "run the topological sorts of -s and -S frontier by frontier, processing each frontier in parallel (as odgi sort -F)", {'F', "frontier-topo"});
     args::Flag debug(parser, "debug", "enable debugging", {'d', "debug"});
     args::Flag progress(parser, "progress", "show progress updates", {'p', "progress"});
+    args::ValueFlag<uint64_t> num_threads(parser, "N", "number of threads to use for parsing the GFA and for the parallel sorts", {'t', "threads"});
     try {
         parser.ParseCLI(argc, argv);
     } catch (args::Help) {
@@ -43,14 +47,13 @@ int main_build(int argc, char** argv) {
         return 1;
     }
 
-    /*
     size_t n_threads = args::get(num_threads);
     if (n_threads) {
         omp_set_num_threads(args::get(num_threads));
     } else {
+        n_threads = 1;
         omp_set_num_threads(1);
     }
-    */
     graph_t graph;
     
     //make_graph();
@@ -60,21 +63,43 @@ int main_build(int argc, char** argv) {
         return 1;
     }
     std::string gfa_filename = args::get(gfa_file);
+    std::string pipeline = args::get(sort_pipeline);
+    if (args::get(toposort) && pipeline.empty()) {
+        pipeline = "s";
+    }
+    for (auto c : pipeline) {
+        if (!algorithms::is_pipeline_sort(c)) {
+            std::cerr << "[odgi build] error: '" << c << "' is not a sort in the odgi sort pipeline" << std::endl;
+            return 1;
+        }
+    }
     if (gfa_filename.size()) {
-        gfa_to_handle(gfa_filename, &graph, args::get(progress));
+        if (pipeline.empty()) {
+            gfa_to_handle(gfa_filename, &graph, args::get(progress), n_threads);
+        } else {
+            // compute the order before building the graph, so that it's only built once
+            algorithms::pipeline_sort_params_t params;
+            params.progress = args::get(progress);
+            params.num_threads = n_threads;
+            params.frontier_topological = args::get(frontier_topo);
+            std::vector<graph_order_f> sorts;
+            for (auto c : pipeline) {
+                sorts.push_back([c,&params](const PathHandleGraph& g) {
+                        return algorithms::pipeline_sort_order(g, c, params);
+                    });
+            }
+            gfa_to_handle_ordered(gfa_filename, &graph, sorts, args::get(progress), n_threads);
+        }
     }
     if (args::get(progress)) {
         std::cerr << std::endl;
     }
-    if (args::get(toposort)) {
-        graph.apply_ordering(algorithms::topological_order(&graph, true, args::get(progress)), true);
-    }
     // here we should measure memory usage etc.
     if (args::get(debug)) {
         graph.display();
     }
     if (args::get(to_gfa)) {
-        graph.to_gfa(std::cout);
+        graph.to_gfa(std::cout, n_threads);
     }
     std::string outfile = args::get(dg_out_file);
     if (outfile.size()) {
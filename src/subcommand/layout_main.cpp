@@ -4,55 +4,13 @@
 #include "args.hxx"
 #include "threads.hpp"
 #include "algorithms/sgd_layout.hpp"
+#include "algorithms/draw_layout.hpp"
 
 namespace odgi {
 
 using namespace odgi::subcommand;
 
 
-void draw_svg(ostream& out, const std::vector<double>& X, const HandleGraph& graph, double scale) {
-    double border = 10.0;
-    double min_x = 0;
-    double min_y = 0;
-    double max_x = 0;
-    double max_y = 0;
-    // determine boundaries
-    uint64_t n = graph.get_node_count();
-    for (uint64_t i = 0; i < n; ++i) {
-        double x = X[i*2]*scale;
-        double y = X[i*2+1]*scale;
-        if (x < min_x) min_x = x;
-        if (x > max_x) max_x = x;
-        if (y < min_y) min_y = y;
-        if (y > max_y) max_y = y;
-    }
-    double width = max_x - min_x;
-    double height = max_y - min_y;
-    
-    out << "<svg width=\"" << width + border << "\" height=\"" << height + border << "\" "
-        << "viewBox=\"" << min_x - border/2<< " " << min_y - border/2 << " " << width + border << " " << height + border << "\" xmlns=\"http://www.w3.org/2000/svg\">"
-        << "<style type=\"text/css\">"
-        << "line{stroke:black;stroke-width:1.0;stroke-opacity:1.0;stroke-linecap:round;}"
-        //<< "circle{{r:" << 1.0 << ";fill:black;fill-opacity:" << 1.0 << "}}"
-        << "</style>"
-        << std::endl;
-
-    // iterate through graph edges
-    graph.for_each_edge([&](const edge_t& e) {
-            uint64_t a = graph.get_id(e.first)-1;
-            uint64_t b = graph.get_id(e.second)-1;
-            out << "<line x1=\"" << X[a*2]*scale << "\" x2=\"" << X[b*2]*scale
-                << "\" y1=\"" << X[a*2+1]*scale << "\" y2=\"" << X[b*2+1]*scale << "\"/>"
-                << std::endl;
-        });
-    /* // to draw nodes
-    for (uint64_t i = 0; i < n; ++i) {
-        std::cout << "<circle cx=\"" << X[i*2]*scale << "\" cy=\"" << X[i*2+1]*scale << "\" r=\"1.0\"/>" << std::endl;
-    }
-    */
-    out << "</svg>" << std::endl;
-}
-
 int main_layout(int argc, char** argv) {
 
     // trick argumentparser to do the right thing with the subcommand
@@ -68,10 +26,22 @@ int main_layout(int argc, char** argv) {
     args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the graph from this file", {'i', "idx"});
     args::ValueFlag<std::string> svg_out_file(parser, "FILE", "write the SVG rendering to this file", {'o', "out"});
     args::ValueFlag<uint64_t> iter_max(parser, "N", "maximum number of iterations to run the layout (default 30)", {'m', "iter-max"});
-    args::ValueFlag<uint64_t> num_pivots(parser, "N", "number of pivots for sparse layout (default 0, non-sparse layout)", {'p', "n-pivots"});
+    args::ValueFlag<uint64_t> num_pivots(parser, "N", "number of pivots for sparse layout (default 0, non-sparse layout for components of up to 10000 nodes and 30 pivots for bigger ones)", {'p', "n-pivots"});
     args::ValueFlag<double> eps_rate(parser, "N", "learning rate for SGD layout (default 0.01)", {'e', "eps"});
     args::ValueFlag<double> x_pad(parser, "N", "padding between connected component layouts (default 10.0)", {'x', "x-padding"});
     args::ValueFlag<double> render_scale(parser, "N", "SVG scaling (default 5.0)", {'R', "render-scale"});
+    args::ValueFlag<std::string> tiles_out_dir(parser, "DIR", "write the rendering as a pyramid of PNG tiles to DIR/z/x/y.png, for browsing big layouts", {'T', "tiles"});
+    args::ValueFlag<uint64_t> tile_levels(parser, "N", "number of zoom levels in the tile pyramid, level z having 2^z tiles per side (default 6)", {'z', "tile-levels"});
+    args::ValueFlag<uint64_t> tile_pixels(parser, "N", "width and height of the tiles in pixels (default 256)", {"tile-size"});
+    args::ValueFlag<uint64_t> nthreads(parser, "N", "number of threads to use for the layout of big components, and to lay out the others in parallel (default 1)", {'t', "threads"});
+    args::Flag path_guided(parser, "path-guided", "take the target distances between nodes from the paths, as their distance in bp along them, sampling pairs of steps from a path index as we go (the layout is then in bp, so scale down the rendering)", {'P', "path-guided"});
+    args::ValueFlag<uint64_t> path_bandwidth(parser, "N", "with -P, sample the partner of a step within this many bp of it along the path (default 0, anywhere on the path)", {'b', "path-bandwidth"});
+    args::ValueFlag<double> path_sampling_rate(parser, "N", "with -P, the number of terms to sample per path step in each iteration (default 10)", {'s', "path-sampling-rate"});
+    args::ValueFlag<uint64_t> path_seed(parser, "N", "with -P, seed for the random number generators (default: random)", {'S', "path-seed"});
+    args::ValueFlag<std::string> layout_out_file(parser, "FILE", "write the layout to this file, in a binary format that layout and viz can load", {'l', "layout-out"});
+    args::ValueFlag<std::string> layout_in_file(parser, "FILE", "start from the layout in this file, moving only the nodes around those without a position in it or on edges it stretches (see -r and -A)", {'L', "layout-in"});
+    args::ValueFlag<uint64_t> relayout_radius(parser, "N", "with -L, move the nodes within this many hops of the changes (default 10)", {'r', "relayout-radius"});
+    args::Flag relayout_all(parser, "relayout-all", "with -L, move all the nodes, taking the layout only as the starting point", {'A', "relayout-all"});
     args::Flag debug(parser, "debug", "print information about the layout", {'d', "debug"});
 
     try {
@@ -94,6 +64,7 @@ int main_layout(int argc, char** argv) {
     double eps = !args::get(eps_rate) ? 0.01 : args::get(eps_rate);
     double x_padding = !args::get(x_pad) ? 10.0 : args::get(x_pad);
     double svg_scale = !args::get(render_scale) ? 5.0 : args::get(render_scale);
+    uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
     
     graph_t graph;
     assert(argc > 0);
@@ -108,18 +79,94 @@ int main_layout(int argc, char** argv) {
         }
     }
 
-    std::vector<double> layout = algorithms::sgd_layout(graph, n_pivots, t_max, eps, x_padding);
+    // the layouts are indexed by id, so we lay out a graph with gaps in its ids, as deleting nodes leaves,
+    // with its ids compacted in their order, and keep the layout files keyed by the original ids
+    std::vector<nid_t> original_ids;
+    if (graph.get_node_count() && (graph.min_node_id() != 1 || graph.max_node_id() != (nid_t)graph.get_node_count())) {
+        std::vector<handle_t> order;
+        graph.for_each_handle([&](const handle_t& handle) { order.push_back(handle); });
+        std::sort(order.begin(), order.end(), [&](const handle_t& a, const handle_t& b) {
+                return graph.get_id(a) < graph.get_id(b);
+            });
+        for (auto& handle : order) {
+            original_ids.push_back(graph.get_id(handle));
+        }
+        graph.apply_ordering(order, true);
+    }
+
+    algorithms::layout_t start;
+    std::string start_file = args::get(layout_in_file);
+    if (start_file.size()) {
+        if (args::get(path_guided)) {
+            std::cerr << "[odgi layout] error: a path guided layout can't start from a layout file" << std::endl;
+            return 1;
+        }
+        if (start_file == "-") {
+            start.load(std::cin);
+        } else {
+            ifstream f(start_file.c_str(), std::ios::binary);
+            if (!f) {
+                std::cerr << "[odgi layout] error: could not open " << start_file << std::endl;
+                return 1;
+            }
+            start.load(f);
+            f.close();
+        }
+        if (!original_ids.empty()) {
+            start = start.compacted(original_ids);
+        }
+    }
+
+    std::vector<double> layout;
+    if (args::get(path_guided)) {
+        uint64_t bandwidth = args::get(path_bandwidth);
+        double sampling_rate = args::get(path_sampling_rate) ? args::get(path_sampling_rate) : 10;
+        uint64_t seed = path_seed ? args::get(path_seed) : std::random_device()();
+        xp::XP path_index;
+        path_index.from_handle_graph(graph);
+        layout = algorithms::path_sgd_2d_layout(graph, path_index, bandwidth, sampling_rate, t_max, eps, num_threads, seed);
+    } else {
+        uint64_t radius = std::numeric_limits<uint64_t>::max();
+        if (!args::get(relayout_all)) {
+            radius = relayout_radius ? args::get(relayout_radius) : 10;
+        }
+        layout = algorithms::sgd_layout(graph, n_pivots, t_max, eps, x_padding, num_threads,
+                                        start_file.size() ? &start : nullptr, radius);
+    }
+
+    std::string layout_outfile = args::get(layout_out_file);
+    if (layout_outfile.size()) {
+        algorithms::layout_t result(graph, layout);
+        if (!original_ids.empty()) {
+            result = result.expanded(original_ids);
+        }
+        if (layout_outfile == "-") {
+            result.serialize(std::cout);
+        } else {
+            ofstream f(layout_outfile.c_str(), std::ios::binary);
+            result.serialize(f);
+            f.close();
+        }
+    }
 
     std::string outfile = args::get(svg_out_file);
     if (outfile.size()) {
         if (outfile == "-") {
-            draw_svg(std::cout, layout, graph, svg_scale);
+            algorithms::draw_svg(std::cout, layout, graph, svg_scale);
         } else {
             ofstream f(outfile.c_str());
-            draw_svg(f, layout, graph, svg_scale);
+            algorithms::draw_svg(f, layout, graph, svg_scale);
             f.close();
         }
     }
+
+    std::string tiles_dir = args::get(tiles_out_dir);
+    if (tiles_dir.size()) {
+        algorithms::draw_png_tiles(tiles_dir, layout, graph,
+                                   args::get(tile_levels) ? args::get(tile_levels) : 6,
+                                   args::get(tile_pixels) ? args::get(tile_pixels) : 256,
+                                   num_threads);
+    }
     return 0;
 }
 
@@ -11,6 +11,12 @@
 #include "algorithms/random_order.hpp"
 #include "algorithms/mondriaan_sort.hpp"
 #include "algorithms/linear_sgd.hpp"
+#include "algorithms/multilevel_sgd.hpp"
+#include "algorithms/pipeline_sort.hpp"
+#include "algorithms/sort_metrics.hpp"
+#include "algorithms/path_locality_sort.hpp"
+#include <chrono>
+#include <sstream>
 
 namespace odgi {
 
@@ -32,7 +38,7 @@ int main_sort(int argc, char** argv) {
     args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the graph from this file", {'i', "idx"});
     //args::Flag show_sort(parser, "show", "write the sort order mapping", {'S', "show"});
     args::ValueFlag<std::string> sort_order_in(parser, "FILE", "load the sort order from this file", {'s', "sort-order"});
-    args::Flag cycle_breaking(parser, "cycle_breaking", "use a cycle breaking sort", {'c', "cycle-breaking"});
+    args::Flag cycle_breaking(parser, "cycle_breaking", "use a cycle breaking sort (with more than one thread, strongly connected components are broken in parallel)", {'c', "cycle-breaking"});
     args::Flag breadth_first(parser, "breadth_first", "use a breadth first topological sort", {'b', "breadth-first"});
     args::Flag depth_first(parser, "depth_first", "use a chunked depth first topological sort", {'z', "depth-first"});
     args::ValueFlag<uint64_t> breadth_first_chunk(parser, "N", "chunk size for breadth first topological sort", {'B', "breadth-first-chunk"});
@@ -41,20 +47,31 @@ int main_sort(int argc, char** argv) {
     args::Flag eades(parser, "eades", "use eades algorithm", {'e', "eades"});
     //args::Flag lazy(parser, "lazy", "use lazy topological algorithm (DAG only)", {'l', "lazy"});
     args::Flag lsgd(parser, "linear-sgd", "apply 1D (linear) SGD algorithm to organize graph", {'S', "linear-sgd"});
+    args::Flag multilevel_lsgd(parser, "multilevel-sgd", "apply 1D SGD in a multilevel scheme, solving a coarsened graph and refining its layout back to the full graph (uses the linear SGD settings)", {'U', "multilevel-sgd"});
     args::ValueFlag<uint64_t> lsgd_bandwidth(parser, "sgd-bandwidth", "bandwidth of linear SGD model (default: 1000)", {'O', "sgd-bandwidth"});
     args::ValueFlag<double> lsgd_sampling_rate(parser, "sgd-sampling-rate", "sample pairs of nodes with probability distance between them divided by the sampling rate (default: 20)", {'Q', "sgd-sampling-rate"});
     args::Flag lsgd_use_paths(parser, "sgd-use-paths", "use paths to structure internode distances in SGD", {'K', "sgd-use-paths"});
+    args::Flag lsgd_path_sampling(parser, "sgd-path-sampling", "sample SGD terms from the paths as we go, taking their distances from a path index, rather than precomputing them (the sampling rate becomes the number of terms sampled per path step in each iteration)", {'G', "sgd-path-sampling"});
     args::ValueFlag<uint64_t> lsgd_iter_max(parser, "sgd-iter-max", "max number of iterations for linear SGD model (default: 30)", {'T', "sgd-iter-max"});
     args::ValueFlag<double> lsgd_eps(parser, "sgd-eps", "final learning rate for linear SGD model (default: 0.01)", {'V', "sgd-eps"});
     args::ValueFlag<double> lsgd_delta(parser, "sgd-delta", "threshold of maximum node displacement (approximately in bp) at which to stop SGD (default: 0)", {'C', "sgd-delta"});
+    args::ValueFlag<uint64_t> lsgd_seed(parser, "N", "seed for the random number generators of linear SGD (default: random)", {'X', "sgd-seed"});
+    args::Flag lsgd_deterministic(parser, "sgd-deterministic", "use a fixed schedule for multithreaded linear SGD, so that a given seed and thread count always give the same order", {'J', "sgd-deterministic"});
+    args::Flag lsgd_batched(parser, "sgd-batched", "compute linear SGD updates in batches, using vector instructions where the CPU supports them", {'Y', "sgd-batched"});
     args::Flag two(parser, "two", "use two-way (max of head-first and tail-first) topological algorithm", {'w', "two-way"});
     args::Flag randomize(parser, "random", "randomly sort the graph", {'r', "random"});
+    args::Flag path_locality(parser, "path-locality", "refine the current order so that consecutive steps of the paths land on nearby nodes", {'l', "path-locality"});
     args::Flag no_seeds(parser, "no-seeds", "don't use heads or tails to seed topological sort", {'n', "no-seeds"});
+    args::Flag frontier_topo(parser, "frontier-topo", "run the topological sorts (the default sort, -n, and 's' and 'n' in pipelines) frontier by frontier, processing each frontier in parallel; this gives a different order from the default sort, but the same one for any number of threads", {'F', "frontier-topo"});
     args::Flag mondriaan(parser, "mondriaan", "use sparse matrix diagonalization to sort the graph", {'m', "mondriaan"});
     args::ValueFlag<uint64_t> mondriaan_n_parts(parser, "N", "number of partitions for mondriaan", {'N', "mondriaan-n-parts"});
     args::ValueFlag<double> mondriaan_epsilon(parser, "N", "epsilon parameter to mondriaan", {'E', "mondriaan-epsilon"});
     args::Flag mondriaan_path_weight(parser, "path-weight", "weight mondriaan input matrix by path coverage of edges", {'W', "mondriaan-path-weight"});
     args::ValueFlag<std::string> pipeline(parser, "STRING", "apply a series of sorts, based on single-character command line arguments to this command, with 's' the default sort and 'f' to reverse the sort order", {'p', "pipeline"});
+    args::ValueFlag<std::string> report(parser, "FILE", "write measures of the sort quality after each stage of the sort to this file as JSON (- for stderr)", {"report"});
+    args::Flag auto_sort(parser, "auto", "try a set of candidate pipelines and keep the one whose order gives the fewest jumps when walking the paths (or the lowest mean edge id delta in a graph without paths)", {"auto"});
+    args::ValueFlag<std::string> auto_candidates(parser, "LIST", "comma-separated pipelines to try with --auto (default: s,w,b,z,S,U,sl)", {"auto-candidates"});
+    args::ValueFlag<double> auto_budget(parser, "SECONDS", "with --auto, don't start another candidate after this many seconds (default: 300)", {"auto-budget"});
     args::Flag paths_by_min_node_id(parser, "paths-min", "sort paths by their lowest contained node id", {'L', "paths-min"});
     args::Flag paths_by_max_node_id(parser, "paths-max", "sort paths by their highest contained node id", {'M', "paths-max"});
     args::Flag paths_by_avg_node_id(parser, "paths-avg", "sort paths by their average contained node id", {'A', "paths-avg"});
@@ -62,7 +79,7 @@ int main_sort(int argc, char** argv) {
     args::ValueFlag<std::string> path_delim(parser, "path-delim", "sort paths in bins by their prefix up to this delemiter", {'D', "path-delim"});
     args::Flag progress(parser, "progress", "display progress of the sort", {'P', "progress"});
     args::Flag optimize(parser, "optimize", "use the MutableHandleGraph::optimize method", {'O', "optimize"});
-    args::ValueFlag<uint64_t> nthreads(parser, "N", "number of threads to use for parallel sorters (currently only SGD is supported)", {'t', "threads"});
+    args::ValueFlag<uint64_t> nthreads(parser, "N", "number of threads to use for parallel sorters (SGD, and the topological sorts with -F)", {'t', "threads"});
     try {
         parser.ParseCLI(argc, argv);
     } catch (args::Help) {
@@ -109,12 +126,88 @@ int main_sort(int argc, char** argv) {
     double sgd_delta = args::get(lsgd_delta) ? args::get(lsgd_delta) : 0;
     uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
     bool sgd_use_paths = args::get(lsgd_use_paths);
+    // a seed of 0 is as valid as any other, so only draw one when none was given
+    uint64_t sgd_seed = lsgd_seed ? args::get(lsgd_seed) : std::random_device()();
+    bool sgd_deterministic = args::get(lsgd_deterministic);
+    bool sgd_batched = args::get(lsgd_batched);
 
     // helper, TODO: move into its own file
     // make a dagified copy, get its sort, and apply the order to our graph
 
+    algorithms::pipeline_sort_params_t params;
+    params.progress = args::get(progress);
+    params.bf_chunk_size = bf_chunk_size;
+    params.df_chunk_size = df_chunk_size;
+    params.sgd_bandwidth = sgd_bandwidth;
+    params.sgd_sampling_rate = sgd_sampling_rate;
+    params.sgd_use_paths = sgd_use_paths;
+    params.sgd_path_sampling = args::get(lsgd_path_sampling);
+    params.sgd_iter_max = sgd_iter_max;
+    params.sgd_eps = sgd_eps;
+    params.sgd_delta = sgd_delta;
+    params.sgd_seed = sgd_seed;
+    params.sgd_deterministic = sgd_deterministic;
+    params.sgd_batched = sgd_batched;
+    params.num_threads = num_threads;
+    params.frontier_topological = args::get(frontier_topo);
+    params.mondriaan_n_parts = args::get(mondriaan_n_parts);
+    params.mondriaan_epsilon = args::get(mondriaan_epsilon);
+    params.mondriaan_path_weight = args::get(mondriaan_path_weight);
+
+    std::vector<std::string> candidates;
+    if (args::get(auto_sort)) {
+        std::stringstream list(args::get(auto_candidates).empty() ? "s,w,b,z,S,U,sl" : args::get(auto_candidates));
+        std::string candidate;
+        while (std::getline(list, candidate, ',')) {
+            for (auto c : candidate) {
+                if (!algorithms::is_pipeline_sort(c)) {
+                    std::cerr << "[odgi sort] error: unknown sort '" << c << "' in --auto-candidates" << std::endl;
+                    exit(1);
+                }
+            }
+            if (!candidate.empty()) {
+                candidates.push_back(candidate);
+            }
+        }
+        if (candidates.empty()) {
+            std::cerr << "[odgi sort] error: --auto needs at least one candidate pipeline" << std::endl;
+            exit(1);
+        }
+    }
+    double budget = 300;
+    if (auto_budget) {
+        budget = args::get(auto_budget);
+        if (!(budget > 0)) {
+            std::cerr << "[odgi sort] error: --auto-budget must be a positive number of seconds" << std::endl;
+            exit(1);
+        }
+    }
+
+    // the stages of the report, as JSON objects
+    std::vector<std::string> report_stages;
+    std::vector<std::string> report_candidates;
+    auto seconds_since = [](const std::chrono::steady_clock::time_point& start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto stage_json = [&](const std::string& name, const std::string& key, const PathHandleGraph& g, double seconds) {
+        std::stringstream json;
+        json << "{\"" << key << "\": \"" << name << "\", \"seconds\": " << seconds << ", \"metrics\": ";
+        algorithms::write_sort_metrics_json(json, algorithms::sort_metrics(g, num_threads));
+        json << "}";
+        return json.str();
+    };
+    auto report_stage = [&](const std::string& name, double seconds) {
+        if (!args::get(report).empty()) {
+            report_stages.push_back(stage_json(name, "stage", graph, seconds));
+        }
+    };
+
     std::string outfile = args::get(dg_out_file);
     if (outfile.size()) {
+        report_stage("input", 0);
+        auto sort_start = std::chrono::steady_clock::now();
+        // the pipelines report each of their stages
+        bool reported_stages = false;
         if (args::get(eades)) {
             graph.apply_ordering(algorithms::eades_algorithm(&graph), true);
         } else if (args::get(two)) {
@@ -130,10 +223,11 @@ int main_sort(int argc, char** argv) {
             }
             graph.apply_ordering(given_order, true);
         } else if (args::get(dagify)) {
-            graph_t split, into;
-            graph.apply_ordering(algorithms::dagify_sort(graph, split, into), true);
+            graph.apply_ordering(algorithms::dagify_sort(graph), true);
         } else if (args::get(cycle_breaking)) {
-            graph.apply_ordering(algorithms::cycle_breaking_sort(graph), true);
+            graph.apply_ordering(algorithms::cycle_breaking_sort(graph, num_threads), true);
+        } else if (args::get(no_seeds) && args::get(frontier_topo)) {
+            graph.apply_ordering(algorithms::parallel_topological_order(&graph, false, false, args::get(progress), num_threads), true);
         } else if (args::get(no_seeds)) {
             graph.apply_ordering(algorithms::topological_order(&graph, false, false, args::get(progress)), true);
         } else if (args::get(mondriaan)) {
@@ -141,6 +235,29 @@ int main_sort(int argc, char** argv) {
                                                             args::get(mondriaan_n_parts),
                                                             args::get(mondriaan_epsilon),
                                                             args::get(mondriaan_path_weight), false), true);
+        } else if (args::get(lsgd) && args::get(lsgd_path_sampling)) {
+            graph.apply_ordering(algorithms::path_linear_sgd_order(graph,
+                                                                   sgd_bandwidth,
+                                                                   sgd_sampling_rate,
+                                                                   sgd_iter_max,
+                                                                   sgd_eps,
+                                                                   sgd_delta,
+                                                                   num_threads,
+                                                                   sgd_seed,
+                                                                   sgd_deterministic,
+                                                                   sgd_batched));
+        } else if (args::get(multilevel_lsgd)) {
+            graph.apply_ordering(algorithms::multilevel_linear_sgd_order(graph,
+                                                                         sgd_bandwidth,
+                                                                         sgd_sampling_rate,
+                                                                         sgd_use_paths,
+                                                                         sgd_iter_max,
+                                                                         sgd_eps,
+                                                                         sgd_delta,
+                                                                         num_threads,
+                                                                         sgd_seed,
+                                                                         sgd_deterministic,
+                                                                         sgd_batched));
         } else if (args::get(lsgd)) {
             graph.apply_ordering(algorithms::linear_sgd_order(graph,
                                                               sgd_bandwidth,
@@ -149,84 +266,85 @@ int main_sort(int argc, char** argv) {
                                                               sgd_iter_max,
                                                               sgd_eps,
                                                               sgd_delta,
-                                                              num_threads));
+                                                              num_threads,
+                                                              sgd_seed,
+                                                              sgd_deterministic,
+                                                              sgd_batched));
         } else if (args::get(breadth_first)) {
-            graph.apply_ordering(algorithms::breadth_first_topological_order(graph, bf_chunk_size), true);
+            graph.apply_ordering(algorithms::breadth_first_topological_order(graph, bf_chunk_size, true, false, num_threads), true);
         } else if (args::get(depth_first)) {
             graph.apply_ordering(algorithms::depth_first_topological_order(graph, df_chunk_size), true);
         } else if (args::get(randomize)) {
             graph.apply_ordering(algorithms::random_order(graph), true);
-        } else if (!args::get(pipeline).empty()) {
-            // for each sort type, apply it to the graph
-            std::vector<handle_t> order;
-            for (auto c : args::get(pipeline)) {
-                switch (c) {
-                case 's':
-                    order = algorithms::topological_order(&graph, true, false, args::get(progress));
-                    break;
-                case 'n':
-                    order = algorithms::topological_order(&graph, false, false, args::get(progress));
-                    break;
-                case 'e':
-                    order = algorithms::eades_algorithm(&graph);
-                    break;
-                case 'd':
-                {
-                    graph_t split, into;
-                    order = algorithms::dagify_sort(graph, split, into);
+        } else if (args::get(path_locality)) {
+            graph.apply_ordering(algorithms::path_locality_order(graph, params.path_locality_iter_max, num_threads, args::get(progress)), true);
+        } else if (args::get(auto_sort)) {
+            // order the graph with each candidate until we run out of time, and keep the best
+            std::vector<handle_t> best_order;
+            std::string best_pipeline;
+            std::pair<uint64_t, double> best_score;
+            for (auto& candidate : candidates) {
+                if (!best_pipeline.empty() && seconds_since(sort_start) > budget) {
+                    if (args::get(progress)) {
+                        std::cerr << "[odgi sort] auto: out of time, skipping " << candidate << std::endl;
+                    }
+                    continue;
+                }
+                auto start = std::chrono::steady_clock::now();
+                double seconds = 0;
+                algorithms::sort_metrics_t metrics;
+                std::string candidate_json;
+                std::vector<handle_t> order = algorithms::pipeline_sort_order(
+                    graph, candidate, params,
+                    [&](const PathHandleGraph& sorted, uint64_t stage) {
+                        if (stage + 1 < candidate.size()) return;
+                        seconds = seconds_since(start);
+                        metrics = algorithms::sort_metrics(sorted, num_threads);
+                        if (!args::get(report).empty()) {
+                            candidate_json = stage_json(candidate, "pipeline", sorted, seconds);
+                        }
+                    });
+                std::pair<uint64_t, double> score = std::make_pair(metrics.path_jumps, metrics.mean_edge_delta);
+                if (args::get(progress)) {
+                    std::cerr << "[odgi sort] auto: " << candidate << " took " << seconds << "s, "
+                              << metrics.path_jumps << " path jumps, mean edge delta " << metrics.mean_edge_delta << std::endl;
                 }
-                    break;
-                case 'c':
-                    order = algorithms::cycle_breaking_sort(graph);
-                    break;
-                case 'b':
-                    order = algorithms::breadth_first_topological_order(graph, bf_chunk_size);
-                    break;
-                case 'z':
-                    order = algorithms::depth_first_topological_order(graph, df_chunk_size);
-                    break;
-                case 'w':
-                    order = algorithms::two_way_topological_order(&graph);
-                    break;
-                case 'r':
-                    order = algorithms::random_order(graph);
-                    break;
-                case 'S':
-                    order = algorithms::linear_sgd_order(graph,
-                                                         sgd_bandwidth,
-                                                         sgd_sampling_rate,
-                                                         sgd_use_paths,
-                                                         sgd_iter_max,
-                                                         sgd_eps,
-                                                         sgd_delta,
-                                                         num_threads);
-                    break;
-                case 'f':
-                    order.clear();
-                    graph.for_each_handle([&order](const handle_t& handle) {
-                            order.push_back(handle);
-                        });
-                    std::reverse(order.begin(), order.end());
-                    break;
-                case 'm':
-                    order = algorithms::mondriaan_sort(graph,
-                                                       args::get(mondriaan_n_parts),
-                                                       args::get(mondriaan_epsilon),
-                                                       args::get(mondriaan_path_weight), false);
-                    break;
-                default:
-                    break;
+                if (!args::get(report).empty()) {
+                    report_candidates.push_back(candidate_json);
                 }
-                if (order.size() != graph.get_node_count()) {
-                    std::cerr << "[odgi sort] Error: expected " << graph.get_node_count() << " handles in the order "
-                              << "but got " << order.size() << std::endl;
-                    assert(false);
+                if (best_pipeline.empty() || score < best_score) {
+                    best_score = score;
+                    best_pipeline = candidate;
+                    best_order.swap(order);
                 }
-                graph.apply_ordering(order, true);
             }
+            graph.apply_ordering(best_order, true);
+            if (args::get(progress)) {
+                std::cerr << "[odgi sort] auto: chose " << best_pipeline << std::endl;
+            }
+            report_stage("auto:" + best_pipeline, seconds_since(sort_start));
+            reported_stages = true;
+        } else if (!args::get(pipeline).empty()) {
+            // the stages compose their orders, so we only rebuild the graph once
+            std::string stages = args::get(pipeline);
+            auto start = std::chrono::steady_clock::now();
+            std::function<void(const PathHandleGraph&, uint64_t)> after_stage;
+            if (!args::get(report).empty()) {
+                after_stage = [&](const PathHandleGraph& sorted, uint64_t stage) {
+                    report_stages.push_back(stage_json(std::string(1, stages[stage]), "stage", sorted, seconds_since(start)));
+                    start = std::chrono::steady_clock::now();
+                };
+            }
+            graph.apply_ordering(algorithms::pipeline_sort_order(graph, stages, params, after_stage), true);
+            reported_stages = true;
+        } else if (args::get(frontier_topo)) {
+            graph.apply_ordering(algorithms::parallel_topological_order(&graph, true, false, args::get(progress), num_threads), true);
         } else {
             graph.apply_ordering(algorithms::topological_order(&graph, true, false, args::get(progress)), true);
         }
+        if (!reported_stages) {
+            report_stage("sort", seconds_since(sort_start));
+        }
         if (args::get(paths_by_min_node_id)) {
             graph.apply_path_ordering(algorithms::prefix_and_id_ordered_paths(graph, args::get(path_delim), false, false));
         }
@@ -239,6 +357,29 @@ int main_sort(int argc, char** argv) {
         if (args::get(paths_by_avg_node_id_rev)) {
             graph.apply_path_ordering(algorithms::prefix_and_id_ordered_paths(graph, args::get(path_delim), true, true));
         }
+        if (!args::get(report).empty()) {
+            std::stringstream json;
+            json << "{\"stages\": [";
+            for (uint64_t i = 0; i < report_stages.size(); ++i) {
+                json << (i ? ", " : "") << report_stages[i];
+            }
+            json << "]";
+            if (args::get(auto_sort)) {
+                json << ", \"auto\": {\"budget\": " << budget << ", \"candidates\": [";
+                for (uint64_t i = 0; i < report_candidates.size(); ++i) {
+                    json << (i ? ", " : "") << report_candidates[i];
+                }
+                json << "]}";
+            }
+            json << "}" << std::endl;
+            if (args::get(report) == "-") {
+                std::cerr << json.str();
+            } else {
+                ofstream f(args::get(report).c_str());
+                f << json.str();
+                f.close();
+            }
+        }
         if (outfile == "-") {
             graph.serialize(std::cout);
         } else {
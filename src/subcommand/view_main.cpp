@@ -23,6 +23,7 @@ int main_view(int argc, char** argv) {
     args::ValueFlag<std::string> dg_in_file(parser, "FILE", "load the index from this file", {'i', "idx"});
     args::Flag to_gfa(parser, "to_gfa", "write the graph to stdout in GFA format", {'g', "to-gfa"});
     args::Flag display(parser, "display", "show internal structures", {'d', "display"});
+    args::ValueFlag<uint64_t> threads(parser, "N", "number of threads to use for writing GFA", {'t', "threads"});
 
     try {
         parser.ParseCLI(argc, argv);
@@ -55,7 +56,7 @@ int main_view(int argc, char** argv) {
         graph.display();
     }
     if (args::get(to_gfa)) {
-        graph.to_gfa(std::cout);
+        graph.to_gfa(std::cout, args::get(threads) ? args::get(threads) : 1);
     }
 
     return 0;
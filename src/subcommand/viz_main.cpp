@@ -4,6 +4,7 @@
 #include "threads.hpp"
 #include "algorithms/hash.hpp"
 #include "algorithms/id_ordered_paths.hpp"
+#include "algorithms/layout.hpp"
 #include "lodepng.h"
 #include <limits>
 #include "picosha2.h"
@@ -63,6 +64,55 @@ void encodeWithState(const char* filename, std::vector<unsigned char>& image, un
 
 using namespace odgi::subcommand;
 
+// draw the edges of the graph as lines between the nodes of a 2D layout, scaled to fit the image
+void draw_layout_png(const char* filename, const HandleGraph& graph, const algorithms::layout_t& layout,
+                     uint64_t width, uint64_t height) {
+    double min_x = std::numeric_limits<double>::max();
+    double min_y = std::numeric_limits<double>::max();
+    double max_x = std::numeric_limits<double>::lowest();
+    double max_y = std::numeric_limits<double>::lowest();
+    graph.for_each_handle([&](const handle_t& h) {
+            nid_t id = graph.get_id(h);
+            if (!layout.has(id)) return;
+            min_x = std::min(min_x, layout.x(id));
+            min_y = std::min(min_y, layout.y(id));
+            max_x = std::max(max_x, layout.x(id));
+            max_y = std::max(max_y, layout.y(id));
+        });
+    std::vector<uint8_t> image(width * height * 4, 255);
+    if (min_x <= max_x) {
+        // keep the aspect ratio of the layout
+        double scale = std::min((width - 1) / std::max(max_x - min_x, 1e-9),
+                                (height - 1) / std::max(max_y - min_y, 1e-9));
+        auto add_point = [&](const double& _x, const double& _y) {
+            uint64_t x = std::min((uint64_t)std::round((_x - min_x) * scale), width-1);
+            uint64_t y = std::min((uint64_t)std::round((_y - min_y) * scale), height-1);
+            image[4 * width * y + 4 * x + 0] = 0;
+            image[4 * width * y + 4 * x + 1] = 0;
+            image[4 * width * y + 4 * x + 2] = 0;
+            image[4 * width * y + 4 * x + 3] = 255;
+        };
+        graph.for_each_edge([&](const edge_t& e) {
+                nid_t a = graph.get_id(e.first);
+                nid_t b = graph.get_id(e.second);
+                if (!layout.has(a) || !layout.has(b)) return;
+                // one point per pixel along the longer axis
+                double dx = layout.x(b) - layout.x(a);
+                double dy = layout.y(b) - layout.y(a);
+                uint64_t steps = std::ceil(std::max(std::abs(dx), std::abs(dy)) * scale);
+                for (uint64_t i = 0; i <= steps; ++i) {
+                    double f = steps ? (double)i / steps : 0;
+                    add_point(layout.x(a) + f * dx, layout.y(a) + f * dy);
+                }
+            });
+        graph.for_each_handle([&](const handle_t& h) {
+                nid_t id = graph.get_id(h);
+                if (layout.has(id)) add_point(layout.x(id), layout.y(id));
+            });
+    }
+    png::encodeOneStep(filename, image, width, height);
+}
+
 int main_viz(int argc, char** argv) {
 
     // trick argumentparser to do the right thing with the subcommand
@@ -85,6 +135,7 @@ int main_viz(int argc, char** argv) {
     args::ValueFlag<float> link_path_pieces(parser, "FLOAT", "show thin links of this relative width to connect path pieces", {'L', "link-path-pieces"});
     args::ValueFlag<std::string> alignment_prefix(parser, "STRING", "apply alignment-related visual motifs to paths with this name prefix", {'A', "alignment-prefix"});
     args::Flag show_strands(parser, "bool", "use reds and blues to show forward and reverse alignments (depends on -A)", {'S', "show-strand"});
+    args::ValueFlag<std::string> layout_in_file(parser, "FILE", "draw the graph in 2D following the layout in this file, as written by odgi layout", {'l', "layout"});
     args::ValueFlag<uint64_t> threads(parser, "N", "number of threads to use", {'t', "threads"});
 
     try {
@@ -129,6 +180,21 @@ int main_viz(int argc, char** argv) {
     }
     const char* filename = args::get(png_out_file).c_str();
 
+    if (!args::get(layout_in_file).empty()) {
+        algorithms::layout_t layout;
+        ifstream f(args::get(layout_in_file).c_str(), std::ios::binary);
+        if (!f) {
+            std::cerr << "[odgi viz] error: could not open " << args::get(layout_in_file) << std::endl;
+            return 1;
+        }
+        layout.load(f);
+        f.close();
+        draw_layout_png(filename, graph, layout,
+                        args::get(image_width) ? args::get(image_width) : 1000,
+                        args::get(image_height) ? args::get(image_height) : 1000);
+        return 0;
+    }
+
     // TODO this breaks for graphs that aren't compacted
     std::vector<uint64_t> position_map(graph.get_node_count()+1);
     std::vector<std::pair<uint64_t, uint64_t>> contacts;
@@ -0,0 +1,463 @@
+/**
+ * \file topology_graph.cpp: contains the implementation of topology_graph_t
+ */
+
+#include "topology_graph.hpp"
+#include "dna.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace odgi {
+
+void topology_graph_t::add_node(const nid_t& id, const char* seq, uint64_t len) {
+    ids.push_back(id);
+    seqs.push_back(seq);
+    lengths.push_back(len);
+}
+
+void topology_graph_t::add_edge(const nid_t& from, bool from_rev, const nid_t& to, bool to_rev) {
+    pending_edges.emplace_back((uint64_t)from << 1 | from_rev, (uint64_t)to << 1 | to_rev);
+}
+
+path_handle_t topology_graph_t::add_path(const std::string& name, bool is_circular) {
+    path_names.push_back(name);
+    path_circular.push_back(is_circular);
+    path_steps.emplace_back();
+    return as_path_handle(path_names.size() - 1);
+}
+
+void topology_graph_t::set_circularity(const path_handle_t& path, bool circular) {
+    path_circular[as_integer(path)] = circular;
+}
+
+void topology_graph_t::append_step(const path_handle_t& path, const nid_t& id, bool is_rev) {
+    path_steps[as_integer(path)].push_back((uint64_t)id << 1 | is_rev);
+}
+
+void topology_graph_t::index(void) {
+    // order the nodes by id, as graph_t stores them
+    std::vector<uint64_t> by_id(ids.size());
+    for (uint64_t i = 0; i < by_id.size(); ++i) by_id[i] = i;
+    std::sort(by_id.begin(), by_id.end(), [&](const uint64_t& a, const uint64_t& b) {
+            return ids[a] < ids[b];
+        });
+    std::vector<nid_t> sorted_ids(ids.size());
+    std::vector<const char*> sorted_seqs(ids.size());
+    std::vector<uint64_t> sorted_lengths(ids.size());
+    for (uint64_t i = 0; i < by_id.size(); ++i) {
+        sorted_ids[i] = ids[by_id[i]];
+        sorted_seqs[i] = seqs[by_id[i]];
+        sorted_lengths[i] = lengths[by_id[i]];
+    }
+    ids.swap(sorted_ids);
+    seqs.swap(sorted_seqs);
+    lengths.swap(sorted_lengths);
+    id_to_rank.clear();
+    if (!ids.empty()) {
+        min_id = ids.front();
+        max_id = ids.back();
+        id_to_rank.resize(max_id - min_id + 1, (uint64_t)-1);
+        for (uint64_t i = 0; i < ids.size(); ++i) {
+            if (id_to_rank[ids[i] - min_id] != (uint64_t)-1) {
+                std::cerr << "[odgi::topology_graph_t] error: duplicate node id " << ids[i] << std::endl;
+                exit(1);
+            }
+            id_to_rank[ids[i] - min_id] = i;
+        }
+    }
+    auto to_handle = [&](const uint64_t& packed_id) {
+        uint64_t rank = rank_of(packed_id >> 1);
+        if (rank == (uint64_t)-1) {
+            std::cerr << "[odgi::topology_graph_t] error: no node with id " << (packed_id >> 1) << std::endl;
+            exit(1);
+        }
+        return as_integer(number_bool_packing::pack(rank, packed_id & 1));
+    };
+    for (auto& edge : pending_edges) {
+        edge.first = to_handle(edge.first);
+        edge.second = to_handle(edge.second);
+    }
+    index_edges(pending_edges);
+    std::vector<std::pair<uint64_t, uint64_t>>().swap(pending_edges);
+    for (auto& steps : path_steps) {
+        for (auto& s : steps) {
+            s = to_handle(s);
+        }
+    }
+    steps_indexed.reset(new std::once_flag);
+}
+
+void topology_graph_t::index_edges(const std::vector<std::pair<uint64_t, uint64_t>>& edges) {
+    uint64_t n_handles = ids.size() * 2;
+    std::vector<uint64_t> offsets(n_handles + 1, 0);
+    for (auto& e : edges) {
+        ++offsets[e.first + 1];
+        ++offsets[(e.second ^ 1) + 1];
+    }
+    for (uint64_t i = 0; i < n_handles; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    // each side of a node lists its edges in the order they were added, as graph_t's edge lists do
+    std::vector<handle_t> targets(offsets.back());
+    std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+    for (auto& e : edges) {
+        targets[fill[e.first]++] = as_handle(e.second);
+        targets[fill[e.second ^ 1]++] = as_handle(e.first ^ 1);
+    }
+    // drop repeated edges, keeping the first copy as graph_t::create_edge does, and compact the lists
+    std::vector<uint64_t> last_list(n_handles, (uint64_t)-1);
+    uint64_t j = 0;
+    for (uint64_t i = 0; i < n_handles; ++i) {
+        uint64_t begin = offsets[i];
+        uint64_t end = offsets[i + 1];
+        offsets[i] = j;
+        for (uint64_t k = begin; k < end; ++k) {
+            uint64_t t = as_integer(targets[k]);
+            if (last_list[t] == i) continue;
+            last_list[t] = i;
+            targets[j++] = targets[k];
+        }
+    }
+    offsets[n_handles] = j;
+    targets.resize(j);
+    targets.shrink_to_fit();
+    edge_offsets.swap(offsets);
+    edge_targets.swap(targets);
+}
+
+void topology_graph_t::apply_ordering(const std::vector<handle_t>& order) {
+    uint64_t n = ids.size();
+    if (order.size() != n) {
+        std::cerr << "[odgi::topology_graph_t] error: expected " << n << " handles in the order "
+                  << "but got " << order.size() << std::endl;
+        exit(1);
+    }
+    std::vector<uint64_t> new_rank(n);
+    std::vector<const char*> ordered_seqs(n);
+    std::vector<uint64_t> ordered_lengths(n);
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t rank = get_rank(order[i]);
+        new_rank[rank] = i;
+        ordered_seqs[i] = seqs[rank];
+        ordered_lengths[i] = lengths[rank];
+    }
+    auto remap = [&](const uint64_t& h) {
+        return new_rank[h >> 1] << 1 | (h & 1);
+    };
+    // add the edges again as graph_t::apply_ordering does, from the right and then the left side of
+    // each node in the new order, so that each side lists its edges in the order graph_t would
+    std::vector<std::pair<uint64_t, uint64_t>> edges;
+    edges.reserve(edge_targets.size());
+    for (auto& handle : order) {
+        uint64_t h = as_integer(handle);
+        for (uint64_t k = edge_offsets[h]; k < edge_offsets[h + 1]; ++k) {
+            edges.emplace_back(remap(h), remap(as_integer(edge_targets[k])));
+        }
+        // the left side of the handle is the right side of its reverse
+        for (uint64_t k = edge_offsets[h ^ 1]; k < edge_offsets[(h ^ 1) + 1]; ++k) {
+            edges.emplace_back(remap(as_integer(edge_targets[k]) ^ 1), remap(h));
+        }
+    }
+    seqs.swap(ordered_seqs);
+    lengths.swap(ordered_lengths);
+    for (uint64_t i = 0; i < n; ++i) {
+        ids[i] = i + 1;
+    }
+    min_id = n ? 1 : 0;
+    max_id = n;
+    id_to_rank.resize(n);
+    for (uint64_t i = 0; i < n; ++i) {
+        id_to_rank[i] = i;
+    }
+    index_edges(edges);
+    for (auto& steps : path_steps) {
+        for (auto& s : steps) {
+            s = remap(s);
+        }
+    }
+    step_offsets.clear();
+    node_steps.clear();
+    steps_indexed.reset(new std::once_flag);
+}
+
+void topology_graph_t::index_steps(void) const {
+    std::call_once(*steps_indexed, [this](void) {
+            std::vector<uint64_t> offsets(ids.size() + 1, 0);
+            for (auto& steps : path_steps) {
+                for (auto& s : steps) {
+                    ++offsets[(s >> 1) + 1];
+                }
+            }
+            for (uint64_t i = 0; i < ids.size(); ++i) {
+                offsets[i + 1] += offsets[i];
+            }
+            node_steps.resize(offsets.back());
+            std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+            for (uint64_t p = 0; p < path_steps.size(); ++p) {
+                auto& steps = path_steps[p];
+                for (uint64_t i = 0; i < steps.size(); ++i) {
+                    node_steps[fill[steps[i] >> 1]++] = std::make_pair(p, i);
+                }
+            }
+            step_offsets.swap(offsets);
+        });
+}
+
+bool topology_graph_t::has_node(nid_t node_id) const {
+    return rank_of(node_id) != (uint64_t)-1;
+}
+
+handle_t topology_graph_t::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(rank_of(node_id), is_reverse);
+}
+
+nid_t topology_graph_t::get_id(const handle_t& handle) const {
+    return ids[get_rank(handle)];
+}
+
+bool topology_graph_t::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t topology_graph_t::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t topology_graph_t::get_length(const handle_t& handle) const {
+    return lengths[get_rank(handle)];
+}
+
+std::string topology_graph_t::get_sequence(const handle_t& handle) const {
+    uint64_t rank = get_rank(handle);
+    if (seqs[rank] == nullptr) {
+        return std::string(lengths[rank], 'N');
+    }
+    std::string seq(seqs[rank], lengths[rank]);
+    return get_is_reverse(handle) ? reverse_complement(seq) : seq;
+}
+
+size_t topology_graph_t::get_degree(const handle_t& handle, bool go_left) const {
+    uint64_t h = as_integer(go_left ? flip(handle) : handle);
+    return edge_offsets[h + 1] - edge_offsets[h];
+}
+
+bool topology_graph_t::follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    // the left side of a handle is the right side of its reverse
+    uint64_t h = as_integer(go_left ? flip(handle) : handle);
+    for (uint64_t k = edge_offsets[h]; k < edge_offsets[h + 1]; ++k) {
+        if (!iteratee(go_left ? flip(edge_targets[k]) : edge_targets[k])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool topology_graph_t::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    if (parallel) {
+        volatile bool flag = true;
+#pragma omp parallel for
+        for (uint64_t i = 0; i < ids.size(); ++i) {
+            if (!flag) continue;
+            bool result = iteratee(number_bool_packing::pack(i, false));
+#pragma omp atomic
+            flag &= result;
+        }
+        return flag;
+    }
+    for (uint64_t i = 0; i < ids.size(); ++i) {
+        if (!iteratee(number_bool_packing::pack(i, false))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t topology_graph_t::get_node_count(void) const {
+    return ids.size();
+}
+
+nid_t topology_graph_t::min_node_id(void) const {
+    return min_id;
+}
+
+nid_t topology_graph_t::max_node_id(void) const {
+    return max_id;
+}
+
+size_t topology_graph_t::get_path_count(void) const {
+    return path_names.size();
+}
+
+bool topology_graph_t::has_path(const std::string& path_name) const {
+    return std::find(path_names.begin(), path_names.end(), path_name) != path_names.end();
+}
+
+path_handle_t topology_graph_t::get_path_handle(const std::string& path_name) const {
+    return as_path_handle(std::find(path_names.begin(), path_names.end(), path_name) - path_names.begin());
+}
+
+std::string topology_graph_t::get_path_name(const path_handle_t& path_handle) const {
+    return path_names[as_integer(path_handle)];
+}
+
+bool topology_graph_t::get_is_circular(const path_handle_t& path_handle) const {
+    return path_circular[as_integer(path_handle)];
+}
+
+size_t topology_graph_t::get_step_count(const path_handle_t& path_handle) const {
+    return path_steps[as_integer(path_handle)].size();
+}
+
+size_t topology_graph_t::get_step_count(const handle_t& handle) const {
+    index_steps();
+    uint64_t rank = get_rank(handle);
+    return step_offsets[rank + 1] - step_offsets[rank];
+}
+
+handle_t topology_graph_t::get_handle_of_step(const step_handle_t& step_handle) const {
+    return as_handle(path_steps[as_integers(step_handle)[0]][as_integers(step_handle)[1]]);
+}
+
+path_handle_t topology_graph_t::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return as_path_handle(as_integers(step_handle)[0]);
+}
+
+path_handle_t topology_graph_t::get_path(const step_handle_t& step_handle) const {
+    return get_path_handle_of_step(step_handle);
+}
+
+step_handle_t topology_graph_t::path_begin(const path_handle_t& path_handle) const {
+    step_handle_t step;
+    as_integers(step)[0] = as_integer(path_handle);
+    as_integers(step)[1] = 0;
+    return step;
+}
+
+step_handle_t topology_graph_t::path_end(const path_handle_t& path_handle) const {
+    step_handle_t step;
+    as_integers(step)[0] = as_integer(path_handle);
+    as_integers(step)[1] = std::numeric_limits<uint64_t>::max();
+    return step;
+}
+
+step_handle_t topology_graph_t::path_back(const path_handle_t& path_handle) const {
+    step_handle_t step;
+    as_integers(step)[0] = as_integer(path_handle);
+    as_integers(step)[1] = path_steps[as_integer(path_handle)].size() - 1;
+    return step;
+}
+
+step_handle_t topology_graph_t::path_front_end(const path_handle_t& path_handle) const {
+    step_handle_t step;
+    as_integers(step)[0] = as_integer(path_handle);
+    as_integers(step)[1] = std::numeric_limits<uint64_t>::max() - 1;
+    return step;
+}
+
+bool topology_graph_t::is_path_front_end(const step_handle_t& step_handle) const {
+    return as_integers(step_handle)[1] == std::numeric_limits<uint64_t>::max() - 1;
+}
+
+bool topology_graph_t::is_path_end(const step_handle_t& step_handle) const {
+    return as_integers(step_handle)[1] == std::numeric_limits<uint64_t>::max();
+}
+
+bool topology_graph_t::has_next_step(const step_handle_t& step_handle) const {
+    // circular paths wrap around, as they do in graph_t
+    uint64_t p = as_integers(step_handle)[0];
+    return path_circular[p] || as_integers(step_handle)[1] + 1 < path_steps[p].size();
+}
+
+bool topology_graph_t::has_previous_step(const step_handle_t& step_handle) const {
+    uint64_t p = as_integers(step_handle)[0];
+    return path_circular[p] || as_integers(step_handle)[1] > 0;
+}
+
+step_handle_t topology_graph_t::get_next_step(const step_handle_t& step_handle) const {
+    if (is_path_end(step_handle)) {
+        return step_handle;
+    }
+    uint64_t p = as_integers(step_handle)[0];
+    step_handle_t next = step_handle;
+    if (is_path_front_end(step_handle)) {
+        as_integers(next)[1] = 0;
+    } else if (as_integers(step_handle)[1] + 1 < path_steps[p].size()) {
+        ++as_integers(next)[1];
+    } else if (path_circular[p]) {
+        as_integers(next)[1] = 0;
+    } else {
+        return path_end(as_path_handle(p));
+    }
+    return next;
+}
+
+step_handle_t topology_graph_t::get_previous_step(const step_handle_t& step_handle) const {
+    if (is_path_front_end(step_handle)) {
+        return step_handle;
+    }
+    uint64_t p = as_integers(step_handle)[0];
+    step_handle_t prev = step_handle;
+    if (is_path_end(step_handle)) {
+        as_integers(prev)[1] = path_steps[p].size() - 1;
+    } else if (as_integers(step_handle)[1] > 0) {
+        --as_integers(prev)[1];
+    } else if (path_circular[p]) {
+        as_integers(prev)[1] = path_steps[p].size() - 1;
+    } else {
+        return path_front_end(as_path_handle(p));
+    }
+    return prev;
+}
+
+size_t topology_graph_t::get_ordinal_rank_of_step(const step_handle_t& step_handle) const {
+    return as_integers(step_handle)[1];
+}
+
+bool topology_graph_t::is_empty(const path_handle_t& path_handle) const {
+    return path_steps[as_integer(path_handle)].empty();
+}
+
+void topology_graph_t::for_each_step_in_path(const path_handle_t& path, const std::function<void(const step_handle_t&)>& iteratee) const {
+    step_handle_t step = path_begin(path);
+    for (uint64_t i = 0; i < path_steps[as_integer(path)].size(); ++i) {
+        as_integers(step)[1] = i;
+        iteratee(step);
+    }
+}
+
+std::vector<step_handle_t> topology_graph_t::steps_of_handle(const handle_t& handle, bool match_orientation) const {
+    std::vector<step_handle_t> res;
+    for_each_step_on_handle(handle, [&](const step_handle_t& step) {
+            if (!match_orientation || get_is_reverse(handle) == get_is_reverse(get_handle_of_step(step))) {
+                res.push_back(step);
+            }
+        });
+    return res;
+}
+
+bool topology_graph_t::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    for (uint64_t p = 0; p < path_names.size(); ++p) {
+        if (!iteratee(as_path_handle(p))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool topology_graph_t::for_each_step_on_handle_impl(const handle_t& handle, const std::function<bool(const step_handle_t&)>& iteratee) const {
+    index_steps();
+    uint64_t rank = get_rank(handle);
+    step_handle_t step;
+    for (uint64_t k = step_offsets[rank]; k < step_offsets[rank + 1]; ++k) {
+        as_integers(step)[0] = node_steps[k].first;
+        as_integers(step)[1] = node_steps[k].second;
+        if (!iteratee(step)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+/** \file
+ * topology_graph.hpp: defines a lightweight, static handle graph holding only
+ * the topology of a graph, used to order a graph before it is materialized
+ */
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace odgi {
+
+using namespace handlegraph;
+
+    /**
+     * A PathHandleGraph over dense node ranks, with the adjacency of each oriented
+     * handle stored contiguously and the sequences referenced rather than copied.
+     * Each handle follows its edges in the order a graph_t built from the same
+     * edges would, so sorts that depend on that order give the same result on both.
+     * It is built in bulk (nodes, then edges and paths, then index()) and can be
+     * reordered in place, which lets us compute a sort order before we build the
+     * full dynamic graph_t. Handles pack the node rank, as they do in graph_t.
+     */
+    class topology_graph_t : public PathHandleGraph {
+    public:
+
+        topology_graph_t(void) = default;
+        topology_graph_t(const topology_graph_t& other) = delete;
+        topology_graph_t& operator=(const topology_graph_t& other) = delete;
+
+        /// Add a node whose sequence is kept in memory owned by the caller,
+        /// which must outlive the topology graph. Ids must be positive and unique.
+        /// A null sequence gives a node of the given length made of Ns.
+        void add_node(const nid_t& id, const char* seq, uint64_t len);
+
+        /// Add an edge between two oriented nodes.
+        void add_edge(const nid_t& from, bool from_rev, const nid_t& to, bool to_rev);
+
+        /// Add an empty path, returning its handle.
+        path_handle_t add_path(const std::string& name, bool is_circular);
+
+        /// Set if the path is circular or not
+        void set_circularity(const path_handle_t& path, bool circular);
+
+        /// Append a step to the given path.
+        void append_step(const path_handle_t& path, const nid_t& id, bool is_rev);
+
+        /// Finish construction, sorting the nodes by id and resolving the edges and steps
+        /// to their nodes. Edges and steps must refer to nodes that were added.
+        void index(void);
+
+        /// Renumber the nodes to follow the given order, compacting their ids to 1..n.
+        /// This mirrors graph_t::apply_ordering(order, true) without copying sequences,
+        /// down to the order in which each node lists its edges.
+        void apply_ordering(const std::vector<handle_t>& order);
+
+        /// The packed rank (as_integer(handle) >> 1) of a handle, also used by graph_t
+        inline uint64_t get_rank(const handle_t& handle) const {
+            return number_bool_packing::unpack_number(handle);
+        }
+
+        /// Raw access to a node's sequence in its forward orientation
+        inline const char* get_sequence_data(const handle_t& handle) const {
+            return seqs[get_rank(handle)];
+        }
+
+        //////////////////////////
+        /// HandleGraph interface
+        //////////////////////////
+
+        /// Method to check if a node exists by ID
+        bool has_node(nid_t node_id) const;
+
+        /// Look up the handle for the node with the given ID in the given orientation
+        handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+        /// Get the ID from a handle
+        nid_t get_id(const handle_t& handle) const;
+
+        /// Get the orientation of a handle
+        bool get_is_reverse(const handle_t& handle) const;
+
+        /// Invert the orientation of a handle (potentially without getting its ID)
+        handle_t flip(const handle_t& handle) const;
+
+        /// Get the length of a node
+        size_t get_length(const handle_t& handle) const;
+
+        /// Get the sequence of a node, presented in the handle's local forward orientation.
+        std::string get_sequence(const handle_t& handle) const;
+
+        /// Get the number of edges on the right (go_left = false) or left (go_left
+        /// = true) side of the given handle.
+        size_t get_degree(const handle_t& handle, bool go_left) const;
+
+        /// Return the number of nodes in the graph
+        size_t get_node_count(void) const;
+
+        /// Return the smallest ID in the graph
+        nid_t min_node_id(void) const;
+
+        /// Return the largest ID in the graph
+        nid_t max_node_id(void) const;
+
+        ////////////////////////////////////////////////////////////////////////////
+        // Path handle interface
+        ////////////////////////////////////////////////////////////////////////////
+
+        /// Returns the number of paths stored in the graph
+        size_t get_path_count(void) const;
+
+        /// Determine if a path name exists and is legal to get a path handle for.
+        bool has_path(const std::string& path_name) const;
+
+        /// Look up the path handle for the given path name.
+        path_handle_t get_path_handle(const std::string& path_name) const;
+
+        /// Look up the name of a path from a handle to it
+        std::string get_path_name(const path_handle_t& path_handle) const;
+
+        /// Returns true if the path is circular
+        bool get_is_circular(const path_handle_t& path_handle) const;
+
+        /// Returns the number of node steps in the path
+        size_t get_step_count(const path_handle_t& path_handle) const;
+
+        /// Returns the number of node steps on the handle
+        size_t get_step_count(const handle_t& handle) const;
+
+        /// Get a node handle (node ID and orientation) from a handle to a step on a path
+        handle_t get_handle_of_step(const step_handle_t& step_handle) const;
+
+        /// Returns a handle to the path that a step is on
+        path_handle_t get_path_handle_of_step(const step_handle_t& step_handle) const;
+
+        /// Get a path handle (path ID) from a handle to a step on a path
+        path_handle_t get_path(const step_handle_t& step_handle) const;
+
+        /// Get a handle to the first step in a path.
+        step_handle_t path_begin(const path_handle_t& path_handle) const;
+
+        /// Get a handle to a fictitious handle one past the end of the path
+        step_handle_t path_end(const path_handle_t& path_handle) const;
+
+        /// Get a handle to the last step
+        step_handle_t path_back(const path_handle_t& path_handle) const;
+
+        /// Get a handle to a fictitious handle one past the start of the path
+        step_handle_t path_front_end(const path_handle_t& path_handle) const;
+
+        /// Returns true if the step handle is a front end magic handle
+        bool is_path_front_end(const step_handle_t& step_handle) const;
+
+        /// Returns true if the step handle is an end magic handle
+        bool is_path_end(const step_handle_t& step_handle) const;
+
+        /// Returns true if the step is not the last step on the path, else false
+        bool has_next_step(const step_handle_t& step_handle) const;
+
+        /// Returns true if the step is not the first step on the path, else false
+        bool has_previous_step(const step_handle_t& step_handle) const;
+
+        /// Returns a handle to the next step on the path
+        step_handle_t get_next_step(const step_handle_t& step_handle) const;
+
+        /// Returns a handle to the previous step on the path
+        step_handle_t get_previous_step(const step_handle_t& step_handle) const;
+
+        /// Returns the 0-based ordinal rank of a step on a path
+        size_t get_ordinal_rank_of_step(const step_handle_t& step_handle) const;
+
+        /// Returns true if the given path is empty, and false otherwise
+        bool is_empty(const path_handle_t& path_handle) const;
+
+        /// Loop over all the steps along a path, from first through last
+        void for_each_step_in_path(const path_handle_t& path, const std::function<void(const step_handle_t&)>& iteratee) const;
+
+        /// Returns a vector of all steps of a node on paths. Optionally restricts to
+        /// steps that match the handle in orientation.
+        std::vector<step_handle_t> steps_of_handle(const handle_t& handle,
+                                                   bool match_orientation = false) const;
+
+    protected:
+
+        /// Loop over all the handles to next/previous (right/left) nodes.
+        bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+        /// Loop over all the nodes in the graph in their local forward orientations, in rank order.
+        bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+        /// Execute a function on each path in the graph
+        bool for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const;
+
+        /// Enumerate the path steps on a given handle (strand agnostic)
+        bool for_each_step_on_handle_impl(const handle_t& handle, const std::function<bool(const step_handle_t&)>& iteratee) const;
+
+    private:
+
+        /// Build the adjacency from (from, to) pairs of packed handles, storing each edge from both
+        /// strands and keeping the first copy of repeated edges, as adding them to a graph_t would.
+        void index_edges(const std::vector<std::pair<uint64_t, uint64_t>>& edges);
+
+        /// Build the index of steps by node, on first use
+        void index_steps(void) const;
+
+        /// The rank of the node with the given id, or -1 if there is none
+        inline uint64_t rank_of(const nid_t& id) const {
+            return id < min_id || id > max_id ? (uint64_t)-1 : id_to_rank[id - min_id];
+        }
+
+        /// Node ids, sequences and lengths by rank
+        std::vector<nid_t> ids;
+        std::vector<const char*> seqs;
+        std::vector<uint64_t> lengths;
+        /// Ranks of the ids in [min_id, max_id]
+        std::vector<uint64_t> id_to_rank;
+        nid_t min_id = 0;
+        nid_t max_id = 0;
+
+        /// Edges buffered until index(), as (id << 1 | is_rev)
+        std::vector<std::pair<uint64_t, uint64_t>> pending_edges;
+        /// Right-side neighbors of each packed handle, starting at edge_offsets[as_integer(h)]
+        std::vector<uint64_t> edge_offsets;
+        std::vector<handle_t> edge_targets;
+
+        /// Paths, with their steps as (id << 1 | is_rev) until index() and as packed handles after
+        std::vector<std::string> path_names;
+        std::vector<bool> path_circular;
+        std::vector<std::vector<uint64_t>> path_steps;
+
+        /// Steps by node rank, built lazily as (path, rank on path)
+        mutable std::unique_ptr<std::once_flag> steps_indexed = std::unique_ptr<std::once_flag>(new std::once_flag);
+        mutable std::vector<uint64_t> step_offsets;
+        mutable std::vector<std::pair<uint64_t, uint64_t>> node_steps;
+    };
+
+}
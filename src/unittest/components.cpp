@@ -0,0 +1,90 @@
+/**
+ * \file
+ * unittest/components.cpp: test cases for the connected component algorithms.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "algorithms/weakly_connected_components.hpp"
+
+#include <random>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Weakly connected component labels follow the chains the graph is built from", "[components]") {
+    // many chains of random lengths, some joined by inversions, with their nodes interleaved in id order
+    graph_t graph;
+    std::mt19937 rng(37);
+    const uint64_t chains = 500;
+    std::vector<uint64_t> chain_of;
+    for (uint64_t c = 0; c < chains; ++c) {
+        uint64_t length = 1 + rng() % 30;
+        for (uint64_t i = 0; i < length; ++i) chain_of.push_back(c);
+    }
+    std::shuffle(chain_of.begin(), chain_of.end(), rng);
+    std::vector<std::vector<handle_t>> members(chains);
+    for (auto& c : chain_of) {
+        members[c].push_back(graph.create_handle("A"));
+    }
+    for (uint64_t c = 0; c < chains; ++c) {
+        for (uint64_t i = 0; i + 1 < members[c].size(); ++i) {
+            graph.create_edge(members[c][i], rng() % 5 ? members[c][i + 1] : graph.flip(members[c][i + 1]));
+        }
+        // every tenth chain joins the next, as does a self loop
+        if (c % 10 == 0 && c + 1 < chains) {
+            graph.create_edge(graph.flip(members[c].back()), members[c + 1].front());
+        }
+        graph.create_edge(members[c].front(), members[c].front());
+    }
+    // so each component is a chain, or a chain joined to the one before it
+    auto component_of_chain = [](uint64_t c) { return c % 10 == 1 ? c - 1 : c; };
+    std::vector<uint64_t> first;
+    for (uint64_t nthreads : { 1, 4 }) {
+        std::vector<uint64_t> sizes;
+        std::vector<uint64_t> labels = algorithms::weakly_connected_component_labels(&graph, sizes, nthreads);
+        REQUIRE(labels.size() == graph.get_node_count());
+        REQUIRE(sizes.size() == chains - chains / 10);
+        // the chains of a component share a label, and no two components do
+        std::vector<uint64_t> label_of(chains, std::numeric_limits<uint64_t>::max());
+        std::vector<uint64_t> component_with(sizes.size(), std::numeric_limits<uint64_t>::max());
+        std::vector<uint64_t> size_of(sizes.size(), 0);
+        for (uint64_t c = 0; c < chains; ++c) {
+            uint64_t component = component_of_chain(c);
+            for (auto& handle : members[c]) {
+                uint64_t label = labels[number_bool_packing::unpack_number(handle)];
+                REQUIRE(label < sizes.size());
+                if (label_of[component] == std::numeric_limits<uint64_t>::max()) {
+                    label_of[component] = label;
+                    REQUIRE(component_with[label] == std::numeric_limits<uint64_t>::max());
+                    component_with[label] = component;
+                }
+                REQUIRE(label == label_of[component]);
+                ++size_of[label];
+            }
+        }
+        REQUIRE(sizes == size_of);
+        // the components are numbered by their first node
+        uint64_t next_label = 0;
+        graph.for_each_handle([&](const handle_t& handle) {
+                uint64_t label = labels[number_bool_packing::unpack_number(handle)];
+                REQUIRE(label <= next_label);
+                if (label == next_label) ++next_label;
+            });
+        if (first.empty()) {
+            first = labels;
+        } else {
+            REQUIRE(labels == first);
+        }
+    }
+}
+}
+}
@@ -0,0 +1,308 @@
+/**
+ * \file
+ * unittest/gfa.cpp: test cases for GFA loading and writing.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "gfa_to_handle.hpp"
+#include "algorithms/temp_file.hpp"
+#include "algorithms/topological_sort.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <zlib.h>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+static std::string write_gfa(const std::string& gfa) {
+    std::string filename = algorithms::temp_file::create("gfa");
+    std::ofstream out(filename.c_str());
+    out << gfa;
+    out.close();
+    return filename;
+}
+
+// the GFA of the graph with its lines sorted, which doesn't depend on the order of the edges in the graph
+static std::vector<std::string> sorted_gfa_lines(const graph_t& graph) {
+    std::stringstream out;
+    graph.to_gfa(out);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(out, line)) lines.push_back(line);
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+TEST_CASE("GFA loading builds the expected graph", "[gfa]") {
+    std::string filename = write_gfa(
+        "H\tVN:Z:1.0\n"
+        "S\t11\tAGGA\n"
+        "S\t12\tA\n"
+        "S\t13\tTC\n"
+        "S\t14\tTCTCAGG\n"
+        "P\t5\t11+,13+,14+\t4M,2M\n"
+        "P\t5 -\t11+,13-,14+\t*\tTP:Z:circular\n"
+        "L\t11\t+\t12\t+\t0M\n"
+        "L\t11\t+\t13\t+\t0M\n"
+        "L\t11\t+\t13\t-\t0M\n"
+        "L\t13\t-\t14\t+\t0M\n"
+        "L\t12\t+\t14\t+\t0M\n"
+        "L\t13\t+\t14\t+\t0M\r\n");
+    graph_t graph;
+    gfa_to_handle(filename, &graph);
+
+    REQUIRE(graph.get_node_count() == 4);
+    REQUIRE(graph.min_node_id() == 1);
+    REQUIRE(graph.get_sequence(graph.get_handle(11)) == "AGGA");
+    REQUIRE(graph.get_sequence(graph.get_handle(14)) == "TCTCAGG");
+    REQUIRE(graph.get_id(graph.get_handle(13)) == 13);
+
+    uint64_t edge_count = 0;
+    graph.for_each_edge([&](const edge_t& e) { ++edge_count; });
+    REQUIRE(edge_count == 6);
+    REQUIRE(graph.has_edge(graph.get_handle(11), graph.get_handle(13, true)));
+    REQUIRE(graph.has_edge(graph.get_handle(13, true), graph.get_handle(14)));
+
+    REQUIRE(graph.get_path_count() == 2);
+    REQUIRE(graph.has_path("5"));
+    // whitespace in path names is dropped
+    REQUIRE(graph.has_path("5-"));
+    REQUIRE(!graph.get_is_circular(graph.get_path_handle("5")));
+    REQUIRE(graph.get_is_circular(graph.get_path_handle("5-")));
+    std::vector<handle_t> steps;
+    graph.for_each_step_in_path(graph.get_path_handle("5-"), [&](const step_handle_t& s) {
+            steps.push_back(graph.get_handle_of_step(s));
+        });
+    REQUIRE(steps.size() == 3);
+    REQUIRE(steps[0] == graph.get_handle(11, false));
+    REQUIRE(steps[1] == graph.get_handle(13, true));
+    REQUIRE(steps[2] == graph.get_handle(14, false));
+
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Parallel GFA loading matches the serial build", "[gfa]") {
+    std::mt19937 rng(42);
+    std::stringstream gfa;
+    gfa << "H\tVN:Z:1.0\n";
+    uint64_t n = 2000;
+    for (uint64_t i = 1; i <= n; ++i) {
+        gfa << "S\t" << i + 100 << "\t" << std::string(1 + rng() % 20, "ACGT"[rng() % 4]) << "\n";
+    }
+    for (uint64_t i = 1; i < n; ++i) {
+        gfa << "L\t" << i + 100 << "\t+\t" << i + 101 << "\t" << (rng() % 2 ? "+" : "-") << "\t0M\n";
+    }
+    // long paths so that chunk boundaries fall inside their step lists
+    for (uint64_t p = 0; p < 5; ++p) {
+        gfa << "P\tp" << p << "\t";
+        uint64_t len = 1 + rng() % 5000;
+        for (uint64_t i = 0; i < len; ++i) {
+            gfa << 101 + rng() % n << (rng() % 2 ? "+" : "-") << (i + 1 < len ? "," : "");
+        }
+        gfa << "\t*" << (p % 2 ? "\tTP:Z:circular" : "") << "\n";
+    }
+    std::string filename = write_gfa(gfa.str());
+    graph_t serial;
+    gfa_to_handle(filename, &serial, false, 1);
+    std::stringstream serial_out;
+    serial.serialize(serial_out);
+    for (uint64_t t : { 2, 3, 8 }) {
+        graph_t parallel;
+        gfa_to_handle(filename, &parallel, false, t);
+        std::stringstream parallel_out;
+        parallel.serialize(parallel_out);
+        REQUIRE(parallel.get_path_count() == 5);
+        REQUIRE(parallel_out.str() == serial_out.str());
+    }
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Gzipped GFA loading matches the plain build", "[gfa]") {
+    std::mt19937 rng(11);
+    std::stringstream gfa;
+    gfa << "H\tVN:Z:1.0\n";
+    uint64_t n = 100000;
+    for (uint64_t i = 1; i <= n; ++i) {
+        gfa << "S\t" << i << "\t" << std::string(1 + rng() % 100, "ACGT"[rng() % 4]) << "\n";
+    }
+    for (uint64_t i = 1; i < n; ++i) {
+        gfa << "L\t" << i << "\t+\t" << i + 1 << "\t+\t0M\n";
+    }
+    for (uint64_t p = 0; p < 3; ++p) {
+        gfa << "P\tp" << p << "\t";
+        for (uint64_t i = 1; i <= n; ++i) {
+            gfa << i << (rng() % 2 ? "+" : "-") << (i < n ? "," : "");
+        }
+        gfa << "\t*\n";
+    }
+    std::string filename = write_gfa(gfa.str());
+    std::string gz_filename = algorithms::temp_file::create("gfa.gz");
+    gzFile gz = gzopen(gz_filename.c_str(), "wb");
+    gzwrite(gz, gfa.str().data(), gfa.str().size());
+    gzclose(gz);
+    graph_t plain;
+    gfa_to_handle(filename, &plain);
+    std::stringstream plain_out;
+    plain.serialize(plain_out);
+    for (uint64_t t : { 1, 4 }) {
+        graph_t compressed;
+        gfa_to_handle(gz_filename, &compressed, false, t);
+        std::stringstream compressed_out;
+        compressed.serialize(compressed_out);
+        REQUIRE(compressed_out.str() == plain_out.str());
+    }
+    algorithms::temp_file::remove(filename);
+    algorithms::temp_file::remove(gz_filename);
+}
+
+TEST_CASE("Ordered GFA loading matches building then sorting", "[gfa]") {
+    // a chain with shuffled ids, so that its topological order is unique
+    std::mt19937 rng(5);
+    uint64_t n = 5000;
+    std::vector<uint64_t> ids(n);
+    for (uint64_t i = 0; i < n; ++i) ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    std::stringstream gfa;
+    gfa << "H\tVN:Z:1.0\n";
+    for (uint64_t i = 1; i <= n; ++i) {
+        gfa << "S\t" << i << "\t" << std::string(1 + rng() % 10, "ACGT"[rng() % 4]) << "\n";
+    }
+    for (uint64_t i = 0; i + 1 < n; ++i) {
+        gfa << "L\t" << ids[i] << "\t+\t" << ids[i+1] << "\t+\t0M\n";
+    }
+    gfa << "P\tchain\t";
+    for (uint64_t i = 0; i < n; ++i) {
+        gfa << ids[i] << "+" << (i + 1 < n ? "," : "");
+    }
+    gfa << "\t*\n";
+    gfa << "P\tloop\t" << ids[2] << "+," << ids[1] << "-\t*\tTP:Z:circular\n";
+    std::string filename = write_gfa(gfa.str());
+
+    graph_t sorted;
+    gfa_to_handle(filename, &sorted);
+    sorted.apply_ordering(algorithms::topological_order(&sorted, true, false, false), true);
+    graph_t ordered;
+    gfa_to_handle_ordered(filename, &ordered,
+                          { [](const PathHandleGraph& g) { return algorithms::topological_order(&g, true, false, false); } },
+                          false, 4);
+    REQUIRE(ordered.get_node_count() == n);
+    REQUIRE(ordered.get_is_circular(ordered.get_path_handle("loop")));
+    REQUIRE(sorted_gfa_lines(ordered) == sorted_gfa_lines(sorted));
+
+    // each sort sees the graph renumbered by the one before it
+    sorted.apply_ordering(algorithms::topological_order(&sorted, true, false, false), true);
+    std::vector<handle_t> reversed;
+    sorted.for_each_handle([&](const handle_t& h) { reversed.push_back(h); });
+    std::reverse(reversed.begin(), reversed.end());
+    sorted.apply_ordering(reversed, true);
+    graph_t reordered;
+    graph_order_f reverse_order = [](const PathHandleGraph& g) {
+        std::vector<handle_t> order;
+        g.for_each_handle([&](const handle_t& h) { order.push_back(h); });
+        std::reverse(order.begin(), order.end());
+        return order;
+    };
+    gfa_to_handle_ordered(filename, &reordered,
+                          { [](const PathHandleGraph& g) { return algorithms::topological_order(&g, true, false, false); },
+                            reverse_order });
+    REQUIRE(reordered.get_id(reordered.get_handle_of_step(reordered.path_begin(reordered.get_path_handle("chain")))) == n);
+    REQUIRE(sorted_gfa_lines(reordered) == sorted_gfa_lines(sorted));
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Ordered GFA loading of a branching graph matches building then sorting", "[gfa]") {
+    // bubbles, skips and back edges, with the links in shuffled order, sorted by searches
+    // whose result depends on the order in which each node lists its edges
+    std::mt19937 rng(17);
+    uint64_t n = 3000;
+    std::stringstream gfa;
+    gfa << "H\tVN:Z:1.0\n";
+    for (uint64_t i = 1; i <= n; ++i) {
+        gfa << "S\t" << i << "\t" << std::string(1 + rng() % 10, "ACGT"[rng() % 4]) << "\n";
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> links;
+    for (uint64_t i = 1; i < n; ++i) {
+        links.push_back(std::make_pair(i, i + 1));
+        if (i + 2 <= n && rng() % 2) links.push_back(std::make_pair(i, i + 2 + rng() % std::min((uint64_t)5, n - i - 1)));
+        if (i > 10 && rng() % 20 == 0) links.push_back(std::make_pair(i, i - 1 - rng() % 10));
+    }
+    std::shuffle(links.begin(), links.end(), rng);
+    for (auto& l : links) {
+        gfa << "L\t" << l.first << "\t+\t" << l.second << "\t+\t0M\n";
+    }
+    gfa << "P\tbackbone\t";
+    for (uint64_t i = 1; i <= n; ++i) {
+        gfa << i << "+" << (i < n ? "," : "");
+    }
+    gfa << "\t*\n";
+    std::string filename = write_gfa(gfa.str());
+    std::vector<graph_order_f> sorts = {
+        [](const PathHandleGraph& g) { return algorithms::depth_first_topological_order(g, 1000); },
+        [](const PathHandleGraph& g) { return algorithms::breadth_first_topological_order(g, 1000); },
+        [](const PathHandleGraph& g) { return algorithms::depth_first_topological_order(g, std::numeric_limits<uint64_t>::max()); } };
+    graph_t sorted;
+    gfa_to_handle(filename, &sorted);
+    for (auto& sort : sorts) {
+        sorted.apply_ordering(sort(sorted), true);
+    }
+    graph_t ordered;
+    gfa_to_handle_ordered(filename, &ordered, sorts);
+    REQUIRE(ordered.get_node_count() == n);
+    REQUIRE(sorted_gfa_lines(ordered) == sorted_gfa_lines(sorted));
+    algorithms::temp_file::remove(filename);
+}
+
+TEST_CASE("Parallel GFA writing round-trips the graph", "[gfa]") {
+    std::mt19937 rng(7);
+    std::stringstream gfa;
+    gfa << "H\tVN:Z:1.0\n";
+    uint64_t n = 40000;
+    for (uint64_t i = 1; i <= n; ++i) {
+        gfa << "S\t" << i << "\t" << std::string(1 + rng() % 10, "ACGT"[rng() % 4]) << "\n";
+    }
+    for (uint64_t i = 1; i < n; ++i) {
+        gfa << "L\t" << i << "\t+\t" << i + 1 << "\t" << (rng() % 2 ? "+" : "-") << "\t0M\n";
+    }
+    for (uint64_t p = 0; p < 10; ++p) {
+        gfa << "P\tp" << p << "\t";
+        uint64_t len = 1 + rng() % 1000;
+        for (uint64_t i = 0; i < len; ++i) {
+            gfa << 1 + rng() % n << (rng() % 2 ? "+" : "-") << (i + 1 < len ? "," : "");
+        }
+        gfa << "\t*" << (p % 2 ? "\tTP:Z:circular" : "") << "\n";
+    }
+    std::string filename = write_gfa(gfa.str());
+    graph_t graph;
+    gfa_to_handle(filename, &graph);
+    algorithms::temp_file::remove(filename);
+
+    std::stringstream serial_gfa;
+    graph.to_gfa(serial_gfa);
+    std::stringstream parallel_gfa;
+    graph.to_gfa(parallel_gfa, 4);
+    REQUIRE(parallel_gfa.str() == serial_gfa.str());
+
+    // reloading our output gives back the same graph
+    std::string written = write_gfa(serial_gfa.str());
+    graph_t reloaded;
+    gfa_to_handle(written, &reloaded);
+    algorithms::temp_file::remove(written);
+    REQUIRE(reloaded.get_node_count() == n);
+    REQUIRE(reloaded.get_path_count() == 10);
+    std::stringstream reloaded_gfa;
+    reloaded.to_gfa(reloaded_gfa, 4);
+    REQUIRE(reloaded_gfa.str() == serial_gfa.str());
+}
+
+}
+}
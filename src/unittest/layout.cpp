@@ -0,0 +1,348 @@
+/**
+ * \file
+ * unittest/layout.cpp: test cases for the 2D SGD layout and its rendering.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "algorithms/sgd_layout.hpp"
+#include "algorithms/xp.hpp"
+#include "algorithms/draw_layout.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <dirent.h>
+#include <unistd.h>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+// a chain of the given length followed by a square grid, as two components with compact ids
+static void build_chain_and_grid(graph_t& graph, uint64_t chain_length, uint64_t grid_side) {
+    std::vector<handle_t> chain;
+    for (uint64_t i = 0; i < chain_length; ++i) {
+        chain.push_back(graph.create_handle("A"));
+        if (i) graph.create_edge(chain[i - 1], chain[i]);
+    }
+    std::vector<handle_t> grid;
+    for (uint64_t i = 0; i < grid_side * grid_side; ++i) {
+        grid.push_back(graph.create_handle("C"));
+    }
+    for (uint64_t y = 0; y < grid_side; ++y) {
+        for (uint64_t x = 0; x < grid_side; ++x) {
+            uint64_t i = y * grid_side + x;
+            if (x + 1 < grid_side) graph.create_edge(grid[i], grid[i + 1]);
+            if (y + 1 < grid_side) graph.create_edge(grid[i], grid[i + grid_side]);
+        }
+    }
+}
+
+static double layout_distance(const std::vector<double>& layout, const nid_t& a, const nid_t& b) {
+    double dx = layout[2 * (a - 1)] - layout[2 * (b - 1)];
+    double dy = layout[2 * (a - 1) + 1] - layout[2 * (b - 1) + 1];
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+TEST_CASE("SGD layout follows the graph distances and keeps the components apart", "[layout]") {
+    graph_t graph;
+    const uint64_t chain_length = 200;
+    const uint64_t grid_side = 30;
+    build_chain_and_grid(graph, chain_length, grid_side);
+    const nid_t grid_start = chain_length + 1;
+    for (uint64_t pivots : {(uint64_t)0, (uint64_t)10}) {
+        for (uint64_t threads : {(uint64_t)1, (uint64_t)4}) {
+            std::vector<double> layout = algorithms::sgd_layout(graph, pivots, 30, 0.01, 10.0, threads);
+            REQUIRE(layout.size() == 2 * graph.get_node_count());
+            // edges come out about unit length, though stress bends the grid away from its manhattan distances
+            double edge_error = 0;
+            uint64_t edge_count = 0;
+            graph.for_each_edge([&](const edge_t& edge) {
+                    edge_error += std::abs(layout_distance(layout, graph.get_id(edge.first), graph.get_id(edge.second)) - 1);
+                    ++edge_count;
+                });
+            REQUIRE(edge_error / edge_count < 0.5);
+            // the chain is stretched out, and the grid is not folded onto itself
+            REQUIRE(layout_distance(layout, 1, chain_length) > 0.9 * (chain_length - 1));
+            double diagonal = layout_distance(layout, grid_start, grid_start + grid_side * grid_side - 1);
+            REQUIRE(diagonal > 0.8 * std::sqrt(2.0) * (grid_side - 1));
+            // the grid is placed to the right of the chain
+            double chain_max_x = layout[0];
+            for (nid_t id = 1; id < grid_start; ++id) {
+                chain_max_x = std::max(chain_max_x, layout[2 * (id - 1)]);
+            }
+            for (nid_t id = grid_start; id < grid_start + (nid_t)(grid_side * grid_side); ++id) {
+                REQUIRE(layout[2 * (id - 1)] > chain_max_x);
+            }
+        }
+    }
+}
+
+TEST_CASE("Warm started SGD layout moves only the nodes around the changes", "[layout]") {
+    graph_t graph;
+    const uint64_t chain_length = 200;
+    const uint64_t grid_side = 20;
+    build_chain_and_grid(graph, chain_length, grid_side);
+    std::vector<double> layout = algorithms::sgd_layout(graph, 0, 30, 0.01, 10.0, 2);
+    // the layout survives a round trip through its file format
+    algorithms::layout_t saved(graph, layout);
+    std::stringstream file;
+    saved.serialize(file);
+    algorithms::layout_t start;
+    start.load(file);
+    REQUIRE(start.min_id == saved.min_id);
+    REQUIRE(start.coords == saved.coords);
+    // put a new node in the middle of the chain
+    const nid_t left = chain_length / 2;
+    const nid_t right = left + 1;
+    graph.destroy_edge(graph.get_handle(left), graph.get_handle(right));
+    handle_t inserted = graph.create_handle("G");
+    graph.create_edge(graph.get_handle(left), inserted);
+    graph.create_edge(inserted, graph.get_handle(right));
+    REQUIRE(!start.has(graph.get_id(inserted)));
+    const uint64_t radius = 10;
+    std::vector<double> relayout = algorithms::sgd_layout(graph, 0, 30, 0.01, 10.0, 2, &start, radius);
+    // the new node lands between its neighbors
+    REQUIRE(layout_distance(relayout, left, graph.get_id(inserted)) < 2);
+    REQUIRE(layout_distance(relayout, graph.get_id(inserted), right) < 2);
+    // and the nodes far from it stay where they were
+    for (nid_t id = 1; id <= (nid_t)(chain_length + grid_side * grid_side); ++id) {
+        if (id > left - (nid_t)radius && id < right + (nid_t)radius) continue;
+        REQUIRE(relayout[2 * (id - 1)] == layout[2 * (id - 1)]);
+        REQUIRE(relayout[2 * (id - 1) + 1] == layout[2 * (id - 1) + 1]);
+    }
+}
+
+TEST_CASE("Warm started SGD layout follows deletions once the ids are compacted", "[layout]") {
+    graph_t graph;
+    const uint64_t chain_length = 200;
+    const uint64_t grid_side = 20;
+    build_chain_and_grid(graph, chain_length, grid_side);
+    std::vector<double> layout = algorithms::sgd_layout(graph, 0, 30, 0.01, 10.0, 2);
+    algorithms::layout_t saved(graph, layout);
+    // cut a stretch out of the middle of the chain, leaving a gap in the ids, and join its ends
+    const nid_t left = chain_length / 2;
+    const nid_t right = left + 5;
+    for (nid_t id = left + 1; id < right; ++id) {
+        graph.destroy_handle(graph.get_handle(id));
+    }
+    graph.create_edge(graph.get_handle(left), graph.get_handle(right));
+    REQUIRE(graph.max_node_id() > (nid_t)graph.get_node_count());
+    // as odgi layout does, compact the ids in their order and renumber the layout to match
+    std::vector<handle_t> order;
+    graph.for_each_handle([&](const handle_t& handle) { order.push_back(handle); });
+    std::sort(order.begin(), order.end(), [&](const handle_t& a, const handle_t& b) {
+            return graph.get_id(a) < graph.get_id(b);
+        });
+    std::vector<nid_t> original_ids;
+    for (auto& handle : order) {
+        original_ids.push_back(graph.get_id(handle));
+    }
+    graph.apply_ordering(order, true);
+    algorithms::layout_t start = saved.compacted(original_ids);
+    const uint64_t radius = 10;
+    std::vector<double> relayout = algorithms::sgd_layout(graph, 0, 30, 0.01, 10.0, 2, &start, radius);
+    algorithms::layout_t result = algorithms::layout_t(graph, relayout).expanded(original_ids);
+    // the deleted nodes have no position, and the ends of the cut, about 5 apart before, are pulled together
+    for (nid_t id = left + 1; id < right; ++id) {
+        REQUIRE(!result.has(id));
+    }
+    REQUIRE(std::hypot(saved.x(left) - saved.x(right), saved.y(left) - saved.y(right)) > 3);
+    REQUIRE(std::hypot(result.x(left) - result.x(right), result.y(left) - result.y(right)) < 3);
+    // while the nodes far from the cut stay where they were, under their original ids
+    for (nid_t id = 1; id <= (nid_t)(chain_length + grid_side * grid_side); ++id) {
+        if (id > left - (nid_t)radius && id < right + (nid_t)radius) continue;
+        REQUIRE(result.x(id) == saved.x(id));
+        REQUIRE(result.y(id) == saved.y(id));
+    }
+}
+
+TEST_CASE("Path guided SGD layout follows the distances along the paths", "[layout]") {
+    // a chain of nodes of varying length, walked by one path
+    graph_t graph;
+    const uint64_t node_count = 300;
+    std::vector<handle_t> handles;
+    uint64_t path_length = 0;
+    path_handle_t path = graph.create_path_handle("chain");
+    for (uint64_t i = 0; i < node_count; ++i) {
+        handles.push_back(graph.create_handle(std::string(1 + i % 7, 'A')));
+        if (i) graph.create_edge(handles[i - 1], handles[i]);
+        graph.append_step(path, handles[i]);
+        path_length += graph.get_length(handles[i]);
+    }
+    xp::XP path_index;
+    path_index.from_handle_graph(graph);
+    for (uint64_t threads : {(uint64_t)1, (uint64_t)4}) {
+        std::vector<double> layout = algorithms::path_sgd_2d_layout(graph, path_index, 0, 10, 30, 0.01, threads, 42);
+        REQUIRE(layout.size() == 2 * node_count);
+        // consecutive steps sit about the length of the first apart
+        double step_error = 0;
+        for (uint64_t i = 0; i + 1 < node_count; ++i) {
+            double length = graph.get_length(handles[i]);
+            step_error += std::abs(layout_distance(layout, i + 1, i + 2) - length) / length;
+        }
+        REQUIRE(step_error / (node_count - 1) < 0.5);
+        // and the path is stretched out end to end
+        double end_to_end = path_length - graph.get_length(handles.back());
+        REQUIRE(layout_distance(layout, 1, node_count) > 0.9 * end_to_end);
+    }
+}
+
+TEST_CASE("SVG output merges chains and draws detail below a pixel as dots", "[layout]") {
+    graph_t graph;
+    const uint64_t chain_length = 1000;
+    build_chain_and_grid(graph, chain_length, 2);
+    std::vector<double> X(2 * graph.get_node_count(), 0.0);
+    // the chain runs straight along x, and the grid is a square far smaller than a pixel
+    for (uint64_t i = 0; i < chain_length; ++i) {
+        X[2 * i] = i;
+    }
+    for (uint64_t i = chain_length; i < graph.get_node_count(); ++i) {
+        X[2 * i] = 2 * chain_length;
+        X[2 * i + 1] = 0.01 * (i - chain_length);
+    }
+    std::stringstream svg;
+    algorithms::draw_svg(svg, X, graph, 1.0);
+    std::string out = svg.str();
+    auto count = [&](const std::string& s) {
+        uint64_t c = 0;
+        for (size_t p = out.find(s); p != std::string::npos; p = out.find(s, p + 1)) ++c;
+        return c;
+    };
+    REQUIRE(count("<line ") == 1);
+    REQUIRE(count("<polyline ") == 0);
+    REQUIRE(out.find("x2=\"999.00\"") != std::string::npos);
+    REQUIRE(count("<circle ") == 1);
+    REQUIRE(out.find("<circle cx=\"2000.50\" cy=\"0.50\" r=\"0.50\"/>") != std::string::npos);
+    REQUIRE(out.substr(out.size() - 7) == "</svg>\n");
+}
+
+TEST_CASE("SVG output keeps every node within half a pixel and every bubble visible", "[layout]") {
+    auto count = [](const std::string& out, const std::string& s) {
+        uint64_t c = 0;
+        for (size_t p = out.find(s); p != std::string::npos; p = out.find(s, p + 1)) ++c;
+        return c;
+    };
+    SECTION("a chain that doubles back keeps its far end") {
+        // out 10 pixels along x and back to 5, all on one line
+        graph_t graph;
+        std::vector<double> X;
+        handle_t last;
+        for (uint64_t i = 0; i <= 15; ++i) {
+            handle_t h = graph.create_handle("A");
+            if (i) graph.create_edge(last, h);
+            last = h;
+            X.push_back(i <= 10 ? i : 20.0 - i);
+            X.push_back(0);
+        }
+        std::stringstream svg;
+        algorithms::draw_svg(svg, X, graph, 1.0);
+        std::string out = svg.str();
+        REQUIRE(out.find("<polyline points=\"0.00,0.00 10.00,0.00 5.00,0.00\"/>") != std::string::npos);
+    }
+    SECTION("bubbles smaller than a pixel become one dot per pixel they touch") {
+        // a chain of 1000 bubbles, ten to a pixel, along a line 100 pixels long
+        graph_t graph;
+        std::vector<double> X;
+        handle_t from = graph.create_handle("A");
+        X.push_back(0);
+        X.push_back(0.5);
+        for (uint64_t i = 1; i <= 1000; ++i) {
+            handle_t a = graph.create_handle("A");
+            handle_t b = graph.create_handle("A");
+            handle_t to = graph.create_handle("A");
+            graph.create_edge(from, a);
+            graph.create_edge(from, b);
+            graph.create_edge(a, to);
+            graph.create_edge(b, to);
+            for (double y : { 0.45, 0.55, 0.5 }) {
+                X.push_back(0.1 * i - (y == 0.5 ? 0 : 0.05));
+                X.push_back(y);
+            }
+            from = to;
+        }
+        std::stringstream svg;
+        algorithms::draw_svg(svg, X, graph, 1.0);
+        std::string out = svg.str();
+        // every pixel along the line gets exactly one dot
+        REQUIRE(count(out, "<circle ") == 101);
+        for (uint64_t px = 0; px <= 100; ++px) {
+            std::string dot = "<circle cx=\"" + std::to_string(px) + ".50\" cy=\"0.50\"";
+            REQUIRE(count(out, dot) == 1);
+        }
+        REQUIRE(count(out, "<line ") == 0);
+        REQUIRE(count(out, "<polyline ") == 0);
+    }
+}
+
+// remove the directory and everything in it
+static void remove_tree(const std::string& path) {
+    DIR* dir = opendir(path.c_str());
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") continue;
+            remove_tree(path + "/" + name);
+        }
+        closedir(dir);
+        rmdir(path.c_str());
+    } else {
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("PNG tiles are written for every tile the layout crosses and no others", "[layout]") {
+    // a chain along y = 0.6 x, from the corner of the layout to its far side, and a node in the opposite corner
+    graph_t graph;
+    std::vector<double> X;
+    const uint64_t chain_length = 1001;
+    handle_t last;
+    for (uint64_t i = 0; i < chain_length; ++i) {
+        handle_t h = graph.create_handle("A");
+        if (i) graph.create_edge(last, h);
+        last = h;
+        X.push_back(i);
+        X.push_back(0.6 * i);
+    }
+    graph.create_handle("C");
+    X.push_back(0);
+    X.push_back(1000);
+    std::string dir = algorithms::temp_file::create("tiles");
+    algorithms::temp_file::remove(dir);
+    const uint64_t levels = 3;
+    algorithms::draw_png_tiles(dir, X, graph, levels, 64, 2);
+    auto exists = [&](uint64_t z, uint64_t x, uint64_t y) {
+        std::string path = dir + "/" + std::to_string(z) + "/" + std::to_string(x) + "/" + std::to_string(y) + ".png";
+        return std::ifstream(path).good();
+    };
+    for (uint64_t z = 0; z < levels; ++z) {
+        uint64_t tiles = (uint64_t)1 << z;
+        double tile_span = 1000.0 / tiles;
+        // the tiles the line passes through, which it never crosses near a corner
+        std::vector<bool> crossed(tiles * tiles, false);
+        for (uint64_t k = 0; k <= 100000; ++k) {
+            double x = 0.01 * k;
+            uint64_t tx = std::min(tiles - 1, (uint64_t)(x / tile_span));
+            uint64_t ty = std::min(tiles - 1, (uint64_t)(0.6 * x / tile_span));
+            crossed[ty * tiles + tx] = true;
+        }
+        crossed[(tiles - 1) * tiles] = true;
+        for (uint64_t ty = 0; ty < tiles; ++ty) {
+            for (uint64_t tx = 0; tx < tiles; ++tx) {
+                REQUIRE(exists(z, tx, ty) == crossed[ty * tiles + tx]);
+            }
+        }
+    }
+    remove_tree(dir);
+}
+}
+}
@@ -0,0 +1,286 @@
+/**
+ * \file
+ * unittest/linear_sgd.cpp: test cases and benchmarks for the 1D SGD sort.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "algorithms/linear_sgd.hpp"
+#include "algorithms/multilevel_sgd.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <algorithm>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+// a chain of n bubbles with a path through one side of each, in a shuffled id order
+static void make_bubble_chain(graph_t& graph, uint64_t n, uint64_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint64_t> ids(3 * n + 1);
+    for (uint64_t i = 0; i < ids.size(); ++i) ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    for (auto& id : ids) {
+        graph.create_handle(std::string(1 + rng() % 10, "ACGT"[rng() % 4]), id);
+    }
+    path_handle_t path = graph.create_path_handle("chain");
+    for (uint64_t i = 0; i < n; ++i) {
+        handle_t from = graph.get_handle(ids[3 * i]);
+        handle_t a = graph.get_handle(ids[3 * i + 1]);
+        handle_t b = graph.get_handle(ids[3 * i + 2]);
+        handle_t to = graph.get_handle(ids[3 * i + 3]);
+        graph.create_edge(from, a);
+        graph.create_edge(from, b);
+        graph.create_edge(a, to);
+        graph.create_edge(b, to);
+        graph.append_step(path, from);
+        graph.append_step(path, rng() % 2 ? a : b);
+    }
+    graph.append_step(path, graph.get_handle(ids.back()));
+}
+
+TEST_CASE("Linear SGD orders every node", "[linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 1000, 3);
+    for (bool batched : { false, true }) {
+        for (bool use_paths : { false, true }) {
+            for (uint64_t nthreads : { 1, 4 }) {
+                std::vector<double> layout = algorithms::linear_sgd(graph, 100, 20, use_paths, 30, 0.01, 0, nthreads, 42, false, batched);
+                REQUIRE(layout.size() == graph.get_node_count());
+                for (auto& x : layout) {
+                    REQUIRE(std::isfinite(x));
+                }
+                std::vector<handle_t> order = algorithms::linear_sgd_order(graph, 100, 20, use_paths, 30, 0.01, 0, nthreads, 42, false, batched);
+                std::set<uint64_t> seen;
+                for (auto& h : order) seen.insert(as_integer(h));
+                REQUIRE(seen.size() == graph.get_node_count());
+            }
+        }
+        xp::XP path_index;
+        path_index.from_handle_graph(graph);
+        for (uint64_t nthreads : { 1, 4 }) {
+            std::vector<double> layout = algorithms::path_linear_sgd(graph, path_index, 100, 20, 30, 0.01, 0, nthreads, 42, false, batched);
+            REQUIRE(layout.size() == graph.get_node_count());
+            for (auto& x : layout) {
+                REQUIRE(std::isfinite(x));
+            }
+        }
+    }
+}
+
+TEST_CASE("Deterministic linear SGD is reproducible", "[linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 1000, 5);
+    SECTION("the term search depends only on the seed") {
+        auto a = algorithms::linear_sgd_search(graph, 100, 20, 42);
+        auto b = algorithms::linear_sgd_search(graph, 100, 20, 42);
+        REQUIRE(a.size() == b.size());
+        for (uint64_t k = 0; k < a.size(); ++k) {
+            REQUIRE(a[k].i == b[k].i);
+            REQUIRE(a[k].j == b[k].j);
+        }
+    }
+    SECTION("the layout depends only on the seed and the thread count") {
+        for (bool use_paths : { false, true }) {
+            for (bool batched : { false, true }) {
+                std::vector<double> a = algorithms::linear_sgd(graph, 100, 20, use_paths, 30, 0.01, 0, 4, 42, true, batched);
+                std::vector<double> b = algorithms::linear_sgd(graph, 100, 20, use_paths, 30, 0.01, 0, 4, 42, true, batched);
+                REQUIRE(a == b);
+            }
+        }
+        xp::XP path_index;
+        path_index.from_handle_graph(graph);
+        std::vector<double> a = algorithms::path_linear_sgd(graph, path_index, 100, 20, 30, 0.01, 0, 4, 42, true, false);
+        std::vector<double> b = algorithms::path_linear_sgd(graph, path_index, 100, 20, 30, 0.01, 0, 4, 42, true, false);
+        REQUIRE(a == b);
+    }
+}
+
+TEST_CASE("The AVX2 and scalar SGD kernels compute the same moves", "[linear_sgd]") {
+    if (!algorithms::sgd_has_avx2()) {
+        WARN("skipped: this build or CPU has no AVX2");
+        return;
+    }
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> position(0, 1e6), distance(0, 1e4), weight(1e-8, 1);
+    algorithms::sgd_batch_t scalar, avx2;
+    // every batch size, so that the vector loop and its scalar tail are both covered
+    for (uint64_t size = 0; size <= algorithms::sgd_batch_t::capacity; ++size) {
+        scalar.size = size;
+        for (uint64_t k = 0; k < size; ++k) {
+            scalar.x_i[k] = position(rng);
+            // some terms whose nodes coincide, and which are moved apart by the tiny dx
+            scalar.x_j[k] = rng() % 8 == 0 ? scalar.x_i[k] : position(rng);
+            scalar.d[k] = distance(rng);
+            scalar.w[k] = weight(rng);
+        }
+        avx2 = scalar;
+        double eta = std::pow(10, (double)(rng() % 12) - 6);
+        double Delta_max_scalar = algorithms::sgd_batch_moves_scalar(scalar, eta);
+        double Delta_max_avx2 = algorithms::sgd_batch_moves_avx2(avx2, eta);
+        REQUIRE(Delta_max_scalar == Delta_max_avx2);
+        for (uint64_t k = 0; k < size; ++k) {
+            // the scalar kernel rounds once more, computing Delta / |dx| * dx rather than taking the sign of dx
+            double tolerance = 4 * std::numeric_limits<double>::epsilon() * std::abs(scalar.r_x[k]);
+            REQUIRE(std::abs(scalar.r_x[k] - avx2.r_x[k]) <= tolerance);
+        }
+    }
+}
+
+TEST_CASE("Multilevel linear SGD orders every node", "[linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 5000, 11);
+    SECTION("coarsening merges nodes and keeps the paths") {
+        algorithms::sgd_level_t level;
+        level.lengths.resize(graph.get_node_count());
+        graph.for_each_handle([&](const handle_t& h) {
+                level.lengths[number_bool_packing::unpack_number(h)] = graph.get_length(h);
+            });
+        graph.for_each_edge([&](const edge_t& e) {
+                level.edges.push_back(std::make_pair(as_integer(e.first), as_integer(e.second)));
+                level.edge_weights.push_back(1);
+            });
+        std::vector<uint64_t> group, offset;
+        algorithms::sgd_level_t coarse = algorithms::coarsen_sgd_level(graph, level, 42, group, offset);
+        REQUIRE(coarse.lengths.size() < level.lengths.size());
+        uint64_t length = 0, coarse_length = 0;
+        for (auto& l : level.lengths) length += l;
+        for (auto& l : coarse.lengths) coarse_length += l;
+        REQUIRE(length == coarse_length);
+        for (uint64_t i = 0; i < group.size(); ++i) {
+            REQUIRE(group[i] < coarse.lengths.size());
+            REQUIRE(offset[i] + level.lengths[i] <= coarse.lengths[group[i]]);
+        }
+    }
+    SECTION("the layout covers the graph") {
+        for (bool use_paths : { false, true }) {
+            std::vector<handle_t> order = algorithms::multilevel_linear_sgd_order(graph, 100, 20, use_paths, 30, 0.01, 0, 4,
+                                                                                  42, false, false);
+            std::set<uint64_t> seen;
+            for (auto& h : order) seen.insert(as_integer(h));
+            REQUIRE(seen.size() == graph.get_node_count());
+        }
+    }
+}
+
+TEST_CASE("Coarsening gives each chain of zero-length nodes its own coarse node", "[linear_sgd]") {
+    // two chains, the first of which has no length at the level we coarsen
+    graph_t graph;
+    for (nid_t id = 1; id <= 6; ++id) {
+        graph.create_handle("ACGT", id);
+    }
+    for (nid_t id : { 1, 2, 4, 5 }) {
+        graph.create_edge(graph.get_handle(id), graph.get_handle(id + 1));
+    }
+    algorithms::sgd_level_t level;
+    level.lengths = { 0, 0, 0, 4, 4, 4 };
+    graph.for_each_edge([&](const edge_t& e) {
+            level.edges.push_back(std::make_pair(as_integer(e.first), as_integer(e.second)));
+            level.edge_weights.push_back(1);
+        });
+    std::vector<uint64_t> group, offset;
+    algorithms::sgd_level_t coarse = algorithms::coarsen_sgd_level(graph, level, 42, group, offset);
+    REQUIRE(coarse.lengths.size() == 2);
+    REQUIRE(group[0] == group[1]);
+    REQUIRE(group[1] == group[2]);
+    REQUIRE(group[3] == group[4]);
+    REQUIRE(group[4] == group[5]);
+    REQUIRE(group[0] != group[3]);
+    REQUIRE(coarse.lengths[group[0]] == 0);
+    REQUIRE(coarse.lengths[group[3]] == 12);
+    REQUIRE(coarse.edges.empty());
+}
+
+TEST_CASE("Linear SGD thread scaling", "[.benchmark][linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 100000, 7);
+    double base_seconds = 0;
+    std::cerr << "threads\tseconds\tspeedup" << std::endl;
+    for (uint64_t nthreads = 1; nthreads <= 64; nthreads *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        // with delta = 0 we run all t_max iterations, so beyond the serial term search
+        // the time measures update throughput
+        std::vector<double> layout = algorithms::linear_sgd(graph, 1000, 20, false, 30, 0.01, 0, nthreads, 42, false, false);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (nthreads == 1) base_seconds = elapsed.count();
+        std::cerr << nthreads << "\t" << elapsed.count() << "\t" << base_seconds / elapsed.count() << std::endl;
+        REQUIRE(layout.size() == graph.get_node_count());
+    }
+}
+
+TEST_CASE("Linear SGD scalar and batched kernels", "[.benchmark][linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 100000, 7);
+    std::cerr << "threads\tscalar\tbatched\tspeedup" << std::endl;
+    for (uint64_t nthreads = 1; nthreads <= 64; nthreads *= 4) {
+        double seconds[2];
+        for (bool batched : { false, true }) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<double> layout = algorithms::linear_sgd(graph, 1000, 20, false, 30, 0.01, 0, nthreads, 42, false, batched);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds[batched] = elapsed.count();
+            REQUIRE(layout.size() == graph.get_node_count());
+        }
+        std::cerr << nthreads << "\t" << seconds[0] << "\t" << seconds[1] << "\t" << seconds[0] / seconds[1] << std::endl;
+    }
+}
+
+TEST_CASE("Multilevel and flat linear SGD", "[.benchmark][linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 100000, 7);
+    // how far apart the nodes of each edge land in the order, on average
+    auto mean_edge_span = [&](const std::vector<handle_t>& order) {
+        std::vector<uint64_t> position(graph.get_node_count());
+        for (uint64_t i = 0; i < order.size(); ++i) {
+            position[number_bool_packing::unpack_number(order[i])] = i;
+        }
+        double sum = 0;
+        uint64_t count = 0;
+        graph.for_each_edge([&](const edge_t& e) {
+                sum += std::abs((int64_t)position[number_bool_packing::unpack_number(e.first)]
+                                - (int64_t)position[number_bool_packing::unpack_number(e.second)]);
+                ++count;
+            });
+        return sum / count;
+    };
+    std::cerr << "sort\tseconds\tmean edge span" << std::endl;
+    for (bool multilevel : { false, true }) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<handle_t> order = multilevel
+            ? algorithms::multilevel_linear_sgd_order(graph, 1000, 20, false, 30, 0.01, 0, 4, 42, false, false)
+            : algorithms::linear_sgd_order(graph, 1000, 20, false, 30, 0.01, 0, 4, 42, false, false);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << (multilevel ? "multilevel" : "flat") << "\t" << elapsed.count() << "\t" << mean_edge_span(order) << std::endl;
+        REQUIRE(order.size() == graph.get_node_count());
+    }
+}
+
+TEST_CASE("Path-sampled linear SGD thread scaling", "[.benchmark][linear_sgd]") {
+    graph_t graph;
+    make_bubble_chain(graph, 100000, 7);
+    xp::XP path_index;
+    path_index.from_handle_graph(graph);
+    double base_seconds = 0;
+    std::cerr << "threads\tseconds\tspeedup" << std::endl;
+    for (uint64_t nthreads = 1; nthreads <= 64; nthreads *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> layout = algorithms::path_linear_sgd(graph, path_index, 1000, 20, 30, 0.01, 0, nthreads, 42, false, false);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (nthreads == 1) base_seconds = elapsed.count();
+        std::cerr << nthreads << "\t" << elapsed.count() << "\t" << base_seconds / elapsed.count() << std::endl;
+        REQUIRE(layout.size() == graph.get_node_count());
+    }
+}
+
+}
+}
@@ -0,0 +1,650 @@
+/**
+ * \file
+ * unittest/sort.cpp: test cases for the graph sorts.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "algorithms/topological_sort.hpp"
+#include "algorithms/sort_metrics.hpp"
+#include "algorithms/pipeline_sort.hpp"
+#include "algorithms/path_locality_sort.hpp"
+#include "algorithms/cycle_breaking_sort.hpp"
+#include "algorithms/eades_algorithm.hpp"
+#include "algorithms/dagify_sort.hpp"
+#include "split_strand_graph.hpp"
+#include "dagified_graph.hpp"
+#include "topology_graph.hpp"
+
+#include <iostream>
+#include <random>
+#include <limits>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <chrono>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+// a random DAG over n nodes whose ids are shuffled, with edges from each node to
+// the next one and to some of the nodes shortly after it, plus some back edges
+static std::vector<std::pair<handle_t, handle_t>> make_random_dag(graph_t& graph, uint64_t n, uint64_t back_edges,
+                                                                  uint64_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint64_t> ids(n);
+    for (uint64_t i = 0; i < n; ++i) ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    for (auto& id : ids) {
+        graph.create_handle("ACGT", id);
+    }
+    std::vector<std::pair<handle_t, handle_t>> edges;
+    auto add_edge = [&](uint64_t i, uint64_t j) {
+        edges.push_back(std::make_pair(graph.get_handle(ids[i]), graph.get_handle(ids[j])));
+        graph.create_edge(edges.back().first, edges.back().second);
+    };
+    for (uint64_t i = 0; i + 1 < n; ++i) {
+        add_edge(i, i + 1);
+        uint64_t j = i + 2 + rng() % 20;
+        if (j < n) add_edge(i, j);
+    }
+    for (uint64_t k = 0; k < back_edges; ++k) {
+        uint64_t i = 1 + rng() % (n - 1);
+        add_edge(i, rng() % i);
+    }
+    return edges;
+}
+
+// a DAG of layers of the given width, with shuffled ids, in which each node has edges to a few nodes
+// of the next layer, so that each frontier of a topological sort holds a whole layer
+static std::vector<std::pair<handle_t, handle_t>> make_wide_dag(graph_t& graph, uint64_t layers, uint64_t width,
+                                                                uint64_t seed) {
+    std::mt19937 rng(seed);
+    uint64_t n = layers * width;
+    std::vector<uint64_t> ids(n);
+    for (uint64_t i = 0; i < n; ++i) ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    for (uint64_t i = 1; i <= n; ++i) {
+        graph.create_handle("ACGT", i);
+    }
+    std::vector<std::pair<handle_t, handle_t>> edges;
+    for (uint64_t l = 0; l + 1 < layers; ++l) {
+        for (uint64_t k = 0; k < width; ++k) {
+            handle_t from = graph.get_handle(ids[l * width + k]);
+            for (uint64_t e = 0; e < 3; ++e) {
+                handle_t to = graph.get_handle(ids[(l + 1) * width + rng() % width]);
+                if (!graph.has_edge(from, to)) {
+                    graph.create_edge(from, to);
+                    edges.push_back(std::make_pair(from, to));
+                }
+            }
+        }
+    }
+    return edges;
+}
+
+// a graph whose paths each walk a backbone of n nodes with shuffled ids, skipping about a quarter of them
+static void make_random_paths(graph_t& graph, uint64_t n, uint64_t path_count, uint64_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint64_t> ids(n);
+    for (uint64_t i = 0; i < n; ++i) ids[i] = i + 1;
+    std::shuffle(ids.begin(), ids.end(), rng);
+    for (uint64_t i = 0; i < n; ++i) {
+        graph.create_handle("ACGT", i + 1);
+    }
+    for (uint64_t p = 0; p < path_count; ++p) {
+        path_handle_t path = graph.create_path_handle("path" + std::to_string(p));
+        handle_t last = graph.get_handle(ids[0]);
+        graph.append_step(path, last);
+        for (uint64_t i = 1; i < n; ++i) {
+            if (rng() % 4 == 0) continue;
+            handle_t curr = graph.get_handle(ids[i]);
+            if (!graph.has_edge(last, curr)) {
+                graph.create_edge(last, curr);
+            }
+            graph.append_step(path, curr);
+            last = curr;
+        }
+    }
+}
+
+static std::vector<uint64_t> order_positions(const graph_t& graph, const std::vector<handle_t>& order) {
+    std::vector<uint64_t> position(graph.get_node_count() + 1, std::numeric_limits<uint64_t>::max());
+    for (uint64_t i = 0; i < order.size(); ++i) {
+        position[graph.get_id(order[i])] = i;
+    }
+    return position;
+}
+
+TEST_CASE("Parallel topological sort gives a topological order of a DAG", "[sort]") {
+    // layers of 4000 nodes, so that the frontiers are processed in parallel
+    graph_t graph;
+    auto edges = make_wide_dag(graph, 10, 4000, 5);
+    std::vector<handle_t> first;
+    for (uint64_t nthreads : { 1, 2, 4 }) {
+        std::vector<handle_t> order = algorithms::parallel_topological_order(&graph, true, false, false, nthreads);
+        REQUIRE(order.size() == graph.get_node_count());
+        auto position = order_positions(graph, order);
+        for (auto& edge : edges) {
+            REQUIRE(position[graph.get_id(edge.first)] < position[graph.get_id(edge.second)]);
+        }
+        if (first.empty()) {
+            first = order;
+        } else {
+            // the order doesn't depend on the number of threads
+            REQUIRE(order == first);
+        }
+    }
+}
+
+TEST_CASE("Parallel topological sort places every node of a cyclic graph once", "[sort]") {
+    // wide layers with inversions, which can make a node ready in both orientations within one frontier,
+    // and back edges, which make the sort break into cycles
+    graph_t graph;
+    make_wide_dag(graph, 10, 4000, 7);
+    std::mt19937 rng(7);
+    for (uint64_t k = 0; k < 4000; ++k) {
+        handle_t from = graph.get_handle(1 + rng() % 40000);
+        nid_t to = 1 + rng() % 40000;
+        graph.create_edge(from, graph.get_handle(to, rng() % 2));
+    }
+    for (bool use_heads : { true, false }) {
+        std::vector<handle_t> first;
+        for (uint64_t nthreads : { 1, 4 }) {
+            std::vector<handle_t> order = algorithms::parallel_topological_order(&graph, use_heads, false, false, nthreads);
+            REQUIRE(order.size() == graph.get_node_count());
+            auto position = order_positions(graph, order);
+            for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+                REQUIRE(position[id] < order.size());
+            }
+            if (first.empty()) {
+                first = order;
+            } else {
+                REQUIRE(order == first);
+            }
+        }
+    }
+}
+
+TEST_CASE("The default topological sort of a pipeline doesn't depend on the number of threads", "[sort]") {
+    graph_t graph;
+    make_random_dag(graph, 5000, 100, 3);
+    std::vector<handle_t> serial = algorithms::topological_order(&graph, true, false, false);
+    algorithms::pipeline_sort_params_t params;
+    for (uint64_t nthreads : { 1, 4 }) {
+        params.num_threads = nthreads;
+        REQUIRE(algorithms::pipeline_sort_order(graph, 's', params) == serial);
+    }
+    // the frontier sort is only used when asked for
+    params.frontier_topological = true;
+    REQUIRE(algorithms::pipeline_sort_order(graph, 's', params)
+            == algorithms::parallel_topological_order(&graph, true, false, false, 1));
+}
+
+TEST_CASE("Chunked breadth and depth first sorts place every node once", "[sort]") {
+    // many small components, some with cycles, so the sorts reseed often
+    graph_t graph;
+    std::mt19937 rng(19);
+    for (uint64_t c = 0; c < 200; ++c) {
+        std::vector<handle_t> handles;
+        for (uint64_t i = 0; i < 50; ++i) {
+            handles.push_back(graph.create_handle(std::string(1 + rng() % 20, 'A')));
+        }
+        for (uint64_t i = 0; i + 1 < handles.size(); ++i) {
+            graph.create_edge(handles[i], handles[i + 1]);
+            uint64_t j = i + 2 + rng() % 5;
+            if (j < handles.size()) graph.create_edge(handles[i], rng() % 5 ? handles[j] : graph.flip(handles[j]));
+        }
+        graph.create_edge(handles.back(), handles[rng() % handles.size()]);
+    }
+    for (uint64_t chunk_size : { std::numeric_limits<uint64_t>::max(), (uint64_t)1000, (uint64_t)10 }) {
+        std::vector<handle_t> bfs_order;
+        for (uint64_t nthreads : { 1, 4 }) {
+            std::vector<handle_t> order = algorithms::breadth_first_topological_order(graph, chunk_size, true, false, nthreads);
+            REQUIRE(order.size() == graph.get_node_count());
+            auto position = order_positions(graph, order);
+            for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+                REQUIRE(position[id] < order.size());
+            }
+            if (bfs_order.empty()) {
+                bfs_order = order;
+            } else {
+                REQUIRE(order == bfs_order);
+            }
+        }
+        std::vector<handle_t> order = algorithms::depth_first_topological_order(graph, chunk_size);
+        REQUIRE(order.size() == graph.get_node_count());
+        auto position = order_positions(graph, order);
+        for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+            REQUIRE(position[id] < order.size());
+        }
+    }
+}
+
+TEST_CASE("Cycle breaking sort in parallel keeps strongly connected components in condensation order", "[sort]") {
+    // a chain of cycles, each one strongly connected component, written in shuffled id order
+    graph_t graph;
+    std::mt19937 rng(23);
+    const uint64_t cycles = 50;
+    const uint64_t cycle_length = 30;
+    std::vector<uint64_t> cycle_of(cycles * cycle_length);
+    for (uint64_t i = 0; i < cycle_of.size(); ++i) {
+        cycle_of[i] = i / cycle_length;
+    }
+    std::shuffle(cycle_of.begin(), cycle_of.end(), rng);
+    std::vector<std::vector<handle_t>> members(cycles);
+    for (auto& c : cycle_of) {
+        members[c].push_back(graph.create_handle("A"));
+    }
+    for (uint64_t c = 0; c < cycles; ++c) {
+        auto& m = members[c];
+        for (uint64_t i = 0; i < m.size(); ++i) {
+            graph.create_edge(m[i], m[(i + 1) % m.size()]);
+        }
+        if (c + 1 < cycles) {
+            graph.create_edge(m[rng() % m.size()], members[c + 1][rng() % m.size()]);
+        }
+    }
+    std::vector<uint64_t> cycle_of_id(graph.get_node_count() + 1);
+    for (uint64_t c = 0; c < cycles; ++c) {
+        for (auto& handle : members[c]) {
+            cycle_of_id[graph.get_id(handle)] = c;
+        }
+    }
+    for (uint64_t nthreads : { 1, 4 }) {
+        std::vector<handle_t> order = algorithms::cycle_breaking_sort(graph, nthreads);
+        REQUIRE(order.size() == graph.get_node_count());
+        auto position = order_positions(graph, order);
+        for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+            REQUIRE(position[id] < order.size());
+        }
+        if (nthreads > 1) {
+            for (uint64_t i = 0; i < order.size(); ++i) {
+                REQUIRE(cycle_of_id[graph.get_id(order[i])] == i / cycle_length);
+            }
+        }
+    }
+}
+
+TEST_CASE("Cycle breaking sort on one thread gives the orders of the original implementation", "[sort]") {
+    // each graph as its node count and its edges (from, from is reverse, to, to is reverse),
+    // with the order the original implementation, which sorted nodes by their dfs keys, gave for it
+    struct golden_t {
+        uint64_t node_count;
+        std::vector<std::tuple<nid_t, bool, nid_t, bool>> edges;
+        std::vector<nid_t> order;
+    };
+    std::vector<golden_t> goldens = {
+        // two nested cycles, and one closed from the end back to the middle
+        { 8, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, false), std::make_tuple(3, false, 1, false),
+               std::make_tuple(3, false, 4, false), std::make_tuple(4, false, 5, false), std::make_tuple(5, false, 6, false),
+               std::make_tuple(6, false, 4, false), std::make_tuple(6, false, 7, false), std::make_tuple(2, false, 7, false),
+               std::make_tuple(7, false, 8, false), std::make_tuple(8, false, 2, false) },
+          { 4, 5, 6, 7, 8, 2, 3, 1 } },
+        // two cycles, joined by a path and a shortcut
+        { 7, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, false), std::make_tuple(3, false, 4, false),
+               std::make_tuple(4, false, 2, false), std::make_tuple(4, false, 5, false), std::make_tuple(5, false, 6, false),
+               std::make_tuple(6, false, 5, false), std::make_tuple(6, false, 7, false), std::make_tuple(1, false, 5, false) },
+          { 1, 3, 4, 2, 6, 5, 7 } },
+        // a cycle through an inversion, and another one closed by an inversion
+        { 6, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, true), std::make_tuple(3, true, 4, false),
+               std::make_tuple(4, false, 1, false), std::make_tuple(5, false, 2, false), std::make_tuple(4, false, 6, false),
+               std::make_tuple(6, false, 5, true) },
+          { 2, 3, 4, 1, 6, 5 } },
+        // cycles through the reverse strands, with ids out of order along them
+        { 7, { std::make_tuple(3, false, 1, false), std::make_tuple(1, false, 5, false), std::make_tuple(5, false, 3, false),
+               std::make_tuple(5, false, 2, true), std::make_tuple(2, true, 7, false), std::make_tuple(7, false, 6, false),
+               std::make_tuple(6, false, 2, true), std::make_tuple(4, false, 6, false), std::make_tuple(7, true, 4, true) },
+          { 5, 3, 1, 7, 6, 2, 4 } },
+    };
+    for (auto& golden : goldens) {
+        graph_t graph;
+        for (nid_t id = 1; id <= golden.node_count; ++id) {
+            graph.create_handle("A", id);
+        }
+        for (auto& edge : golden.edges) {
+            graph.create_edge(graph.get_handle(std::get<0>(edge), std::get<1>(edge)),
+                              graph.get_handle(std::get<2>(edge), std::get<3>(edge)));
+        }
+        std::vector<handle_t> order = algorithms::cycle_breaking_sort(graph, 1);
+        REQUIRE(order.size() == golden.order.size());
+        for (uint64_t i = 0; i < order.size(); ++i) {
+            REQUIRE(graph.get_id(order[i]) == golden.order[i]);
+            REQUIRE(!graph.get_is_reverse(order[i]));
+        }
+    }
+}
+
+TEST_CASE("Eades algorithm lays out a DAG forward and places every node of a cyclic graph once", "[sort]") {
+    for (uint64_t back_edges : { 0, 500 }) {
+        graph_t graph;
+        auto edges = make_random_dag(graph, 5000, back_edges, 29);
+        std::vector<handle_t> order = algorithms::eades_algorithm(&graph);
+        REQUIRE(order.size() == graph.get_node_count());
+        auto position = order_positions(graph, order);
+        for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+            REQUIRE(position[id] < order.size());
+        }
+        if (back_edges == 0) {
+            for (auto& edge : edges) {
+                REQUIRE(position[graph.get_id(edge.first)] < position[graph.get_id(edge.second)]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Eades algorithm gives the orders of the original implementation", "[sort]") {
+    // each graph as its node count and its edges (from, from is reverse, to, to is reverse),
+    // with the order the original list-based implementation gave for it
+    struct golden_t {
+        uint64_t node_count;
+        std::vector<std::tuple<nid_t, bool, nid_t, bool>> edges;
+        std::vector<nid_t> order;
+    };
+    std::vector<golden_t> goldens = {
+        // a DAG with branches
+        { 8, { std::make_tuple(1, false, 2, false), std::make_tuple(1, false, 3, false), std::make_tuple(2, false, 4, false),
+               std::make_tuple(3, false, 4, false), std::make_tuple(4, false, 5, false), std::make_tuple(2, false, 6, false),
+               std::make_tuple(6, false, 5, false), std::make_tuple(5, false, 7, false), std::make_tuple(7, false, 8, false),
+               std::make_tuple(3, false, 8, false) },
+          { 1, 3, 2, 6, 4, 5, 7, 8 } },
+        // two cycles, joined by a path and a shortcut
+        { 7, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, false), std::make_tuple(3, false, 4, false),
+               std::make_tuple(4, false, 2, false), std::make_tuple(4, false, 5, false), std::make_tuple(5, false, 6, false),
+               std::make_tuple(6, false, 5, false), std::make_tuple(6, false, 7, false), std::make_tuple(1, false, 5, false) },
+          { 1, 3, 4, 6, 5, 2, 7 } },
+        // a cycle through an inversion, and another one closed by an inversion
+        { 6, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, true), std::make_tuple(3, true, 4, false),
+               std::make_tuple(4, false, 1, false), std::make_tuple(5, false, 2, false), std::make_tuple(4, false, 6, false),
+               std::make_tuple(6, false, 5, true) },
+          { 5, 1, 2, 3, 6, 4 } },
+    };
+    for (auto& golden : goldens) {
+        graph_t graph;
+        for (nid_t id = 1; id <= golden.node_count; ++id) {
+            graph.create_handle("A", id);
+        }
+        for (auto& edge : golden.edges) {
+            graph.create_edge(graph.get_handle(std::get<0>(edge), std::get<1>(edge)),
+                              graph.get_handle(std::get<2>(edge), std::get<3>(edge)));
+        }
+        std::vector<handle_t> order = algorithms::eades_algorithm(&graph);
+        REQUIRE(order.size() == golden.order.size());
+        for (uint64_t i = 0; i < order.size(); ++i) {
+            REQUIRE(graph.get_id(order[i]) == golden.order[i]);
+            REQUIRE(!graph.get_is_reverse(order[i]));
+        }
+    }
+}
+
+TEST_CASE("Dagify sort unrolls the cycles of strand split views of the graph", "[sort]") {
+    graph_t graph;
+    auto edges = make_random_dag(graph, 2000, 200, 31);
+    // and some inversions, which the strand split view turns into edges between strands
+    std::mt19937 rng(31);
+    for (uint64_t k = 0; k < 50; ++k) {
+        graph.create_edge(graph.get_handle(1 + rng() % 2000), graph.get_handle(1 + rng() % 2000, true));
+    }
+    split_strand_graph_t split(&graph);
+    REQUIRE(split.get_node_count() == 2 * graph.get_node_count());
+    dagified_graph_t dag(&split, 1);
+    // every edge of the view joins forward handles, and removing sources empties it, so it's acyclic
+    std::vector<uint64_t> in_degree(dag.get_node_count(), 0);
+    dag.for_each_handle([&](const handle_t& handle) {
+            dag.follow_edges(handle, false, [&](const handle_t& next) {
+                    REQUIRE(!dag.get_is_reverse(next));
+                    ++in_degree[dag.get_id(next) - 1];
+                });
+        });
+    std::vector<handle_t> sources;
+    for (uint64_t i = 0; i < in_degree.size(); ++i) {
+        if (in_degree[i] == 0) sources.push_back(dag.get_handle(i + 1));
+    }
+    uint64_t removed = 0;
+    while (!sources.empty()) {
+        handle_t handle = sources.back();
+        sources.pop_back();
+        ++removed;
+        dag.follow_edges(handle, false, [&](const handle_t& next) {
+                if (--in_degree[dag.get_id(next) - 1] == 0) sources.push_back(next);
+            });
+    }
+    REQUIRE(removed == dag.get_node_count());
+    std::vector<handle_t> order = algorithms::dagify_sort(graph);
+    REQUIRE(order.size() == graph.get_node_count());
+    auto position = order_positions(graph, order);
+    for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+        REQUIRE(position[id] < order.size());
+    }
+}
+
+TEST_CASE("Dagified views stop copying cycles of zero-length nodes", "[sort]") {
+    // a cycle of zero-length nodes, which paths cross for free, leading into cycles of length 1 and 2
+    topology_graph_t graph;
+    uint64_t lengths[] = { 0, 0, 0, 0, 1, 0, 2, 0 };
+    for (nid_t id = 1; id <= 8; ++id) {
+        graph.add_node(id, nullptr, lengths[id - 1]);
+    }
+    for (auto& edge : std::vector<std::pair<nid_t, nid_t>>{ { 1, 2 }, { 2, 3 }, { 3, 1 }, { 3, 4 },
+                                                              { 4, 5 }, { 5, 6 }, { 6, 4 }, { 6, 7 },
+                                                              { 7, 8 }, { 8, 7 } }) {
+        graph.add_edge(edge.first, false, edge.second, false);
+    }
+    graph.index();
+    dagified_graph_t dag(&graph, 100);
+    std::vector<uint64_t> copies(9, 0);
+    dag.for_each_handle([&](const handle_t& handle) {
+            ++copies[graph.get_id(dag.get_underlying_handle(handle))];
+        });
+    // the zero-length cycle is copied until the distance across the copies stalls for as many copies as it has nodes
+    REQUIRE(copies[1] == 4);
+    // and the others as many times as they need to preserve paths of length 100
+    REQUIRE(copies[4] == 101);
+    REQUIRE(copies[7] == 51);
+}
+
+TEST_CASE("Dagify sort gives fixed orders on small cyclic graphs", "[sort]") {
+    // each graph as its node count and its edges (from, from is reverse, to, to is reverse),
+    // with the order the sort gives over the dagified view, which lays each component out
+    // in the reverse of the order a depth first search finishes it
+    struct golden_t {
+        uint64_t node_count;
+        std::vector<std::tuple<nid_t, bool, nid_t, bool>> edges;
+        std::vector<nid_t> order;
+    };
+    std::vector<golden_t> goldens = {
+        // two cycles, joined by a path and a shortcut
+        { 7, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, false), std::make_tuple(3, false, 4, false),
+               std::make_tuple(4, false, 2, false), std::make_tuple(4, false, 5, false), std::make_tuple(5, false, 6, false),
+               std::make_tuple(6, false, 5, false), std::make_tuple(6, false, 7, false), std::make_tuple(1, false, 5, false) },
+          { 1, 2, 3, 4, 5, 6, 7 } },
+        // a cycle whose ids are out of order along it, entered and left in the middle
+        { 7, { std::make_tuple(6, false, 2, false), std::make_tuple(1, false, 4, false), std::make_tuple(4, false, 2, false),
+               std::make_tuple(2, false, 5, false), std::make_tuple(5, false, 3, false), std::make_tuple(3, false, 1, false),
+               std::make_tuple(3, false, 7, false) },
+          { 6, 1, 4, 2, 5, 3, 7 } },
+        // a cycle with a bubble in it, leading into a cycle of two nodes
+        { 8, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, false), std::make_tuple(2, false, 4, false),
+               std::make_tuple(3, false, 5, false), std::make_tuple(4, false, 5, false), std::make_tuple(5, false, 2, false),
+               std::make_tuple(5, false, 6, false), std::make_tuple(6, false, 7, false), std::make_tuple(7, false, 6, false),
+               std::make_tuple(7, false, 8, false), std::make_tuple(3, false, 7, false) },
+          { 1, 2, 4, 3, 5, 6, 7, 8 } },
+        // a cycle through an inversion, and another one closed by an inversion
+        { 6, { std::make_tuple(1, false, 2, false), std::make_tuple(2, false, 3, true), std::make_tuple(3, true, 4, false),
+               std::make_tuple(4, false, 1, false), std::make_tuple(5, false, 2, false), std::make_tuple(4, false, 6, false),
+               std::make_tuple(6, false, 5, true) },
+          { 5, 1, 2, 4, 6, 3 } },
+    };
+    for (auto& golden : goldens) {
+        graph_t graph;
+        for (nid_t id = 1; id <= golden.node_count; ++id) {
+            graph.create_handle("A", id);
+        }
+        for (auto& edge : golden.edges) {
+            graph.create_edge(graph.get_handle(std::get<0>(edge), std::get<1>(edge)),
+                              graph.get_handle(std::get<2>(edge), std::get<3>(edge)));
+        }
+        std::vector<handle_t> order = algorithms::dagify_sort(graph);
+        REQUIRE(order.size() == golden.order.size());
+        for (uint64_t i = 0; i < order.size(); ++i) {
+            REQUIRE(graph.get_id(order[i]) == golden.order[i]);
+            REQUIRE(!graph.get_is_reverse(order[i]));
+        }
+    }
+}
+
+TEST_CASE("Sort pipelines compose their orders as if the graph were rebuilt after each sort", "[sort]") {
+    algorithms::pipeline_sort_params_t params;
+    // the breadth and depth first sorts depend on the order in which each node lists its edges,
+    // which the graph changes when it's rebuilt, and the back edges make the topological sort break cycles
+    for (std::string pipeline : { "sf", "bs", "sz", "bsz", "zbs" }) {
+        graph_t graph;
+        make_random_dag(graph, 2000, 10, 11);
+        std::vector<handle_t> composed = algorithms::pipeline_sort_order(graph, pipeline, params);
+        REQUIRE(composed.size() == graph.get_node_count());
+        std::vector<nid_t> composed_ids;
+        for (auto& handle : composed) {
+            composed_ids.push_back(graph.get_id(handle));
+        }
+        // the same sorts, rebuilding the graph after each one, keeping track of the input ids
+        graph_t rebuilt;
+        make_random_dag(rebuilt, 2000, 10, 11);
+        std::vector<nid_t> input_ids(rebuilt.get_node_count());
+        for (uint64_t i = 0; i < input_ids.size(); ++i) {
+            input_ids[i] = i + 1;
+        }
+        for (auto& sort : pipeline) {
+            std::vector<handle_t> order = algorithms::pipeline_sort_order(rebuilt, sort, params);
+            std::vector<nid_t> ordered_ids;
+            for (auto& handle : order) {
+                ordered_ids.push_back(input_ids[rebuilt.get_id(handle) - 1]);
+            }
+            rebuilt.apply_ordering(order, true);
+            input_ids.swap(ordered_ids);
+        }
+        REQUIRE(composed_ids == input_ids);
+    }
+    SECTION("each stage sees the graph sorted so far") {
+        graph_t graph;
+        make_random_dag(graph, 2000, 10, 11);
+        std::vector<uint64_t> stages;
+        algorithms::pipeline_sort_order(graph, std::string("bsz"), params,
+                                        [&](const PathHandleGraph& sorted, uint64_t stage) {
+                                            REQUIRE(sorted.get_node_count() == graph.get_node_count());
+                                            stages.push_back(stage);
+                                        });
+        REQUIRE(stages == std::vector<uint64_t>({ 0, 1, 2 }));
+    }
+}
+
+TEST_CASE("Path locality sort shortens the steps of the paths", "[sort]") {
+    graph_t graph;
+    make_random_paths(graph, 5000, 5, 13);
+    algorithms::pipeline_sort_params_t params;
+    std::vector<handle_t> input;
+    graph.for_each_handle([&](const handle_t& handle) { input.push_back(handle); });
+    std::vector<handle_t> sorted = algorithms::pipeline_sort_order(graph, 's', params);
+    std::vector<handle_t> refined = algorithms::path_locality_order(graph, 10, 2, false);
+    REQUIRE(refined.size() == graph.get_node_count());
+    auto position = order_positions(graph, refined);
+    for (uint64_t id = 1; id <= graph.get_node_count(); ++id) {
+        REQUIRE(position[id] < refined.size());
+    }
+    REQUIRE(algorithms::path_step_distance(graph, refined) < algorithms::path_step_distance(graph, input));
+    SECTION("it doesn't lengthen the steps of an order it refines") {
+        graph.apply_ordering(sorted, true);
+        std::vector<handle_t> before;
+        graph.for_each_handle([&](const handle_t& handle) { before.push_back(handle); });
+        std::vector<handle_t> after = algorithms::path_locality_order(graph, 10, 2, false);
+        REQUIRE(algorithms::path_step_distance(graph, after) <= algorithms::path_step_distance(graph, before));
+        // and it gives the same order with any number of threads
+        REQUIRE(algorithms::path_locality_order(graph, 10, 1, false) == after);
+    }
+}
+
+TEST_CASE("Path iteration after path locality sort", "[.benchmark][sort]") {
+    graph_t graph;
+    make_random_paths(graph, 200000, 20, 17);
+    algorithms::pipeline_sort_params_t params;
+    params.num_threads = 4;
+    auto walk_paths = [&](void) {
+        // touch each step's node, as bin, viz and the XP index do
+        auto start = std::chrono::steady_clock::now();
+        uint64_t total = 0;
+        for (uint64_t k = 0; k < 5; ++k) {
+            graph.for_each_path_handle([&](const path_handle_t& path) {
+                    graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+                            total += graph.get_length(graph.get_handle_of_step(step));
+                        });
+                });
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        REQUIRE(total > 0);
+        return seconds;
+    };
+    std::cerr << "input order: " << walk_paths() << "s to walk the paths 5 times" << std::endl;
+    for (std::string pipeline : { "s", "sl" }) {
+        auto start = std::chrono::steady_clock::now();
+        graph.apply_ordering(algorithms::pipeline_sort_order(graph, pipeline, params), true);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto metrics = algorithms::sort_metrics(graph, 4);
+        std::cerr << "after " << pipeline << " (" << seconds << "s): " << walk_paths()
+                  << "s to walk the paths 5 times, mean path jump " << metrics.mean_path_jump << std::endl;
+    }
+}
+
+TEST_CASE("Sort metrics of a path through a chain", "[sort]") {
+    graph_t graph;
+    std::vector<handle_t> handles;
+    for (uint64_t id = 1; id <= 5; ++id) {
+        handles.push_back(graph.create_handle("ACGT", id));
+    }
+    path_handle_t path = graph.create_path_handle("p");
+    for (uint64_t i = 0; i + 1 < handles.size(); ++i) {
+        graph.create_edge(handles[i], handles[i + 1]);
+    }
+    SECTION("a path following the ids has no jumps") {
+        for (auto& handle : handles) {
+            graph.append_step(path, handle);
+        }
+        auto metrics = algorithms::sort_metrics(graph, 2);
+        REQUIRE(metrics.edge_count == 4);
+        REQUIRE(metrics.mean_edge_delta == 1);
+        REQUIRE(metrics.max_edge_delta == 1);
+        REQUIRE(metrics.path_steps == 5);
+        REQUIRE(metrics.backward_steps == 0);
+        REQUIRE(metrics.path_jumps == 0);
+        REQUIRE(metrics.path_stress == 0);
+    }
+    SECTION("a path going back counts backward steps and jumps") {
+        graph.create_edge(handles[4], handles[0]);
+        for (auto& handle : handles) {
+            graph.append_step(path, handle);
+        }
+        graph.append_step(path, handles[0]);
+        auto metrics = algorithms::sort_metrics(graph, 2);
+        REQUIRE(metrics.edge_count == 5);
+        REQUIRE(metrics.max_edge_delta == 4);
+        REQUIRE(metrics.backward_steps == 1);
+        REQUIRE(metrics.path_jumps == 1);
+        REQUIRE(metrics.mean_path_jump == 8.0 / 5);
+    }
+    SECTION("self loops count once, on either side") {
+        // from the right side back to itself, from the right side to the reverse strand, and from the left side
+        graph.create_edge(handles[1], handles[1]);
+        graph.create_edge(handles[2], graph.flip(handles[2]));
+        graph.create_edge(graph.flip(handles[3]), handles[3]);
+        auto metrics = algorithms::sort_metrics(graph, 2);
+        REQUIRE(metrics.edge_count == 7);
+        REQUIRE(metrics.mean_edge_delta == 4.0 / 7);
+        REQUIRE(metrics.max_edge_delta == 1);
+    }
+}
+
+}
+}